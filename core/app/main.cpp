@@ -2,20 +2,31 @@
 #include <boost/beast.hpp>
 #include <boost/beast/core/tcp_stream.hpp>
 #include <boost/json.hpp>
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
 #include <boost/log/trivial.hpp>
-#include <boost/program_options.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <exception>
+#include <future>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "config.hpp"
 #include "database.hpp"
 #include "database_iface.hpp"
+#include "routing.hpp"
+#include "sharding.hpp"
 #include "game_store.hpp"
+#include "handoff.hpp"
 #include "server.hpp"
 
 namespace asio = boost::asio;
@@ -27,43 +38,146 @@ using tcp = asio::ip::tcp;
  * @return int Код завершения
  */
 int main(int argc, char *argv[]) {
-  namespace po = boost::program_options;
+  auto started = std::chrono::steady_clock::now();
   try {
     BOOST_LOG_TRIVIAL(info) << "[MAIN] Запуск приложения..." << std::endl;
-    // Define command line options
-    po::options_description desc("Allowed options");
-    desc.add_options()("help,h", "Show help message")(
-        "host", po::value<std::string>()->default_value("127.0.0.1"),
-        "Server host address")(
-        "port", po::value<boost::asio::ip::port_type>()->default_value(8080),
-        "Server port number");
-
-    // Parse command line
-    po::variables_map vm;
-    po::store(po::parse_command_line(argc, argv, desc), vm);
-    po::notify(vm);
+    core::Config config(argc, argv);
 
     // Handle help option
-    if (vm.count("help")) {
-      BOOST_LOG_TRIVIAL(info) << desc << std::endl;
+    if (config.help()) {
+      BOOST_LOG_TRIVIAL(info) << config.description() << std::endl;
       return EXIT_SUCCESS;
     }
+    boost::log::core::get()->set_filter(boost::log::trivial::severity >=
+                                        config.logLevel());
 
-    auto host = vm["host"].as<std::string>();
-    auto port = vm["port"].as<boost::asio::ip::port_type>();
+    auto host = config.get<std::string>("host");
+    auto port = config.get<uint16_t>("port");
 
     BOOST_LOG_TRIVIAL(info) << "[MAIN] Параметры запуска: host=" << host
                             << ", port=" << port << std::endl;
 
-    std::shared_ptr<database::AbstractDatabase> db =
-        std::make_shared<database::Database>(
-            /*databaseName*/ "road_n_roll", /*userName*/ "joe",
-            /*dbPassword*/ "12345678", /*host*/ "localhost",
-            /*port*/ 5432);
-    std::shared_ptr<core::AbstractServer> server =
-        std::make_shared<core::CoreServer>();
-    core::GameStore games(db);
+    auto connect = [&config](std::string host, uint port) {
+      return std::make_shared<database::Database>(
+          config.get<std::string>("db-name"),
+          config.get<std::string>("db-user"),
+          config.get<std::string>("db-password"), std::move(host), port,
+          std::chrono::milliseconds(
+              config.get<int64_t>("db-statement-timeout-ms")));
+    };
+    // "host:port" из --replica и --shard
+    auto connectTo = [&connect](const std::string &address) {
+      auto colon = address.rfind(':');
+      if (colon == std::string::npos) {
+        throw std::invalid_argument("expected host:port: " + address);
+      }
+      return connect(address.substr(0, colon),
+                     std::stoul(address.substr(colon + 1)));
+    };
+    // Соединения устанавливаются параллельно: старт не ждёт их по очереди
+    auto connectAll = [&connectTo](const std::vector<std::string> &addresses) {
+      std::vector<std::future<std::shared_ptr<database::Database>>> pending;
+      for (auto &&address : addresses) {
+        pending.push_back(std::async(std::launch::async, [&connectTo, &address] {
+          return connectTo(address);
+        }));
+      }
+      std::vector<std::shared_ptr<database::Database>> connections;
+      for (auto &&future : pending) {
+        connections.push_back(future.get());
+      }
+      return connections;
+    };
+    std::shared_ptr<database::AbstractDatabase> db;
+    if (auto addresses = config.get<std::vector<std::string>>("shard");
+        !addresses.empty()) {
+      if (!config.get<std::vector<std::string>>("replica").empty()) {
+        throw std::invalid_argument("--replica cannot be used with --shard");
+      }
+      auto connections = connectAll(addresses);
+      std::vector<database::ShardedDatabase::Shard> shards;
+      for (size_t idx = 0; idx < addresses.size(); ++idx) {
+        shards.push_back({.name = addresses[idx], .db = connections[idx]});
+      }
+      BOOST_LOG_TRIVIAL(info) << "[MAIN] Игры разложены по шардам: "
+                              << shards.size() << std::endl;
+      db = std::make_shared<database::ShardedDatabase>(std::move(shards));
+    } else {
+      db = connect(config.get<std::string>("db-host"),
+                   config.get<uint16_t>("db-port"));
+    }
+    if (auto addresses = config.get<std::vector<std::string>>("replica");
+        !addresses.empty()) {
+      std::vector<std::shared_ptr<database::AbstractDatabase>> replicas;
+      for (auto &&replica : connectAll(addresses)) {
+        replicas.push_back(std::move(replica));
+      }
+      BOOST_LOG_TRIVIAL(info) << "[MAIN] Чтение с реплик: " << replicas.size()
+                              << std::endl;
+      db = std::make_shared<database::RoutingDatabase>(
+          db, std::move(replicas),
+          database::RoutingDatabase::Options{
+              .maxLag = std::chrono::milliseconds(
+                  config.get<int64_t>("replica-max-lag-ms"))});
+    }
+    auto coreServer = std::make_shared<core::CoreServer>();
+    coreServer->configure(config.server());
+    // Перезагружаемые ключи; остальные требуют перезапуска
+    coreServer->onReload([&config, &coreServer] {
+      config.reload();
+      auto settings = config.server();
+      auto level = config.logLevel();
+      coreServer->configure(settings);
+      boost::log::core::get()->set_filter(boost::log::trivial::severity >=
+                                          level);
+      BOOST_LOG_TRIVIAL(info) << "[MAIN] Конфигурация применена." << std::endl;
+    });
+    if (auto path = config.get<std::string>("handoff-socket");
+        !path.empty()) {
+      if (auto handoff = core::ListenerHandoff::take(path); handoff) {
+        // Журнал и база станут согласованными, когда предшественник
+        // доработает запросы и сбросит записи
+        BOOST_LOG_TRIVIAL(info)
+            << "[MAIN] Жду завершения предыдущего процесса..." << std::endl;
+        handoff->waitForPredecessor();
+        coreServer->inherit(handoff->listener());
+      }
+      coreServer->handoffAt(path);
+    }
+    std::shared_ptr<core::AbstractServer> server = coreServer;
+    // Записи игр группируются в транзакции внутри GameStore
+    core::GameStore games(db,
+                          std::chrono::microseconds(
+                              config.get<int64_t>("group-commit-window-us")),
+                          config.get<size_t>("group-commit-batch"));
+    coreServer->onShutdown([&games] { games.flush(); });
+    if (auto walDir = config.get<std::string>("wal-dir"); !walDir.empty()) {
+      // Журнал переигрывается до того, как сервер начнёт принимать запросы
+      games.recover({.directory = walDir,
+                     .shards = config.get<size_t>("wal-shards"),
+                     .segmentBytes = config.get<size_t>("wal-segment-mb")
+                                     << 20});
+    }
+    games.rebuildLeaderboard();
     games.attachTo(server);
+    // Прогрев идёт, пока сервер уже отвечает на /healthz; балансировщик
+    // пустит трафик, когда /readyz ответит 200
+    std::jthread warmUp([&games, &coreServer, started] {
+      try {
+        games.warmUp();
+        coreServer->ready();
+        BOOST_LOG_TRIVIAL(info)
+            << "[MAIN] Готов к работе через "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - started)
+                   .count()
+            << " мс после запуска" << std::endl;
+      } catch (const std::exception &e) {
+        // /readyz так и ответит 503: оркестратор перезапустит процесс
+        BOOST_LOG_TRIVIAL(error)
+            << "[MAIN] Прогрев не удался: " << e.what() << std::endl;
+      }
+    });
     server->run({asio::ip::make_address(host), port});
   } catch (const std::exception &e) {
     BOOST_LOG_TRIVIAL(fatal) << "[MAIN] Ошибка: " << e.what() << std::endl;
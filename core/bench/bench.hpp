@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+
+/**
+ * @brief Минимальный каркас микробенчмарков без внешних зависимостей.
+ */
+namespace bench {
+// Не даёт компилятору выбросить вычисленное значение
+template <typename T> void doNotOptimize(T const &value) {
+#if defined(_MSC_VER)
+  static const void *volatile sink;
+  sink = &value;
+#else
+  asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+/**
+ * @brief Запускает @p fn @p iterations раз и печатает время на итерацию
+ *
+ * @return Наносекунды на одну итерацию
+ */
+template <typename Fn>
+double measure(std::string_view name, std::size_t iterations, Fn &&fn) {
+  // Прогрев кэшей и ленивой инициализации
+  for (std::size_t i = 0; i < iterations / 10 + 1; ++i) {
+    fn();
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < iterations; ++i) {
+    fn();
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start);
+  double perIteration = elapsed.count() / double(iterations);
+  std::cout << std::left << std::setw(48) << name << std::right
+            << std::setw(12) << std::fixed << std::setprecision(1)
+            << perIteration << " ns/op" << std::endl;
+  return perIteration;
+}
+} // namespace bench
@@ -0,0 +1,127 @@
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "server.hpp"
+
+/**
+ * Нагрузка на CoreServer по loopback: keep-alive соединения шлют
+ * GET /ping друг за другом, сервер проходит обычный путь сессии
+ * (разбор, лимиты, admission, маршрутизация, запись ответа).
+ *
+ * Сравнение backend: соберите бенчмарк с -DCORE_USE_IO_URING=ON и без
+ * него и запустите с одинаковыми параметрами:
+ *   HttpBench [port] [connections] [seconds]
+ *
+ * Это сравнение ещё не проводилось: пока его результатов нет,
+ * CORE_USE_IO_URING остаётся экспериментальной опцией.
+ */
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Stats {
+  size_t errors = 0;
+  // Задержки запросов в микросекундах
+  std::vector<uint32_t> latencies;
+};
+
+asio::awaitable<void> client(tcp::endpoint endpoint, Clock::time_point until,
+                             Stats &stats) {
+  beast::tcp_stream stream(co_await asio::this_coro::executor);
+  co_await stream.async_connect(endpoint, asio::use_awaitable);
+  http::request<http::empty_body> req{http::verb::get, "/ping", 11};
+  req.set(http::field::host, "localhost");
+  req.keep_alive(true);
+  beast::flat_buffer buffer;
+  while (Clock::now() < until) {
+    auto start = Clock::now();
+    co_await http::async_write(stream, req, asio::use_awaitable);
+    http::response<http::string_body> res;
+    co_await http::async_read(stream, buffer, res, asio::use_awaitable);
+    if (res.result() != http::status::ok) {
+      ++stats.errors;
+    }
+    stats.latencies.push_back(static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                              start)
+            .count()));
+  }
+  beast::error_code ec;
+  stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  auto port = static_cast<asio::ip::port_type>(
+      argc > 1 ? std::atoi(argv[1]) : 18080);
+  size_t connections = argc > 2 ? std::atoi(argv[2]) : 64;
+  auto duration = std::chrono::seconds(argc > 3 ? std::atoi(argv[3]) : 10);
+  tcp::endpoint endpoint(asio::ip::make_address("127.0.0.1"), port);
+
+  auto server = std::make_shared<core::CoreServer>();
+  // Меряем транспорт, а не отказы admission control
+  server->admission({.maxLimit = connections,
+                     .initialLimit = connections,
+                     .queueSize = connections});
+  server->get("/ping", [](const core::CoreServer::Request &req, const auto &)
+                  -> std::optional<core::CoreServer::Response> {
+    core::CoreServer::Response res{http::status::ok, req.version()};
+    res.set(http::field::content_type, "application/json");
+    res.body() = R"({"pong":true})";
+    res.prepare_payload();
+    return res;
+  });
+  std::thread serverThread([&] { server->run(endpoint); });
+  // Даём серверу открыть сокет
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  asio::io_context ioc;
+  std::vector<Stats> stats(connections);
+  auto until = Clock::now() + duration;
+  for (auto &&entry : stats) {
+    asio::co_spawn(ioc, client(endpoint, until, entry),
+                   [](std::exception_ptr ep) {
+                     if (ep) {
+                       std::rethrow_exception(ep);
+                     }
+                   });
+  }
+  auto start = Clock::now();
+  ioc.run();
+  auto elapsed =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  std::raise(SIGTERM);
+  serverThread.join();
+
+  std::vector<uint32_t> latencies;
+  size_t errors = 0;
+  for (auto &&entry : stats) {
+    latencies.insert(latencies.end(), entry.latencies.begin(),
+                     entry.latencies.end());
+    errors += entry.errors;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    return latencies.empty()
+               ? 0
+               : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+  };
+  std::cout << std::fixed << std::setprecision(1)
+            << "backend:      " << core::CoreServer::backend() << '\n'
+            << "connections:  " << connections << '\n'
+            << "requests/s:   " << double(latencies.size()) / elapsed << '\n'
+            << "p50 latency:  " << percentile(0.5) << " us\n"
+            << "p99 latency:  " << percentile(0.99) << " us\n"
+            << "errors:       " << errors << std::endl;
+  return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
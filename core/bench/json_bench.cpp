@@ -0,0 +1,63 @@
+#include <boost/json.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "ids.hpp"
+#include "json_writer.hpp"
+
+namespace json = boost::json;
+
+namespace {
+// Как GET /games делал раньше: DOM из объектов и сериализация в новую строку
+std::string serializeDom(const std::vector<boost::uuids::uuid> &games) {
+  json::object response;
+  json::array gameList;
+  for (auto &&uuid : games) {
+    json::object entry{{"url", "/games/" + boost::uuids::to_string(uuid)}};
+    gameList.push_back(std::move(entry));
+  }
+  response["games"] = std::move(gameList);
+  return json::serialize(response);
+}
+
+std::string serializeStreaming(const std::vector<boost::uuids::uuid> &games) {
+  std::string body;
+  body.reserve(56 * (games.size() + 1));
+  core::JsonWriter writer(body);
+  writer.beginObject().key("games").beginArray();
+  std::string url;
+  for (auto &&uuid : games) {
+    url.assign("/games/");
+    ids::appendTo(url, uuid);
+    writer.beginObject().key("url").value(url).endObject();
+  }
+  writer.endArray().endObject();
+  return body;
+}
+} // namespace
+
+int main() {
+  for (std::size_t count : {10'000, 100'000, 1'000'000}) {
+    std::vector<boost::uuids::uuid> games(count);
+    for (auto &uuid : games) {
+      uuid = ids::generateV7();
+    }
+    if (serializeDom(games) != serializeStreaming(games)) {
+      std::cerr << "Outputs differ for " << count << " games" << std::endl;
+      return 1;
+    }
+    std::size_t iterations = 10'000'000 / count;
+    auto suffix = " (" + std::to_string(count) + " games)";
+    auto dom = bench::measure("boost::json DOM" + suffix, iterations,
+                              [&] { bench::doNotOptimize(serializeDom(games)); });
+    auto streaming =
+        bench::measure("JsonWriter" + suffix, iterations,
+                       [&] { bench::doNotOptimize(serializeStreaming(games)); });
+    std::cout << "speedup x" << dom / streaming << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,144 @@
+#include <boost/beast/http.hpp>
+#include <boost/json.hpp>
+#include <boost/url/parse.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string_view>
+
+#include "bench.hpp"
+#include "request_arena.hpp"
+#include "router.hpp"
+#include "server_iface.hpp"
+
+/**
+ * Обращения к глобальной куче на один запрос: разбор POST /games/{id}/votes
+ * с восемью заголовками, поиск маршрута и разбор JSON-тела, сначала на
+ * куче, затем в арене соединения, как в CoreServer::session, и наконец с
+ * переносом запроса в кучу, как у long-poll.
+ *
+ *   RequestBench
+ */
+namespace json = boost::json;
+namespace router = boost::urls::router;
+
+namespace {
+// Счётчик обращений к глобальной куче
+std::atomic<std::size_t> allocations{0};
+
+constexpr std::string_view kRequest =
+    "POST /games/0190f5d4-8c4a-7b3e-9a61-2f5c8e1d4b7a/votes HTTP/1.1\r\n"
+    "Host: localhost:8080\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) "
+    "Gecko/20100101 Firefox/128.0\r\n"
+    "Accept: application/json\r\n"
+    "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+    "Accept-Language: ru-RU,ru;q=0.9,en-US;q=0.8\r\n"
+    "Content-Type: application/json\r\n"
+    "Connection: keep-alive\r\n"
+    "Content-Length: 115\r\n"
+    "\r\n"
+    R"({"game_player_id": "0190f5d4-8c4b-7c11-8f2e-6a3b9d0c1e2f", )"
+    R"("round_card_id": "0190f5d4-8c4c-7d22-9e3f-7b4c0e1d2f30"})";
+
+// Разбор запроса, поиск маршрута и разбор тела, как в CoreServer::session
+template <typename Parser>
+void handle(Parser &parser, router::MatchesStorage &matches,
+            const router::Router<int> &routes, json::storage_ptr storage) {
+  boost::beast::error_code ec;
+  parser.eager(true);
+  parser.put(boost::asio::buffer(kRequest), ec);
+  auto &&req = parser.get();
+  auto target = boost::urls::parse_origin_form(req.target());
+  auto *route = routes.find(target->encoded_segments(), matches);
+  auto body = json::parse(req.body(), std::move(storage));
+  bench::doNotOptimize(route);
+  bench::doNotOptimize(body);
+}
+
+template <typename Fn> void report(std::string_view name, Fn &&fn) {
+  constexpr std::size_t kIterations = 200'000;
+  auto before = allocations.load();
+  bench::measure(name, kIterations, fn);
+  // measure() ещё и прогревает: kIterations / 10 + 1 лишних вызовов
+  auto calls = kIterations + kIterations / 10 + 1;
+  std::cout << "  malloc per request: "
+            << double(allocations.load() - before) / double(calls)
+            << std::endl;
+}
+} // namespace
+
+void *operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto *ptr = std::malloc(size ? size : 1); ptr) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+// std::pmr::new_delete_resource() выделяет с выравниванием
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  auto align = static_cast<std::size_t>(alignment);
+  if (auto *ptr = std::aligned_alloc(align, (size + align - 1) / align * align);
+      ptr) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+int main() {
+  router::Router<int> routes;
+  routes.insert("/games/{gameId}/players", 1);
+  routes.insert("/games/{gameId}/rounds", 2);
+  routes.insert("/games/{gameId}/cards", 3);
+  routes.insert("/games/{gameId}/votes", 4);
+
+  report("global heap", [&] {
+    boost::beast::http::request_parser<boost::beast::http::string_body> parser;
+    router::MatchesStorage matches;
+    handle(parser, matches, routes, {});
+  });
+
+  core::RequestArena arena;
+  report("per-connection arena", [&] {
+    arena.release();
+    using Request = core::AbstractServer::Request;
+    boost::beast::http::request_parser<Request::body_type,
+                                       core::AbstractServer::Allocator>
+        parser(std::piecewise_construct, std::make_tuple(arena.allocator()),
+               std::make_tuple(arena.allocator()));
+    router::MatchesStorage matches(&arena);
+    handle(parser, matches, routes, arena.jsonStorage());
+  });
+
+  // Long-poll: запрос копируется в кучу, арена отдаёт буфер до следующего
+  report("arena, parked in the heap", [&] {
+    using Request = core::AbstractServer::Request;
+    Request parked;
+    {
+      boost::beast::http::request_parser<Request::body_type,
+                                         core::AbstractServer::Allocator>
+          parser(std::piecewise_construct,
+                 std::make_tuple(arena.allocator()),
+                 std::make_tuple(arena.allocator()));
+      router::MatchesStorage matches(&arena);
+      handle(parser, matches, routes, arena.jsonStorage());
+      parked = parser.get();
+    }
+    arena.trim();
+    bench::doNotOptimize(parked);
+  });
+  return 0;
+}
@@ -0,0 +1,137 @@
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spawn.h>
+#include <sys/wait.h>
+
+/**
+ * Время от запуска процесса до готовности: бенчмарк запускает сервер,
+ * опрашивает его GET /healthz и GET /readyz и замеряет, когда сервер
+ * начал отвечать и когда объявил готовность после прогрева. Затем
+ * останавливает его по SIGTERM и повторяет.
+ *
+ *   StartupBench <port> <runs> <command> [args...]
+ *   StartupBench 18080 10 ./CoreApp --port 18080 --shard db1:5432 ...
+ *
+ * Команде нужна настоящая база: прогрев открывает соединения и выполняет
+ * на них горячие запросы.
+ */
+namespace asio = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+using tcp = asio::ip::tcp;
+
+extern char **environ;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr std::chrono::milliseconds kPollInterval{5};
+constexpr std::chrono::seconds kGiveUp{60};
+
+// Код ответа на GET @p path или std::nullopt, если сервер не отвечает
+std::optional<unsigned> probe(asio::io_context &ioc,
+                              const tcp::endpoint &endpoint,
+                              const std::string &path) {
+  beast::tcp_stream stream(ioc);
+  beast::error_code ec;
+  stream.socket().connect(endpoint, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  http::request<http::empty_body> req{http::verb::get, path, 11};
+  req.set(http::field::host, "localhost");
+  http::write(stream, req, ec);
+  beast::flat_buffer buffer;
+  http::response<http::string_body> res;
+  http::read(stream, buffer, res, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  return res.result_int();
+}
+
+struct Run {
+  std::chrono::milliseconds healthy;
+  std::chrono::milliseconds ready;
+};
+
+std::optional<Run> startOnce(const tcp::endpoint &endpoint, char **command) {
+  asio::io_context ioc;
+  auto start = Clock::now();
+  pid_t pid;
+  if (posix_spawnp(&pid, command[0], nullptr, nullptr, command, environ) !=
+      0) {
+    std::cerr << "cannot start " << command[0] << std::endl;
+    return std::nullopt;
+  }
+  auto since = [start] {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                                 start);
+  };
+  std::optional<std::chrono::milliseconds> healthy;
+  std::optional<Run> run;
+  while (since() < kGiveUp) {
+    if (!healthy and probe(ioc, endpoint, "/healthz") == 200u) {
+      healthy = since();
+    }
+    if (healthy and probe(ioc, endpoint, "/readyz") == 200u) {
+      run = Run{.healthy = *healthy, .ready = since()};
+      break;
+    }
+    int status;
+    if (waitpid(pid, &status, WNOHANG) == pid) {
+      std::cerr << "server exited before it was ready" << std::endl;
+      return std::nullopt;
+    }
+    std::this_thread::sleep_for(kPollInterval);
+  }
+  kill(pid, SIGTERM);
+  waitpid(pid, nullptr, 0);
+  return run;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 4) {
+    std::cerr << "usage: StartupBench <port> <runs> <command> [args...]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  tcp::endpoint endpoint(asio::ip::make_address("127.0.0.1"),
+                         static_cast<asio::ip::port_type>(std::atoi(argv[1])));
+  auto runs = std::max(std::atoi(argv[2]), 1);
+
+  std::vector<Run> results;
+  for (int idx = 0; idx < runs; ++idx) {
+    auto run = startOnce(endpoint, argv + 3);
+    if (!run) {
+      return EXIT_FAILURE;
+    }
+    results.push_back(*run);
+  }
+  auto percentile = [&](auto field, double p) {
+    std::vector<std::chrono::milliseconds> values;
+    for (auto &&run : results) {
+      values.push_back(run.*field);
+    }
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(p * (values.size() - 1))].count();
+  };
+  std::cout << "runs:             " << runs << '\n'
+            << "healthy p50/max:  " << percentile(&Run::healthy, 0.5) << " / "
+            << percentile(&Run::healthy, 1.0) << " ms\n"
+            << "ready p50/max:    " << percentile(&Run::ready, 0.5) << " / "
+            << percentile(&Run::ready, 1.0) << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,58 @@
+#include <boost/uuid/string_generator.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "ids.hpp"
+
+/**
+ * Генерация, форматирование и разбор UUID: boost::uuids против ids.
+ * Генераторы обеих сторон берут случайность у ОС, поэтому их разница —
+ * только в создании генератора на каждый вызов.
+ *
+ *   UuidBench
+ */
+int main() {
+  constexpr std::size_t kIterations = 1'000'000;
+
+  bench::measure("boost random_generator (new per call)", kIterations, [] {
+    bench::doNotOptimize(boost::uuids::random_generator()());
+  });
+  bench::measure("ids::generateV4", kIterations,
+                 [] { bench::doNotOptimize(ids::generateV4()); });
+  bench::measure("ids::generateV7", kIterations,
+                 [] { bench::doNotOptimize(ids::generateV7()); });
+
+  std::vector<boost::uuids::uuid> uuids(1024);
+  for (auto &uuid : uuids) {
+    uuid = ids::generateV4();
+  }
+  std::size_t idx = 0;
+  bench::measure("\"/games/\" + boost::uuids::to_string", kIterations, [&] {
+    auto url = "/games/" + boost::uuids::to_string(uuids[idx++ % 1024]);
+    bench::doNotOptimize(url);
+  });
+  std::string buffer;
+  bench::measure("ids::appendTo (reused buffer)", kIterations, [&] {
+    buffer.clear();
+    buffer += "/games/";
+    ids::appendTo(buffer, uuids[idx++ % 1024]);
+    bench::doNotOptimize(buffer);
+  });
+
+  std::vector<std::string> texts;
+  for (auto &uuid : uuids) {
+    texts.push_back(boost::uuids::to_string(uuid));
+  }
+  bench::measure("boost string_generator", kIterations, [&] {
+    bench::doNotOptimize(boost::uuids::string_generator()(texts[idx++ % 1024]));
+  });
+  bench::measure("ids::parse", kIterations, [&] {
+    bench::doNotOptimize(ids::parse(texts[idx++ % 1024]));
+  });
+  return 0;
+}
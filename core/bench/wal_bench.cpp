@@ -0,0 +1,125 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "game_log.hpp"
+#include "ids.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+/**
+ * @brief Пишет в журнал не меньше @p events изменений
+ *
+ * Каждая игра: создание, четыре игрока и десять раундов по семь изменений
+ * (раунд, три карты, три голоса) — 75 изменений.
+ */
+size_t fill(core::GameLog &log, size_t events) {
+  size_t written = 0;
+  std::vector<boost::uuids::uuid> players;
+  std::vector<core::GameChange> changes;
+  while (written < events) {
+    core::GameState game(ids::generateV7());
+    changes.assign(1, core::events::Created{});
+    players.clear();
+    for (int i = 0; i < 4; ++i) {
+      players.push_back(game.join(ids::generateV7()).gamePlayerId);
+    }
+    for (int round = 0; round < 10; ++round) {
+      auto &&narrator = game.nextNarrator().gamePlayerId;
+      game.startRound(narrator, ids::generateV7(), "clue");
+      for (auto &&player : players) {
+        if (player != narrator) {
+          game.playCard(player, ids::generateV7());
+        }
+      }
+      for (auto &&player : players) {
+        if (player == narrator) {
+          continue;
+        }
+        for (auto &&card : game.cards) {
+          if (card.gamePlayerId != player) {
+            game.vote(player, card.roundCardId);
+            break;
+          }
+        }
+      }
+    }
+    auto played = game.takeChanges();
+    changes.insert(changes.end(), played.begin(), played.end());
+    game.takeWrites();
+    log.append(game.gameId, changes);
+    written += changes.size();
+  }
+  return written;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  size_t events = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+  auto directory = fs::temp_directory_path() / "wal_bench";
+  fs::remove_all(directory);
+  core::GameLog::Options options{.directory = directory,
+                                 .shards = 4,
+                                 .segmentBytes = size_t(256) << 20};
+
+  size_t written = 0;
+  {
+    core::GameLog log(options);
+    auto start = Clock::now();
+    written = fill(log, events);
+    auto elapsed = millisecondsSince(start);
+    std::cout << "append " << written << " events (incl. engine): " << elapsed
+              << " ms" << std::endl;
+  }
+
+  {
+    // Холодный старт: только сегменты журнала
+    core::GameLog log(options);
+    std::vector<database::Query> writes;
+    auto start = Clock::now();
+    auto games = log.replay(writes);
+    auto elapsed = millisecondsSince(start);
+    std::cout << "replay from segments: " << elapsed << " ms, "
+              << games.size() << " games, " << writes.size()
+              << " database commands, "
+              << double(written) / elapsed * 1000.0 << " events/s"
+              << std::endl;
+    bench::doNotOptimize(games);
+    log.compact();
+    // Свёртка идёт в фоне: ждём, пока сегменты не исчезнут
+    auto pending = [&] {
+      for (auto &&entry : fs::recursive_directory_iterator(directory)) {
+        if (entry.path().extension() == ".log") {
+          return true;
+        }
+      }
+      return false;
+    };
+    while (pending()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  {
+    core::GameLog log(options);
+    std::vector<database::Query> writes;
+    auto start = Clock::now();
+    auto games = log.replay(writes);
+    std::cout << "replay from snapshots: " << millisecondsSince(start)
+              << " ms, " << games.size() << " games" << std::endl;
+  }
+  fs::remove_all(directory);
+  return 0;
+}
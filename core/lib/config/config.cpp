@@ -0,0 +1,226 @@
+#include "config.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace po = boost::program_options;
+namespace http = boost::beast::http;
+
+namespace core {
+namespace {
+po::options_description startupOptions() {
+  po::options_description desc("Startup options");
+  desc.add_options()("help,h", "Show help message")(
+      "config", po::value<std::string>()->default_value(""),
+      "INI file with any of these options as \"key = value\"")(
+      "host", po::value<std::string>()->default_value("127.0.0.1"),
+      "Server host address")(
+      "port", po::value<uint16_t>()->default_value(8080),
+      "Server port number")(
+      "db-name", po::value<std::string>()->default_value("road_n_roll"),
+      "Database name")(
+      "db-user", po::value<std::string>()->default_value("joe"),
+      "Database user")(
+      "db-password", po::value<std::string>()->default_value("12345678"),
+      "Database password; prefer CORE_DB_PASSWORD to the command line")(
+      "db-host", po::value<std::string>()->default_value("localhost"),
+      "Database host when no --shard is given")(
+      "db-port", po::value<uint16_t>()->default_value(5432),
+      "Database port when no --shard is given")(
+      "db-statement-timeout-ms", po::value<int64_t>()->default_value(60'000),
+      "statement_timeout of every database connection, a backstop for "
+      "request deadlines (0 disables)")(
+      "group-commit-window-us", po::value<int64_t>()->default_value(2000),
+      "Window in which game writes are coalesced into one transaction, "
+      "in microseconds (0 commits each write at once)")(
+      "group-commit-batch", po::value<size_t>()->default_value(256),
+      "Maximum number of commands in one coalesced transaction")(
+      "wal-dir", po::value<std::string>()->default_value(""),
+      "Directory of the active game log (empty disables)")(
+      "wal-shards", po::value<size_t>()->default_value(4),
+      "Number of game log shards")(
+      "wal-segment-mb", po::value<size_t>()->default_value(64),
+      "Size of one game log segment in MiB")(
+      "replica", po::value<std::vector<std::string>>()->default_value({}, ""),
+      "Streaming replica \"host:port\" that serves reads, may repeat")(
+      "replica-max-lag-ms", po::value<int64_t>()->default_value(1000),
+      "Replicas lagging further behind the primary get no reads")(
+      "shard", po::value<std::vector<std::string>>()->default_value({}, ""),
+      "Database \"host:port\" holding a share of the games, may repeat; "
+      "the address names the shard on the hash ring")(
+      "handoff-socket", po::value<std::string>()->default_value(""),
+      "Unix socket to take the listener from a running instance and to "
+      "hand it over to the next one (empty disables)");
+  return desc;
+}
+
+po::options_description reloadableOptions() {
+  po::options_description desc("Reloadable on SIGHUP");
+  desc.add_options()(
+      "log-level", po::value<std::string>()->default_value("info"),
+      "Minimum severity: trace, debug, info, warning, error, fatal")(
+      "max-sessions", po::value<size_t>()->default_value(10'000),
+      "Maximum number of open connections; the acceptor pauses at the limit")(
+      "max-inflight", po::value<size_t>()->default_value(512),
+      "Upper bound of the adaptive limit of requests in progress")(
+      "admission-queue", po::value<size_t>()->default_value(64),
+      "Requests over the limit that may wait for a slot before 503")(
+      "admission-queue-timeout-ms", po::value<int64_t>()->default_value(100),
+      "How long a queued request waits for a slot")(
+      "rate-limit",
+      po::value<std::vector<std::string>>()->default_value({}, ""),
+      "Per-client limit \"METHOD /route=rate[:burst]\", may repeat; "
+      "none by default, e.g. \"POST /games=5:20\" and "
+      "\"POST /games/batch=1:5\"")(
+      "rate-limit-header", po::value<std::string>()->default_value(""),
+      "Header that identifies a client, e.g. X-Api-Key, for rate limits "
+      "(empty: address) and replica read-your-writes (empty: none)")(
+      "request-timeout-ms", po::value<int64_t>()->default_value(30'000),
+      "Deadline of a request including its database queries")(
+      "deadline",
+      po::value<std::vector<std::string>>()->default_value({}, ""),
+      "Per-route deadline \"METHOD /route=ms\", may repeat")(
+      "drain-timeout-s", po::value<int64_t>()->default_value(30),
+      "How long requests in progress may finish on shutdown")(
+      "compression-min-size", po::value<size_t>()->default_value(1024),
+      "Responses smaller than this are sent uncompressed")(
+      "gzip-level", po::value<int>()->default_value(6), "gzip level")(
+      "zstd-level", po::value<int>()->default_value(3), "zstd level")(
+      "compression-cache-mb", po::value<size_t>()->default_value(8),
+      "Memory for compressed immutable responses in MiB");
+  return desc;
+}
+
+http::verb methodOf(const std::string &method, std::string_view text) {
+  auto verb = http::string_to_verb(method);
+  if (verb == http::verb::unknown) {
+    throw std::invalid_argument("unknown method in " + std::string(text));
+  }
+  return verb;
+}
+
+// "METHOD /route=ms"
+ServerSettings::RouteDeadline parseDeadline(std::string_view text) {
+  auto space = text.find(' ');
+  auto equals = text.rfind('=');
+  if (space == text.npos or equals == text.npos or equals < space) {
+    throw std::invalid_argument("malformed deadline: " + std::string(text));
+  }
+  return {.method = methodOf(std::string(text.substr(0, space)), text),
+          .route = std::string(text.substr(space + 1, equals - space - 1)),
+          .timeout = std::chrono::milliseconds(
+              std::stoll(std::string(text.substr(equals + 1))))};
+}
+
+template <typename T>
+const T &valueOf(const po::variables_map &values, const char *key) {
+  return values[key].as<T>();
+}
+
+// Настройки из разобранных значений; reload() проверяет ими кандидата
+ServerSettings serverOf(const po::variables_map &values) {
+  ServerSettings settings;
+  auto &&admission = settings.admission;
+  admission.maxSessions = valueOf<size_t>(values, "max-sessions");
+  admission.maxLimit = valueOf<size_t>(values, "max-inflight");
+  admission.minLimit = std::min(admission.minLimit, admission.maxLimit);
+  admission.initialLimit = std::min(admission.initialLimit, admission.maxLimit);
+  admission.queueSize = valueOf<size_t>(values, "admission-queue");
+  admission.queueTimeout = std::chrono::milliseconds(
+      valueOf<int64_t>(values, "admission-queue-timeout-ms"));
+
+  auto &&compression = settings.compression;
+  compression.minSize = valueOf<size_t>(values, "compression-min-size");
+  compression.gzipLevel = valueOf<int>(values, "gzip-level");
+  compression.zstdLevel = valueOf<int>(values, "zstd-level");
+  compression.cacheBytes = valueOf<size_t>(values, "compression-cache-mb")
+                           << 20;
+
+  for (auto &&text :
+       valueOf<std::vector<std::string>>(values, "rate-limit")) {
+    auto rule = parseRateLimitRule(text);
+    settings.rateLimits.push_back({.method = methodOf(rule.method, text),
+                                   .route = std::move(rule.route),
+                                   .limit = rule.limit});
+  }
+  settings.rateLimitHeader =
+      valueOf<std::string>(values, "rate-limit-header");
+  settings.defaultDeadline = std::chrono::milliseconds(
+      valueOf<int64_t>(values, "request-timeout-ms"));
+  for (auto &&text : valueOf<std::vector<std::string>>(values, "deadline")) {
+    settings.deadlines.push_back(parseDeadline(text));
+  }
+  settings.drainTimeout =
+      std::chrono::seconds(valueOf<int64_t>(values, "drain-timeout-s"));
+  return settings;
+}
+
+boost::log::trivial::severity_level
+logLevelOf(const po::variables_map &values) {
+  auto &&text = valueOf<std::string>(values, "log-level");
+  boost::log::trivial::severity_level level;
+  if (!boost::log::trivial::from_string(text.data(), text.size(), level)) {
+    throw std::invalid_argument("unknown log level: " + text);
+  }
+  return level;
+}
+} // namespace
+
+Config::Config(std::vector<std::string> args) : args_(std::move(args)) {
+  description_.add(startupOptions()).add(reloadableOptions());
+  values_ = parse();
+}
+
+Config::Config(int argc, const char *const argv[])
+    : Config(std::vector<std::string>(argv + std::min(argc, 1), argv + argc)) {
+}
+
+void Config::reload() {
+  // Новые значения проверяются целиком и лишь затем заменяют прежние
+  auto values = parse();
+  serverOf(values);
+  logLevelOf(values);
+  values_ = std::move(values);
+}
+
+bool Config::help() const { return values_.count("help") > 0; }
+
+std::string Config::optionOf(std::string_view variable) const {
+  if (!variable.starts_with(kEnvironmentPrefix)) {
+    return {};
+  }
+  std::string option(variable.substr(kEnvironmentPrefix.size()));
+  std::ranges::transform(option, option.begin(), [](unsigned char c) {
+    return c == '_' ? '-' : static_cast<char>(std::tolower(c));
+  });
+  if (option == "help" or !description_.find_nothrow(option, false)) {
+    return {};
+  }
+  return option;
+}
+
+po::variables_map Config::parse() const {
+  po::variables_map values;
+  // Первый сохранённый источник важнее следующих
+  po::store(po::command_line_parser(args_).options(description_).run(),
+            values);
+  po::store(po::parse_environment(description_,
+                                  [this](const std::string &variable) {
+                                    return optionOf(variable);
+                                  }),
+            values);
+  if (auto &&path = values["config"].as<std::string>(); !path.empty()) {
+    po::store(po::parse_config_file<char>(path.c_str(), description_),
+              values);
+  }
+  po::notify(values);
+  return values;
+}
+
+ServerSettings Config::server() const { return serverOf(values_); }
+
+boost::log::trivial::severity_level Config::logLevel() const {
+  return logLevelOf(values_);
+}
+} // namespace core
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <boost/log/trivial.hpp>
+#include <boost/program_options.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "settings.hpp"
+
+namespace core {
+/**
+ * @brief Настройки процесса из файла, окружения и командной строки
+ *
+ * Источники по убыванию приоритета:
+ * - командная строка;
+ * - переменные окружения CORE_<КЛЮЧ>: CORE_MAX_INFLIGHT задаёт max-inflight;
+ * - файл из --config (CORE_CONFIG) в формате INI: "max-inflight = 256",
+ *   повторяющиеся ключи — список.
+ *
+ * Ключи группы "Reloadable" перечитываются по SIGHUP (reload()) и
+ * применяются через server() и logLevel(); остальные действуют до
+ * перезапуска.
+ *
+ * Не потокобезопасен: reload() вызывают в том же потоке, что и чтение.
+ */
+struct Config {
+  /**
+   * @param args Аргументы командной строки без имени программы
+   */
+  explicit Config(std::vector<std::string> args);
+
+  Config(int argc, const char *const argv[]);
+
+  /**
+   * @brief Перечитывает файл и окружение
+   *
+   * Командная строка по-прежнему важнее них. Новые значения заменяют
+   * прежние, только если из них собираются server() и logLevel(); иначе
+   * бросает исключение, прежние значения остаются.
+   */
+  void reload();
+
+  /// Запрошена справка (--help)
+  bool help() const;
+
+  const boost::program_options::options_description &description() const {
+    return description_;
+  }
+
+  template <typename T> const T &get(const std::string &key) const {
+    return values_[key].as<T>();
+  }
+
+  /**
+   * @brief Настройки сервера из перезагружаемых ключей
+   *
+   * @throws std::invalid_argument при ошибке в правиле или методе
+   */
+  ServerSettings server() const;
+
+  /**
+   * @brief Порог журнала: trace, debug, info, warning, error или fatal
+   */
+  boost::log::trivial::severity_level logLevel() const;
+
+  /**
+   * @brief Ключ для переменной окружения или пустая строка, если она
+   * не относится к настройкам
+   */
+  std::string optionOf(std::string_view variable) const;
+
+  static constexpr std::string_view kEnvironmentPrefix = "CORE_";
+
+private:
+  boost::program_options::variables_map parse() const;
+
+  std::vector<std::string> args_;
+  boost::program_options::options_description description_;
+  boost::program_options::variables_map values_;
+};
+} // namespace core
@@ -1,53 +1,257 @@
 #include "database.hpp"
+#include "ids.hpp"
 #include "serializer.hpp"
 
 #include <boost/log/trivial.hpp>
-#include <boost/uuid/string_generator.hpp>
+#include <libpq-fe.h>
+
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
 #include <variant>
 
 namespace database {
-
-Database::Database(std::string databaseName, std::string userName,
-                   std::string dbPassword, std::string host, uint port) {
+namespace {
+std::string connectionString(const std::string &databaseName,
+                             const std::string &userName,
+                             const std::string &dbPassword,
+                             const std::string &host, uint port,
+                             std::chrono::milliseconds statementTimeout) {
   std::stringstream connBuilder;
   connBuilder << "user=" << userName << " password=" << dbPassword
               << " host=" << host << " port=" << port
               << " dbname=" << databaseName;
-  dbConnection_ = pqxx::connection(connBuilder.str());
+  if (statementTimeout.count() > 0) {
+    // Один раз на соединение, а не SET перед каждым запросом
+    connBuilder << " options='-c statement_timeout="
+                << statementTimeout.count() << "'";
+  }
+  return connBuilder.str();
+}
+} // namespace
+
+Database::Database(std::string databaseName, std::string userName,
+                   std::string dbPassword, std::string host, uint port,
+                   std::chrono::milliseconds statementTimeout)
+    // Сразу с параметрами: соединение по умолчанию стоило бы лишнего
+    // подключения к серверу из окружения libpq
+    : dbConnection_(connectionString(databaseName, userName, dbPassword,
+                                     host, port, statementTimeout)) {
+  auto *conn = std::move(dbConnection_).release_raw_connection();
+  cancel_.reset(PQgetCancel(conn));
+  dbConnection_ = pqxx::connection::seize_raw_connection(conn);
+}
+
+void Database::CancelDeleter::operator()(pg_cancel *cancel) const {
+  PQfreeCancel(cancel);
+}
+
+void Database::cancel() {
+  char error[256];
+  if (PQcancel(cancel_.get(), error, sizeof(error)) != 1) {
+    BOOST_LOG_TRIVIAL(warning) << "Не удалось отменить запрос: " << error;
+  }
+}
+
+namespace {
+// SQLSTATE query_canceled: и statement_timeout, и PQcancel
+constexpr std::string_view kQueryCanceled = "57014";
+
+// QueryCancelled, если срок уже прошёл: запрос не стоит и отправлять
+void checkDeadline(const QueryContext &context) {
+  if (context.deadline <= QueryContext::Clock::now()) {
+    throw QueryCancelled("Срок запроса истёк до его отправки");
+  }
+}
+} // namespace
+
+template <typename Fn> auto Database::cancellable(Fn &&run) {
+  auto *context = QueryContext::current();
+  if (!context) {
+    return run();
+  }
+  checkDeadline(*context);
+  auto watch = watchdog_.watch(*context);
+  try {
+    return run();
+  } catch (const pqxx::sql_error &e) {
+    if (e.sqlstate() == kQueryCanceled) {
+      throw QueryCancelled(watch.fired() ? "Запрос отменён: срок истёк или "
+                                           "клиент отключился"
+                                         : "Превышен statement_timeout");
+    }
+    throw;
+  }
 }
 
 size_t Database::executeCommand(Query query) {
+  std::lock_guard lock(mutex_);
   pqxx::work worker(dbConnection_);
   BOOST_LOG_TRIVIAL(info) << "Выполняю команду: " << query.sql;
-  auto result = worker.exec(query.sql, query.params).affected_rows();
+  auto result = cancellable([&] {
+    return worker.exec(query.sql, query.params).affected_rows();
+  });
   BOOST_LOG_TRIVIAL(info) << "Затронуто строк: " << result;
   worker.commit();
   return result;
 }
 
+std::vector<size_t> Database::executeBatch(std::vector<Query> queries) {
+  std::lock_guard lock(mutex_);
+  pqxx::work worker(dbConnection_);
+  BOOST_LOG_TRIVIAL(info) << "Выполняю пакет команд: " << queries.size();
+  std::vector<size_t> result;
+  result.reserve(queries.size());
+  cancellable([&] {
+    for (auto &&query : queries) {
+      result.push_back(worker.exec(query.sql, query.params).affected_rows());
+    }
+  });
+  worker.commit();
+  return result;
+}
+
 namespace {
+constexpr uint kInt8 = 20;
+constexpr uint kInt2 = 21;
+constexpr uint kInt4 = 23;
+constexpr uint kText = 25;
+constexpr uint kFloat4 = 700;
 constexpr uint kVarCharType = 1043;
 constexpr uint kUuid = 2950;
+
+// Разбирает текстовое представление значения по OID его типа
+Field fromText(uint type, std::string_view text) {
+  BOOST_LOG_TRIVIAL(info) << "Type OId: " << type;
+  switch (type) {
+  case kVarCharType:
+  case kText:
+    return Field(std::string(text));
+  case kUuid:
+    // Convert PostgreSQL UUID string to Boost UUID type
+    return Field(ids::parse(text).value());
+  case kInt2:
+    return Field(pqxx::from_string<int16_t>(text));
+  case kInt4:
+    return Field(pqxx::from_string<int32_t>(text));
+  case kInt8:
+    return Field(pqxx::from_string<int64_t>(text));
+  case kFloat4:
+    return Field(pqxx::from_string<float>(text));
+  default:
+    return std::monostate();
+  }
+}
+
 Field fromOid(const pqxx::field &field) {
-  BOOST_LOG_TRIVIAL(info) << "Type OId: " << field.type();
-  if (field.type() == kVarCharType) {
-    return Field(field.as<std::string>());
+  return fromText(field.type(), field.view());
+}
+
+/**
+ * @brief Временно забирает у libpqxx сырое соединение libpq
+ *
+ * libpqxx 7 не поддерживает pipeline mode, поэтому на время конвейера
+ * работаем с libpq напрямую и при любом исходе возвращаем соединение назад.
+ * Если конвейер прерван исключением, деструктор дочитывает его и выключает
+ * pipeline mode, а не сумев — переподключается: иначе libpqxx получил бы
+ * соединение, на котором не выполнить ни одного запроса.
+ */
+struct RawConnection {
+  using ResetHook = std::function<void(PGconn *)>;
+
+  RawConnection(pqxx::connection &owner, ResetHook onReset)
+      : owner(owner), conn(std::move(owner).release_raw_connection()),
+        onReset(std::move(onReset)) {}
+  ~RawConnection() {
+    if (PQpipelineStatus(conn) != PQ_PIPELINE_OFF and !leavePipeline()) {
+      BOOST_LOG_TRIVIAL(warning)
+          << "Не удалось выйти из pipeline mode, переподключаюсь: "
+          << PQerrorMessage(conn);
+      PQreset(conn);
+      onReset(conn);
+    }
+    owner = pqxx::connection::seize_raw_connection(conn);
   }
-  if (field.type() == kUuid) {
-    // Convert PostgreSQL UUID string to Boost UUID type
-    const std::string uuidStr = field.as<std::string>();
-    boost::uuids::string_generator gen;
-    boost::uuids::uuid uuid = gen(uuidStr);
-    return Field(std::move(uuid));
+  RawConnection(const RawConnection &) = delete;
+  RawConnection &operator=(const RawConnection &) = delete;
+
+  /// Отправляет маркер синхронизации, если его ещё не было
+  bool sync() {
+    if (!synced) {
+      synced = PQpipelineSync(conn) == 1;
+    }
+    return synced;
+  }
+
+  /**
+   * @brief Отбрасывает непрочитанные результаты до маркера синхронизации
+   * и выключает pipeline mode
+   *
+   * @return false, если соединение так и осталось в pipeline mode
+   */
+  bool leavePipeline() {
+    if (!sync()) {
+      return false;
+    }
+    // Между результатами запросов приходит по одному nullptr; два подряд —
+    // ждать больше нечего, а маркера так и не было
+    bool idle = false;
+    while (PQstatus(conn) == CONNECTION_OK) {
+      PGresult *res = PQgetResult(conn);
+      if (!res) {
+        if (idle) {
+          break;
+        }
+        idle = true;
+        continue;
+      }
+      idle = false;
+      bool reached = PQresultStatus(res) == PGRES_PIPELINE_SYNC;
+      PQclear(res);
+      if (reached) {
+        return PQexitPipelineMode(conn) == 1;
+      }
+    }
+    return false;
+  }
+
+  pqxx::connection &owner;
+  PGconn *conn;
+  ResetHook onReset;
+  bool synced = false;
+};
+
+std::vector<RowFields> fromResult(const PGresult *res) {
+  std::vector<RowFields> rows;
+  const int rowCount = PQntuples(res);
+  const int colCount = PQnfields(res);
+  rows.reserve(rowCount);
+  for (int row = 0; row < rowCount; ++row) {
+    RowFields fields;
+    for (int col = 0; col < colCount; ++col) {
+      const char *name = PQfname(res, col);
+      if (PQgetisnull(res, row, col)) {
+        fields[name] = std::monostate();
+        continue;
+      }
+      fields[name] = fromText(PQftype(res, col),
+                              {PQgetvalue(res, row, col),
+                               size_t(PQgetlength(res, row, col))});
+    }
+    rows.push_back(std::move(fields));
   }
-  return std::monostate();
+  return rows;
 }
 } // namespace
 
 RowFields Database::fetchSingle(Query query) {
+  std::lock_guard lock(mutex_);
   pqxx::work worker(dbConnection_);
   BOOST_LOG_TRIVIAL(info) << "Выполняю запрос одного элемента: " << query.sql;
-  auto rows = worker.exec(query.sql, query.params);
+  auto rows =
+      cancellable([&] { return worker.exec(query.sql, query.params); });
   BOOST_LOG_TRIVIAL(info) << "Получено строк: " << rows.size();
   assert(rows.size() <= 1);
   if (rows.empty()) {
@@ -67,9 +271,11 @@ RowFields Database::fetchSingle(Query query) {
 }
 
 std::vector<RowFields> Database::fetchMultiple(Query query) {
+  std::lock_guard lock(mutex_);
   pqxx::work worker(dbConnection_);
   BOOST_LOG_TRIVIAL(info) << "Выполняю нескольких элементов: " << query.sql;
-  auto rows = worker.exec(query.sql);
+  auto rows =
+      cancellable([&] { return worker.exec(query.sql, query.params); });
   BOOST_LOG_TRIVIAL(info) << "Получено строк: " << rows.size();
   std::vector<RowFields> result;
   for (const pqxx::row &row : rows) {
@@ -86,4 +292,102 @@ std::vector<RowFields> Database::fetchMultiple(Query query) {
   }
   return result;
 }
+
+void Database::fetchRows(Query query, const RowConsumer &consumer) {
+  std::lock_guard lock(mutex_);
+  pqxx::work worker(dbConnection_);
+  BOOST_LOG_TRIVIAL(info) << "Выполняю запрос строк: " << query.sql;
+  auto rows =
+      cancellable([&] { return worker.exec(query.sql, query.params); });
+  BOOST_LOG_TRIVIAL(info) << "Получено строк: " << rows.size();
+  for (const pqxx::row &row : rows) {
+    consumer(row);
+  }
+}
+
+std::vector<std::vector<RowFields>>
+Database::fetchPipeline(std::vector<Query> queries) {
+  std::lock_guard lock(mutex_);
+  BOOST_LOG_TRIVIAL(info) << "Выполняю конвейер запросов: " << queries.size();
+  // Истёкший срок не стоит входа в pipeline mode и выхода из него
+  static const QueryContext kNoDeadline;
+  auto *context = QueryContext::current();
+  if (context) {
+    checkDeadline(*context);
+  }
+  // Ключ отмены принадлежит соединению и меняется при переподключении
+  RawConnection raw(dbConnection_, [this](PGconn *conn) {
+    cancel_.reset(PQgetCancel(conn));
+  });
+  auto fail = [&raw](std::string_view what) {
+    throw std::runtime_error(std::format("{}: {}", what,
+                                         PQerrorMessage(raw.conn)));
+  };
+  if (PQenterPipelineMode(raw.conn) != 1) {
+    fail("Не удалось включить pipeline mode");
+  }
+  // Все запросы уходят одним сбросом буфера, до Sync они выполняются
+  // в одной неявной транзакции
+  std::vector<int> formats;
+  for (auto &&query : queries) {
+    auto params = query.params.make_c_params();
+    formats.resize(params.formats.size());
+    std::ranges::transform(params.formats, formats.begin(),
+                           [](pqxx::format format) {
+                             return static_cast<int>(format);
+                           });
+    if (PQsendQueryParams(raw.conn, query.sql.c_str(),
+                          int(params.values.size()),
+                          /*paramTypes*/ nullptr, params.values.data(),
+                          params.lengths.data(), formats.data(),
+                          /*resultFormat*/ 0) != 1) {
+      fail("Не удалось поставить запрос в конвейер");
+    }
+  }
+  auto watch = watchdog_.watch(context ? *context : kNoDeadline);
+  if (!raw.sync()) {
+    fail("Не удалось отправить конвейер");
+  }
+
+  std::vector<std::vector<RowFields>> results;
+  results.reserve(queries.size());
+  std::string error;
+  bool canceled = false;
+  for (size_t idx = 0; idx < queries.size(); ++idx) {
+    // Результат каждого запроса завершается нулевым указателем
+    while (PGresult *res = PQgetResult(raw.conn)) {
+      switch (PQresultStatus(res)) {
+      case PGRES_TUPLES_OK:
+        results.push_back(fromResult(res));
+        break;
+      case PGRES_COMMAND_OK:
+        results.emplace_back();
+        break;
+      case PGRES_PIPELINE_ABORTED:
+        break;
+      default:
+        if (error.empty()) {
+          error = PQresultErrorMessage(res);
+          if (auto *state = PQresultErrorField(res, PG_DIAG_SQLSTATE)) {
+            canceled = state == kQueryCanceled;
+          }
+        }
+      }
+      PQclear(res);
+    }
+  }
+  // Дочитываем маркер синхронизации, иначе из режима не выйти
+  if (!raw.leavePipeline()) {
+    fail("Не удалось выключить pipeline mode");
+  }
+  if (canceled) {
+    throw QueryCancelled(error);
+  }
+  if (not error.empty()) {
+    throw std::runtime_error(error);
+  }
+  BOOST_LOG_TRIVIAL(info) << "Конвейер выполнен, результатов: "
+                          << results.size();
+  return results;
+}
 } // namespace database
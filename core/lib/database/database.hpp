@@ -1,23 +1,68 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <pqxx/pqxx>
 
 #include "database_iface.hpp"
+#include "query_context.hpp"
 #include "serializer.hpp"
 
+// PGcancel из libpq-fe.h
+struct pg_cancel;
+
 namespace database {
+/**
+ * @brief Соединение с PostgreSQL
+ *
+ * Запросы, выполняемые под QueryContext, отменяются через PQcancel, если
+ * срок истёк или клиент отключился; тогда вызывающий получает
+ * QueryCancelled. statement_timeout соединения — страховка на случай,
+ * когда до сторожа дело не дошло.
+ */
 struct Database final : AbstractDatabase {
+  /**
+   * @param statementTimeout statement_timeout соединения, задаётся один раз
+   * при подключении; 0 — без него
+   */
   Database(std::string databaseName, std::string userName,
-           std::string dbPassword, std::string host, uint port);
+           std::string dbPassword, std::string host, uint port,
+           std::chrono::milliseconds statementTimeout = {});
 
   size_t executeCommand(Query query) final;
 
+  std::vector<size_t> executeBatch(std::vector<Query> queries) final;
+
   RowFields fetchSingle(Query query) final;
 
   std::vector<RowFields> fetchMultiple(Query query) final;
 
+  void fetchRows(Query query, const RowConsumer &consumer) final;
+
+  std::vector<std::vector<RowFields>>
+  fetchPipeline(std::vector<Query> queries) final;
+
 private:
+  struct CancelDeleter {
+    void operator()(pg_cancel *cancel) const;
+  };
+
+  /**
+   * @brief Выполняет @p run под сроком текущего QueryContext
+   *
+   * @throws QueryCancelled если срок уже истёк или запрос отменён
+   */
+  template <typename Fn> auto cancellable(Fn &&run);
+
+  void cancel();
+
+  // Соединение не потокобезопасно, а пишут в него и сессии, и группировщик
+  std::mutex mutex_;
   // FIXME: pimpl
   pqxx::connection dbConnection_;
+  // Ключ отмены не меняется, пока живо соединение
+  std::unique_ptr<pg_cancel, CancelDeleter> cancel_;
+  QueryWatchdog watchdog_{[this] { cancel(); }};
 };
 } // namespace database
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <vector>
 
 #include "serializer.hpp"
@@ -7,8 +8,29 @@
 
 namespace database {
 struct AbstractDatabase {
+  using RowConsumer = std::function<void(const pqxx::row &)>;
+
   virtual size_t executeCommand(Query query) = 0;
+  // Выполняет команды в одной транзакции, возвращает число затронутых строк
+  // для каждой. При ошибке транзакция откатывается целиком.
+  virtual std::vector<size_t> executeBatch(std::vector<Query> queries) = 0;
   virtual RowFields fetchSingle(Query query) = 0;
   virtual std::vector<RowFields> fetchMultiple(Query query) = 0;
+  // Отдаёт строки результата как есть, без разбора в RowFields
+  virtual void fetchRows(Query query, const RowConsumer &consumer) = 0;
+  // Отправляет все запросы одним пакетом (libpq pipeline mode) и возвращает
+  // строки каждого из них в том же порядке. Запросы выполняются в одной
+  // неявной транзакции: ошибка любого из них отменяет весь конвейер.
+  virtual std::vector<std::vector<RowFields>>
+  fetchPipeline(std::vector<Query> queries) = 0;
+  // Номер шарда ключа: запросы с ключами одного шарда можно объединять
+  // в один. Декораторы передают вызов дальше.
+  virtual size_t shardOf(const boost::uuids::uuid &) const { return 0; }
+  // Выполняет горячие запросы на каждом соединении до приёма трафика:
+  // проверяет соединения и прогревает кэши каталога на сервере. Декораторы
+  // прогревают все нижележащие базы, по возможности параллельно.
+  virtual void warmUp(std::vector<Query> queries) {
+    fetchPipeline(std::move(queries));
+  }
 };
 } // namespace database
\ No newline at end of file
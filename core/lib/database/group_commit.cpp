@@ -0,0 +1,205 @@
+#include "group_commit.hpp"
+#include "query_context.hpp"
+
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace database {
+GroupCommitDatabase::GroupCommitDatabase(std::shared_ptr<AbstractDatabase> db,
+                                         std::chrono::microseconds window,
+                                         size_t maxBatch)
+    : db_(std::move(db)), window_(window),
+      maxBatch_(std::max<size_t>(maxBatch, 1)) {
+  queue_.reserve(maxBatch_);
+  worker_ = std::thread([this] { loop(); });
+}
+
+GroupCommitDatabase::~GroupCommitDatabase() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wakeUp_.notify_all();
+  worker_.join();
+}
+
+void GroupCommitDatabase::submit(Query query, Completion done) {
+  // Команда выполнится в потоке группировщика, где контекста запроса нет
+  if (auto *context = QueryContext::current(); context and !query.client) {
+    query.client = context->client;
+  }
+  {
+    std::lock_guard lock(mutex_);
+    queue_.push_back({std::move(query), std::move(done)});
+    ++submitted_;
+  }
+  // Первая команда открывает окно, переполнение его досрочно закрывает
+  wakeUp_.notify_one();
+}
+
+std::future<size_t> GroupCommitDatabase::submit(Query query) {
+  auto promise = std::make_shared<std::promise<size_t>>();
+  auto future = promise->get_future();
+  submit(std::move(query),
+         [promise](std::exception_ptr error, size_t affected) {
+           if (error) {
+             promise->set_exception(error);
+           } else {
+             promise->set_value(affected);
+           }
+         });
+  return future;
+}
+
+void GroupCommitDatabase::drain() {
+  std::unique_lock lock(mutex_);
+  auto target = submitted_;
+  drained_.wait(lock, [this, target] { return flushed_ >= target; });
+}
+
+size_t GroupCommitDatabase::executeCommand(Query query) {
+  return submit(std::move(query)).get();
+}
+
+std::vector<size_t>
+GroupCommitDatabase::executeBatch(std::vector<Query> queries) {
+  return db_->executeBatch(std::move(queries));
+}
+
+RowFields GroupCommitDatabase::fetchSingle(Query query) {
+  return db_->fetchSingle(std::move(query));
+}
+
+std::vector<RowFields> GroupCommitDatabase::fetchMultiple(Query query) {
+  return db_->fetchMultiple(std::move(query));
+}
+
+void GroupCommitDatabase::fetchRows(Query query,
+                                    const RowConsumer &consumer) {
+  db_->fetchRows(std::move(query), consumer);
+}
+
+std::vector<std::vector<RowFields>>
+GroupCommitDatabase::fetchPipeline(std::vector<Query> queries) {
+  return db_->fetchPipeline(std::move(queries));
+}
+
+size_t GroupCommitDatabase::shardOf(const boost::uuids::uuid &key) const {
+  return db_->shardOf(key);
+}
+
+void GroupCommitDatabase::warmUp(std::vector<Query> queries) {
+  db_->warmUp(std::move(queries));
+}
+
+void GroupCommitDatabase::loop() {
+  std::unique_lock lock(mutex_);
+  for (;;) {
+    wakeUp_.wait(lock, [this] { return stopping_ or not queue_.empty(); });
+    if (queue_.empty()) {
+      // Остановка, и всё уже выполнено
+      return;
+    }
+    // Окно открывается первой командой в очереди
+    auto deadline = std::chrono::steady_clock::now() + window_;
+    wakeUp_.wait_until(lock, deadline, [this] {
+      return stopping_ or queue_.size() >= maxBatch_;
+    });
+    std::vector<Pending> batch;
+    if (queue_.size() <= maxBatch_) {
+      batch.reserve(maxBatch_);
+      batch.swap(queue_);
+    } else {
+      auto tail = queue_.begin() + maxBatch_;
+      batch.assign(std::make_move_iterator(queue_.begin()),
+                   std::make_move_iterator(tail));
+      queue_.erase(queue_.begin(), tail);
+    }
+    auto count = batch.size();
+    lock.unlock();
+    flush(std::move(batch));
+    lock.lock();
+    flushed_ += count;
+    drained_.notify_all();
+  }
+}
+
+void GroupCommitDatabase::flush(std::vector<Pending> batch) {
+  // Транзакция не может охватить несколько шардов: пакет делится по ним
+  std::map<size_t, std::vector<Pending>> byShard;
+  for (auto &&pending : batch) {
+    auto &&key = pending.query.shardKey;
+    byShard[key ? db_->shardOf(*key) : 0].push_back(std::move(pending));
+  }
+  for (auto &&[shard, pendings] : byShard) {
+    flushShard(std::move(pendings));
+  }
+}
+
+void GroupCommitDatabase::flushShard(std::vector<Pending> batch) {
+  std::vector<Query> queries;
+  queries.reserve(batch.size());
+  for (auto &&pending : batch) {
+    queries.push_back(pending.query);
+  }
+  std::vector<size_t> affected;
+  std::exception_ptr error;
+  try {
+    affected = db_->executeBatch(std::move(queries));
+  } catch (const std::exception &e) {
+    BOOST_LOG_TRIVIAL(warning)
+        << "[GroupCommit] Пакет из " << batch.size()
+        << " команд отклонён, повторяю по одной: " << e.what();
+    error = std::current_exception();
+  }
+  if (!error) {
+    // Пакет зафиксирован: повторять его нельзя, даже если итог неполон
+    std::exception_ptr mismatch;
+    if (affected.size() != batch.size()) {
+      BOOST_LOG_TRIVIAL(error)
+          << "[GroupCommit] Пакет из " << batch.size()
+          << " команд зафиксирован, но вернул итогов: " << affected.size();
+      mismatch = std::make_exception_ptr(std::length_error(
+          "batch committed with " + std::to_string(affected.size()) +
+          " results for " + std::to_string(batch.size()) + " commands"));
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+      complete(batch[i], mismatch, mismatch ? 0 : affected[i]);
+    }
+    return;
+  }
+  // Пакет шёл в одну базу одной транзакцией и откатился целиком, поэтому
+  // повтор безопасен
+  for (auto &&pending : batch) {
+    size_t affected = 0;
+    std::exception_ptr error;
+    try {
+      affected = db_->executeCommand(std::move(pending.query));
+    } catch (...) {
+      error = std::current_exception();
+    }
+    complete(pending, error, affected);
+  }
+}
+
+void GroupCommitDatabase::complete(Pending &pending, std::exception_ptr error,
+                                   size_t affected) noexcept {
+  // Исключение обработчика не должно остановить поток группировщика
+  try {
+    pending.done(error, affected);
+  } catch (const std::exception &e) {
+    BOOST_LOG_TRIVIAL(error)
+        << "[GroupCommit] Обработчик завершения бросил исключение: "
+        << e.what();
+  } catch (...) {
+    BOOST_LOG_TRIVIAL(error)
+        << "[GroupCommit] Обработчик завершения бросил исключение";
+  }
+}
+} // namespace database
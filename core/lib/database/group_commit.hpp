@@ -0,0 +1,144 @@
+#pragma once
+
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "database_iface.hpp"
+
+namespace database {
+/**
+ * @brief Декоратор, объединяющий независимые команды разных запросов в одну
+ * транзакцию (group commit).
+ *
+ * Команды копятся в очереди в течение окна @c window или пока их не станет
+ * @c maxBatch, после чего выполняются одной транзакцией на шард: вместо сброса
+ * WAL на каждую команду получаем один сброс на пакет. Если пакет шарда упал,
+ * каждая его команда повторяется отдельно, и ошибку получает только её автор.
+ *
+ * Из потока io_context команды ставят через asyncSubmit(): executeCommand()
+ * ждёт окна и блокирует вызывающий поток.
+ */
+struct GroupCommitDatabase final : AbstractDatabase {
+  GroupCommitDatabase(std::shared_ptr<AbstractDatabase> db,
+                      std::chrono::microseconds window, size_t maxBatch);
+  ~GroupCommitDatabase();
+
+  /// Итог команды: исключение или число затронутых строк
+  using Completion = std::function<void(std::exception_ptr, size_t)>;
+
+  /**
+   * @brief Ставит команду в очередь
+   *
+   * @param done Вызывается в потоке группировщика, когда команда выполнена
+   */
+  void submit(Query query, Completion done);
+
+  /**
+   * @brief Ставит команду в очередь
+   *
+   * @return Будущее с числом затронутых строк или исключением команды
+   */
+  std::future<size_t> submit(Query query);
+
+  /**
+   * @brief Ставит команду в очередь, не блокируя поток
+   *
+   * Обработчик с сигнатурой void(std::exception_ptr, size_t) вызывается
+   * на своём исполнителе, например `co_await db.asyncSubmit(query,
+   * asio::use_awaitable)` возвращает число строк или бросает исключение
+   * команды.
+   */
+  template <typename CompletionToken>
+  auto asyncSubmit(Query query, CompletionToken &&token) {
+    return boost::asio::async_initiate<CompletionToken,
+                                       void(std::exception_ptr, size_t)>(
+        [this](auto handler, Query query) {
+          using Handler = decltype(handler);
+          // Completion копируется, а обработчик asio — только перемещается
+          struct State {
+            Handler handler;
+            boost::asio::executor_work_guard<
+                boost::asio::associated_executor_t<Handler>>
+                work;
+          };
+          auto executor = boost::asio::get_associated_executor(handler);
+          auto state = std::make_shared<State>(
+              State{std::move(handler),
+                    boost::asio::make_work_guard(std::move(executor))});
+          submit(std::move(query),
+                 [state](std::exception_ptr error, size_t affected) {
+                   auto executor = state->work.get_executor();
+                   boost::asio::post(executor, [state, error, affected] {
+                     state->work.reset();
+                     std::move(state->handler)(error, affected);
+                   });
+                 });
+        },
+        token, std::move(query));
+  }
+
+  /**
+   * @brief Ждёт, пока команды, поставленные до вызова, выполнятся и их
+   * обработчики завершения отработают
+   */
+  void drain();
+
+  size_t executeCommand(Query query) final;
+
+  std::vector<size_t> executeBatch(std::vector<Query> queries) final;
+
+  RowFields fetchSingle(Query query) final;
+
+  std::vector<RowFields> fetchMultiple(Query query) final;
+
+  void fetchRows(Query query, const RowConsumer &consumer) final;
+
+  std::vector<std::vector<RowFields>>
+  fetchPipeline(std::vector<Query> queries) final;
+
+  size_t shardOf(const boost::uuids::uuid &key) const final;
+
+  void warmUp(std::vector<Query> queries) final;
+
+private:
+  struct Pending {
+    Query query;
+    Completion done;
+  };
+
+  void loop();
+  void flush(std::vector<Pending> batch);
+  // Команды одного шарда: одна транзакция, при ошибке — по одной
+  void flushShard(std::vector<Pending> batch);
+  // Вызывает обработчик команды, его исключение только пишется в журнал
+  static void complete(Pending &pending, std::exception_ptr error,
+                       size_t affected) noexcept;
+
+  std::shared_ptr<AbstractDatabase> db_;
+  const std::chrono::microseconds window_;
+  const size_t maxBatch_;
+
+  std::mutex mutex_;
+  std::condition_variable wakeUp_;
+  std::condition_variable drained_;
+  std::vector<Pending> queue_;
+  // Очередь разбирается по порядку: команды с номером до flushed_ завершены
+  uint64_t submitted_ = 0;
+  uint64_t flushed_ = 0;
+  bool stopping_ = false;
+  std::thread worker_;
+};
+} // namespace database
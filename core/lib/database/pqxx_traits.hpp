@@ -0,0 +1,48 @@
+#pragma once
+
+#include <boost/uuid/uuid.hpp>
+#include <pqxx/pqxx>
+
+#include <string_view>
+
+#include "ids.hpp"
+
+// Преобразования boost::uuids::uuid для libpqxx: позволяют передавать UUID
+// параметром и читать его из pqxx::field без промежуточного std::string
+namespace pqxx {
+template <>
+struct nullness<boost::uuids::uuid> : no_null<boost::uuids::uuid> {};
+
+template <> struct string_traits<boost::uuids::uuid> {
+  static constexpr bool converts_to_string{true};
+  static constexpr bool converts_from_string{true};
+  // 36 символов канонической записи и завершающий ноль
+  static constexpr std::size_t kSize = 37;
+
+  static zview to_buf(char *begin, char *end,
+                      const boost::uuids::uuid &value) {
+    return {begin, std::size_t(into_buf(begin, end, value) - begin - 1)};
+  }
+
+  static char *into_buf(char *begin, char *end,
+                        const boost::uuids::uuid &value) {
+    if (end - begin < std::ptrdiff_t(kSize)) {
+      throw conversion_overrun("Not enough buffer space to store uuid");
+    }
+    char *out = ids::format(value, begin);
+    *out++ = '\0';
+    return out;
+  }
+
+  static boost::uuids::uuid from_string(std::string_view text) {
+    if (auto uuid = ids::parse(text); uuid) {
+      return *uuid;
+    }
+    throw conversion_error("Could not convert string to uuid");
+  }
+
+  static std::size_t size_buffer(const boost::uuids::uuid &) noexcept {
+    return kSize;
+  }
+};
+} // namespace pqxx
@@ -1,18 +1,100 @@
 #include "query_builder.hpp"
+#include "pqxx_traits.hpp"
 
-#include <sstream>
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <iterator>
 #include <stdexcept>
 
 namespace database {
+namespace {
+// Колонки строки, упорядоченные по имени: порядок обхода unordered_map
+// не определён, а текст SQL должен быть одинаковым для одинаковых форм
+using SortedFields = std::vector<const RowFields::value_type *>;
+
+void sortFields(const RowFields &fields, SortedFields &sorted) {
+  sorted.clear();
+  for (auto &&entry : fields) {
+    sorted.push_back(&entry);
+  }
+  std::ranges::sort(sorted, {}, [](auto *entry) -> std::string_view {
+    return entry->first;
+  });
+}
+
+std::string_view conflictClause(OnConflict onConflict) {
+  return onConflict == OnConflict::skip ? "ON CONFLICT DO NOTHING" : "";
+}
+
+struct Shape {
+  std::vector<std::string> columns;
+  OnConflict onConflict;
+  std::string sql;
+};
+
+struct StringHash {
+  using is_transparent = void;
+  size_t operator()(std::string_view str) const {
+    return std::hash<std::string_view>{}(str);
+  }
+};
+
+// Кэш готового текста INSERT по таблице и набору колонок. Свой на каждый
+// поток, поэтому обходится без блокировок.
+thread_local std::unordered_map<std::string, std::vector<Shape>, StringHash,
+                                std::equal_to<>>
+    insertShapes;
+
+const std::string &insertShape(std::string_view tableName,
+                               const SortedFields &sorted,
+                               OnConflict onConflict) {
+  auto tableIt = insertShapes.find(tableName);
+  if (tableIt == insertShapes.end()) {
+    tableIt = insertShapes.emplace(std::string(tableName), std::vector<Shape>{})
+                  .first;
+  }
+  auto &shapes = tableIt->second;
+  auto shapeIt = std::ranges::find_if(shapes, [&](const Shape &shape) {
+    return shape.onConflict == onConflict and
+           std::ranges::equal(shape.columns, sorted, std::ranges::equal_to{},
+                              {}, [](auto *entry) -> std::string_view {
+                                return entry->first;
+                              });
+  });
+  if (shapeIt != shapes.end()) {
+    return shapeIt->sql;
+  }
+  // Форма встретилась впервые: строим текст один раз
+  Shape shape{.onConflict = onConflict};
+  std::string keys;
+  std::string values;
+  for (size_t idx = 0; idx < sorted.size(); ++idx) {
+    if (idx != 0) {
+      keys += ", ";
+      values += ", ";
+    }
+    keys += sorted[idx]->first;
+    std::format_to(std::back_inserter(values), "${}", idx + 1);
+    shape.columns.push_back(sorted[idx]->first);
+  }
+  shape.sql = std::format(R"sql(
+    INSERT INTO {} ({})
+    VALUES ({})
+    {}
+  )sql",
+                          tableName, keys, values, conflictClause(onConflict));
+  return shapes.emplace_back(std::move(shape)).sql;
+}
+} // namespace
+
 void Query::append(const Field &field) {
   auto visitor = Overload{
       [this](std::monostate) {
         throw std::logic_error("Unexpected monostate");
       },
-      [this](std::string s) { params.append(s); },
-      [this](boost::uuids::uuid u) {
-        params.append(boost::uuids::to_string(u));
-      },
+      [this](const std::string &s) { params.append(s); },
+      [this](const boost::uuids::uuid &u) { params.append(u); },
       [this](int16_t x) { params.append(x); },
       [this](int32_t x) { params.append(x); },
       [this](int64_t x) { params.append(x); },
@@ -31,26 +113,62 @@ Query QueryBuilder::generic(std::string_view query, std::vector<Field> params) {
 }
 
 Query QueryBuilder::insert(std::string_view tableName, RowFields fields) {
-  std::stringstream keys;
-  std::stringstream values;
+  thread_local SortedFields sorted;
+  sortFields(fields, sorted);
   Query result;
-  int idx = 1;
-  for (auto &&[key, value] : fields) {
-    if (idx != 1) {
-      keys << ", ";
-      values << ", ";
+  result.sql = insertShape(tableName, sorted, onConflict);
+  result.params.reserve(sorted.size());
+  for (auto *entry : sorted) {
+    result.append(entry->second);
+  }
+  return result;
+}
+
+Query QueryBuilder::insertMany(std::string_view tableName,
+                               std::vector<RowFields> rows) {
+  if (rows.empty()) {
+    throw std::invalid_argument("Nothing to insert");
+  }
+  SortedFields sorted;
+  sortFields(rows.front(), sorted);
+  std::vector<std::string_view> columns;
+  columns.reserve(sorted.size());
+  std::string keys;
+  for (auto *entry : sorted) {
+    if (!columns.empty()) {
+      keys += ", ";
     }
-    keys << key;
-    values << "$" << std::to_string(idx);
-    result.append(value);
-    idx++;
+    keys += entry->first;
+    columns.push_back(entry->first);
+  }
+  std::string values;
+  Query result;
+  result.params.reserve(rows.size() * columns.size());
+  size_t idx = 1;
+  for (auto &&row : rows) {
+    if (row.size() != columns.size()) {
+      throw std::invalid_argument("Row shape mismatch");
+    }
+    values += idx == 1 ? "(" : ", (";
+    for (size_t col = 0; col < columns.size(); ++col) {
+      auto it = row.find(std::string(columns[col]));
+      if (it == row.end()) {
+        throw std::invalid_argument("Row shape mismatch");
+      }
+      std::format_to(std::back_inserter(values), "{}${}", col ? ", " : "",
+                     idx);
+      result.append(it->second);
+      idx++;
+    }
+    values += ")";
   }
 
   result.sql = std::format(R"sql(
     INSERT INTO {} ({})
-    VALUES ({})
+    VALUES {}
+    {}
   )sql",
-                             tableName, keys.str(), values.str());
+                           tableName, keys, values, conflictClause(onConflict));
   return result;
 }
-} // namespace database
\ No newline at end of file
+} // namespace database
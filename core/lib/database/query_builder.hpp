@@ -2,16 +2,38 @@
 
 #include <pqxx/pqxx>
 
+#include <optional>
+
 #include "serializer.hpp"
 
 namespace database {
 struct Query {
   std::string sql;
   pqxx::params params;
+  // game_id запроса одной игры: по нему ShardedDatabase выбирает шард
+  std::optional<boost::uuids::uuid> shardKey;
+  // Автор записи для read-your-writes в RoutingDatabase; 0 — клиент
+  // текущего QueryContext, если он есть
+  size_t client = 0;
   void append(const Field &field);
 };
+/// Что делает вставка со строкой, ключ которой уже есть в таблице
+enum class OnConflict {
+  fail,
+  // ON CONFLICT DO NOTHING: повтор вставки ничего не меняет
+  skip,
+};
 struct QueryBuilder {
+  OnConflict onConflict = OnConflict::fail;
+
   Query generic(std::string_view query, std::vector<Field> params);
   Query insert(std::string_view tableName, RowFields fields);
+  /**
+   * @brief Многострочная вставка одним запросом (INSERT ... VALUES (...),
+   * (...)), порядок колонок берётся из первой строки
+   *
+   * @throws std::invalid_argument если набор колонок строк отличается
+   */
+  Query insertMany(std::string_view tableName, std::vector<RowFields> rows);
 };
 } // namespace database
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include "routing.hpp"
+#include "query_context.hpp"
+
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <exception>
+#include <future>
+
+namespace database {
+namespace {
+constexpr std::string_view kPrimaryLsn =
+    "SELECT pg_current_wal_lsn()::text AS lsn";
+// На сервере, не являющемся репликой, NULL: такой сервер чтений не получит
+constexpr std::string_view kReplicaLsn =
+    "SELECT pg_last_wal_replay_lsn()::text AS lsn";
+
+std::optional<uint64_t> lsnOf(const RowFields &row) {
+  auto it = row.find("lsn");
+  if (it == row.end()) {
+    return std::nullopt;
+  }
+  auto *text = std::get_if<std::string>(&it->second);
+  return text ? RoutingDatabase::parseLsn(*text) : std::nullopt;
+}
+} // namespace
+
+RoutingDatabase::RoutingDatabase(
+    std::shared_ptr<AbstractDatabase> primary,
+    std::vector<std::shared_ptr<AbstractDatabase>> replicas, Options options)
+    : primary_(std::move(primary)), options_(options),
+      lastWriteByClient_(
+          std::make_unique<std::atomic<Clock::rep>[]>(kClientSlots)) {
+  for (auto &&db : replicas) {
+    auto replica = std::make_unique<Replica>();
+    replica->db = std::move(db);
+    replicas_.push_back(std::move(replica));
+  }
+  worker_ = std::thread([this] { loop(); });
+}
+
+RoutingDatabase::~RoutingDatabase() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wakeUp_.notify_all();
+  worker_.join();
+}
+
+AbstractDatabase *RoutingDatabase::reader() {
+  if (replicas_.empty()) {
+    return nullptr;
+  }
+  auto *context = QueryContext::current();
+  auto lastWrite =
+      context and context->client
+          ? lastWriteByClient_[context->client % kClientSlots].load(
+                std::memory_order_relaxed)
+          : lastWrite_.load(std::memory_order_relaxed);
+  auto oldest = (Clock::now() - options_.maxLag).time_since_epoch().count();
+  auto start = next_.fetch_add(1, std::memory_order_relaxed);
+  for (size_t i = 0; i < replicas_.size(); ++i) {
+    auto &replica = *replicas_[(start + i) % replicas_.size()];
+    auto caughtUpTo = replica.caughtUpTo.load(std::memory_order_relaxed);
+    if (caughtUpTo >= lastWrite and caughtUpTo >= oldest) {
+      return replica.db.get();
+    }
+  }
+  return nullptr;
+}
+
+template <typename Fn> auto RoutingDatabase::read(Fn &&run) {
+  if (auto *replica = reader(); replica) {
+    try {
+      return run(*replica);
+    } catch (const QueryCancelled &) {
+      // Срок истёк: повтор на primary его не вернёт
+      throw;
+    } catch (const std::exception &e) {
+      BOOST_LOG_TRIVIAL(warning)
+          << "Реплика не ответила, читаю с primary: " << e.what();
+    }
+  }
+  return run(*primary_);
+}
+
+size_t RoutingDatabase::executeCommand(Query query) {
+  auto client = query.client;
+  auto result = primary_->executeCommand(std::move(query));
+  wrote(std::span(&client, 1));
+  return result;
+}
+
+std::vector<size_t> RoutingDatabase::executeBatch(std::vector<Query> queries) {
+  // В пакете группировщика команды разных клиентов
+  std::vector<size_t> clients;
+  clients.reserve(queries.size());
+  for (auto &&query : queries) {
+    clients.push_back(query.client);
+  }
+  auto result = primary_->executeBatch(std::move(queries));
+  wrote(clients);
+  return result;
+}
+
+RowFields RoutingDatabase::fetchSingle(Query query) {
+  return read([&](AbstractDatabase &db) { return db.fetchSingle(query); });
+}
+
+std::vector<RowFields> RoutingDatabase::fetchMultiple(Query query) {
+  return read([&](AbstractDatabase &db) { return db.fetchMultiple(query); });
+}
+
+void RoutingDatabase::fetchRows(Query query, const RowConsumer &consumer) {
+  // Часть строк могла уже дойти до consumer: на primary не повторяем
+  auto *replica = reader();
+  (replica ? *replica : *primary_).fetchRows(std::move(query), consumer);
+}
+
+std::vector<std::vector<RowFields>>
+RoutingDatabase::fetchPipeline(std::vector<Query> queries) {
+  // Конвейером читают состояние перед записью: оно должно быть свежим
+  return primary_->fetchPipeline(std::move(queries));
+}
+
+size_t RoutingDatabase::shardOf(const boost::uuids::uuid &key) const {
+  return primary_->shardOf(key);
+}
+
+void RoutingDatabase::warmUp(std::vector<Query> queries) {
+  std::vector<std::future<void>> replicas;
+  for (auto &&replica : replicas_) {
+    replicas.push_back(std::async(std::launch::async, [&queries, &replica] {
+      replica->db->warmUp(queries);
+    }));
+  }
+  primary_->warmUp(queries);
+  // Чтения с недоступной реплики и так уходят на primary
+  for (auto &&future : replicas) {
+    try {
+      future.get();
+    } catch (const std::exception &e) {
+      BOOST_LOG_TRIVIAL(warning)
+          << "Не удалось прогреть реплику: " << e.what();
+    }
+  }
+}
+
+void RoutingDatabase::wrote(std::span<const size_t> clients) {
+  // Время конца записи: снимки LSN после него её уже содержат
+  auto now = Clock::now().time_since_epoch().count();
+  lastWrite_.store(now, std::memory_order_relaxed);
+  auto remember = [this, now](size_t client) {
+    lastWriteByClient_[client % kClientSlots].store(now,
+                                                    std::memory_order_relaxed);
+  };
+  for (auto client : clients) {
+    if (client) {
+      remember(client);
+    }
+  }
+  if (auto *context = QueryContext::current(); context and context->client) {
+    remember(context->client);
+  }
+}
+
+void RoutingDatabase::refresh() {
+  std::lock_guard lock(refreshMutex_);
+  auto now = Clock::now().time_since_epoch().count();
+  try {
+    if (auto lsn = lsnOf(primary_->fetchSingle(Query{.sql = std::string(
+                             kPrimaryLsn)}));
+        lsn) {
+      history_.push_back({.at = now, .lsn = *lsn});
+      if (history_.size() > kLsnHistory) {
+        history_.pop_front();
+      }
+    }
+  } catch (const std::exception &e) {
+    BOOST_LOG_TRIVIAL(warning) << "Не удалось узнать LSN primary: " << e.what();
+  }
+  for (auto &&replica : replicas_) {
+    std::optional<uint64_t> lsn;
+    try {
+      lsn = lsnOf(
+          replica->db->fetchSingle(Query{.sql = std::string(kReplicaLsn)}));
+    } catch (const std::exception &e) {
+      BOOST_LOG_TRIVIAL(warning)
+          << "Не удалось узнать LSN реплики: " << e.what();
+    }
+    if (!lsn) {
+      continue;
+    }
+    // Самый поздний снимок primary, который реплика уже воспроизвела
+    auto sample = std::find_if(history_.rbegin(), history_.rend(),
+                               [&](auto &&s) { return s.lsn <= *lsn; });
+    if (sample != history_.rend()) {
+      auto caughtUpTo = replica->caughtUpTo.load(std::memory_order_relaxed);
+      replica->caughtUpTo.store(std::max(caughtUpTo, sample->at),
+                                std::memory_order_relaxed);
+    }
+  }
+}
+
+std::optional<uint64_t> RoutingDatabase::parseLsn(std::string_view text) {
+  auto slash = text.find('/');
+  if (slash == std::string_view::npos) {
+    return std::nullopt;
+  }
+  uint32_t high = 0;
+  uint32_t low = 0;
+  auto parse = [](std::string_view part, uint32_t &value) {
+    auto [end, ec] =
+        std::from_chars(part.data(), part.data() + part.size(), value, 16);
+    return ec == std::errc() and end == part.data() + part.size() and
+           !part.empty();
+  };
+  if (!parse(text.substr(0, slash), high) or
+      !parse(text.substr(slash + 1), low)) {
+    return std::nullopt;
+  }
+  return uint64_t(high) << 32 | low;
+}
+
+void RoutingDatabase::loop() {
+  std::unique_lock lock(mutex_);
+  while (!stopping_) {
+    lock.unlock();
+    refresh();
+    lock.lock();
+    wakeUp_.wait_for(lock, options_.checkInterval, [this] { return stopping_; });
+  }
+}
+} // namespace database
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "database_iface.hpp"
+
+namespace database {
+/**
+ * @brief Декоратор, разделяющий чтение и запись между primary и репликами
+ *
+ * Команды и конвейеры (ими загружается состояние игры перед ходом) идут
+ * на primary, fetchSingle/fetchMultiple/fetchRows — на реплики по кругу.
+ *
+ * Фоновый поток раз в @c checkInterval запоминает LSN primary и сверяет с
+ * ним LSN воспроизведения каждой реплики. Если реплика воспроизвела LSN,
+ * снятый в момент t, то все записи до t на ней видны: t — её «догнала до».
+ * Отставание реплики — время с этого момента; дальше @c maxLag она чтений
+ * не получает.
+ *
+ * Read-your-writes: время последней записи хранится по её автору —
+ * Query::client или клиенту текущего QueryContext (записи из чужих
+ * потоков, как у GroupCommitDatabase, несут автора в Query). Чтение
+ * клиента идёт на реплику, только если та догнала его последнюю запись,
+ * иначе — на primary. Клиенты хешируются в таблицу фиксированного
+ * размера: коллизия лишь отправит чтение на primary. Чтения без клиента
+ * сверяются с последней записью вообще.
+ */
+struct RoutingDatabase final : AbstractDatabase {
+  struct Options {
+    // Реже проверять — грубее оценка отставания
+    std::chrono::milliseconds checkInterval{200};
+    // Отстающая сильнее реплика не получает чтений; должно быть больше
+    // checkInterval, иначе реплики будут выпадать между проверками
+    std::chrono::milliseconds maxLag{1000};
+  };
+
+  RoutingDatabase(std::shared_ptr<AbstractDatabase> primary,
+                  std::vector<std::shared_ptr<AbstractDatabase>> replicas,
+                  Options options);
+  ~RoutingDatabase();
+
+  size_t executeCommand(Query query) final;
+
+  std::vector<size_t> executeBatch(std::vector<Query> queries) final;
+
+  RowFields fetchSingle(Query query) final;
+
+  std::vector<RowFields> fetchMultiple(Query query) final;
+
+  void fetchRows(Query query, const RowConsumer &consumer) final;
+
+  std::vector<std::vector<RowFields>>
+  fetchPipeline(std::vector<Query> queries) final;
+
+  size_t shardOf(const boost::uuids::uuid &key) const final;
+
+  /// Прогревает primary и все реплики параллельно
+  void warmUp(std::vector<Query> queries) final;
+
+  /**
+   * @brief Сверяет LSN реплик с primary
+   *
+   * Вызывается фоновым потоком; открыт для тестов.
+   */
+  void refresh();
+
+  /// Разбирает LSN вида "16/B374D848"
+  static std::optional<uint64_t> parseLsn(std::string_view text);
+
+  // Размер таблицы последних записей клиентов
+  static constexpr size_t kClientSlots = 4096;
+  // Сколько снимков LSN primary хранить для сверки
+  static constexpr size_t kLsnHistory = 32;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Replica {
+    std::shared_ptr<AbstractDatabase> db;
+    // Время снимка LSN primary, который реплика уже воспроизвела;
+    // до первой сверки — никакого
+    std::atomic<Clock::rep> caughtUpTo{std::numeric_limits<Clock::rep>::min()};
+  };
+
+  struct LsnSample {
+    Clock::rep at;
+    uint64_t lsn;
+  };
+
+  // Реплика для чтения текущего клиента или nullptr — читать с primary
+  AbstractDatabase *reader();
+  // Читает с реплики, при её ошибке — с primary
+  template <typename Fn> auto read(Fn &&run);
+  // Запоминает время записи для её авторов (см. Query::client)
+  void wrote(std::span<const size_t> clients);
+  void loop();
+
+  std::shared_ptr<AbstractDatabase> primary_;
+  std::vector<std::unique_ptr<Replica>> replicas_;
+  const Options options_;
+
+  std::unique_ptr<std::atomic<Clock::rep>[]> lastWriteByClient_;
+  std::atomic<Clock::rep> lastWrite_{0};
+  std::atomic<size_t> next_{0};
+
+  // Снимки LSN primary, под refreshMutex_
+  std::mutex refreshMutex_;
+  std::deque<LsnSample> history_;
+
+  std::mutex mutex_;
+  std::condition_variable wakeUp_;
+  bool stopping_ = false;
+  std::thread worker_;
+};
+} // namespace database
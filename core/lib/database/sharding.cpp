@@ -0,0 +1,179 @@
+#include "sharding.hpp"
+#include "query_context.hpp"
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+namespace database {
+namespace {
+// Хеш не должен зависеть от сборки: по нему лежат данные
+uint64_t fnv1a(std::span<const uint8_t> bytes) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (auto byte : bytes) {
+    hash = (hash ^ byte) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// Финализатор splitmix64: FNV плохо перемешивает старшие биты
+uint64_t mix(uint64_t hash) {
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+  return hash ^ (hash >> 31);
+}
+
+uint64_t hashOf(std::string_view text) {
+  return mix(fnv1a({reinterpret_cast<const uint8_t *>(text.data()),
+                    text.size()}));
+}
+} // namespace
+
+ShardedDatabase::ShardedDatabase(std::vector<Shard> shards,
+                                 size_t virtualNodes)
+    : shards_(std::move(shards)), pool_(std::max<size_t>(shards_.size(), 1)) {
+  if (shards_.empty()) {
+    throw std::invalid_argument("ShardedDatabase needs at least one shard");
+  }
+  ring_.reserve(shards_.size() * virtualNodes);
+  for (size_t idx = 0; idx < shards_.size(); ++idx) {
+    for (size_t node = 0; node < virtualNodes; ++node) {
+      ring_.emplace_back(hashOf(shards_[idx].name + "#" + std::to_string(node)),
+                         idx);
+    }
+  }
+  std::ranges::sort(ring_);
+}
+
+size_t ShardedDatabase::shardOf(const boost::uuids::uuid &key) const {
+  auto hash = mix(fnv1a({key.begin(), key.end()}));
+  auto it = std::ranges::lower_bound(ring_, std::pair{hash, size_t{0}});
+  // Кольцо: за последней точкой идёт первая
+  return it == ring_.end() ? ring_.front().second : it->second;
+}
+
+size_t ShardedDatabase::shardIndex(const Query &query) const {
+  return query.shardKey ? shardOf(*query.shardKey) : 0;
+}
+
+AbstractDatabase &ShardedDatabase::route(const Query &query) {
+  return *shards_[shardIndex(query)].db;
+}
+
+template <typename Fn> auto ShardedDatabase::fanOut(Fn &&run) {
+  using Result = std::invoke_result_t<Fn &, AbstractDatabase &>;
+  // Срок запроса действует и в потоках шардов
+  auto *context = QueryContext::current();
+  std::vector<std::future<Result>> futures;
+  futures.reserve(shards_.size());
+  for (auto &&shard : shards_) {
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+        [&run, &shard, context] {
+          std::optional<QueryContext::Scope> scope;
+          if (context) {
+            scope.emplace(*context);
+          }
+          return run(*shard.db);
+        });
+    futures.push_back(task->get_future());
+    boost::asio::post(pool_, [task] { (*task)(); });
+  }
+  // Задачи ссылаются на run: до первого исключения дожидаемся всех
+  for (auto &&future : futures) {
+    future.wait();
+  }
+  if constexpr (std::is_void_v<Result>) {
+    for (auto &&future : futures) {
+      future.get();
+    }
+  } else {
+    std::vector<Result> results;
+    results.reserve(futures.size());
+    for (auto &&future : futures) {
+      results.push_back(future.get());
+    }
+    return results;
+  }
+}
+
+size_t ShardedDatabase::executeCommand(Query query) {
+  auto &db = route(query);
+  return db.executeCommand(std::move(query));
+}
+
+std::vector<size_t> ShardedDatabase::executeBatch(std::vector<Query> queries) {
+  if (queries.empty()) {
+    return {};
+  }
+  // Пакет на несколько шардов зафиксировался бы частично, и повтор
+  // пакета целиком задвоил бы уже зафиксированные команды
+  auto shard = shardIndex(queries.front());
+  if (!std::ranges::all_of(queries, [this, shard](const Query &query) {
+        return shardIndex(query) == shard;
+      })) {
+    throw std::invalid_argument("Batch spans several shards");
+  }
+  return shards_[shard].db->executeBatch(std::move(queries));
+}
+
+RowFields ShardedDatabase::fetchSingle(Query query) {
+  if (query.shardKey) {
+    auto &db = route(query);
+    return db.fetchSingle(std::move(query));
+  }
+  auto rows =
+      fanOut([&](AbstractDatabase &db) { return db.fetchSingle(query); });
+  auto found =
+      std::ranges::find_if(rows, [](auto &&row) { return !row.empty(); });
+  return found == rows.end() ? RowFields{} : std::move(*found);
+}
+
+std::vector<RowFields> ShardedDatabase::fetchMultiple(Query query) {
+  if (query.shardKey) {
+    auto &db = route(query);
+    return db.fetchMultiple(std::move(query));
+  }
+  auto parts =
+      fanOut([&](AbstractDatabase &db) { return db.fetchMultiple(query); });
+  std::vector<RowFields> rows;
+  for (auto &&part : parts) {
+    std::ranges::move(part, std::back_inserter(rows));
+  }
+  return rows;
+}
+
+void ShardedDatabase::fetchRows(Query query, const RowConsumer &consumer) {
+  if (query.shardKey) {
+    route(query).fetchRows(std::move(query), consumer);
+    return;
+  }
+  // consumer не обязан быть потокобезопасным
+  std::mutex mutex;
+  fanOut([&](AbstractDatabase &db) {
+    db.fetchRows(query, [&](const pqxx::row &row) {
+      std::lock_guard lock(mutex);
+      consumer(row);
+    });
+  });
+}
+
+void ShardedDatabase::warmUp(std::vector<Query> queries) {
+  fanOut([&](AbstractDatabase &db) { db.warmUp(queries); });
+}
+
+std::vector<std::vector<RowFields>>
+ShardedDatabase::fetchPipeline(std::vector<Query> queries) {
+  // Конвейер читает одну игру: хватает ключа любого запроса
+  auto keyed = std::ranges::find_if(
+      queries, [](auto &&query) { return query.shardKey.has_value(); });
+  auto &db = keyed == queries.end() ? *shards_.front().db : route(*keyed);
+  return db.fetchPipeline(std::move(queries));
+}
+} // namespace database
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <boost/asio/thread_pool.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "database_iface.hpp"
+
+namespace database {
+/**
+ * @brief Декоратор, раскладывающий игры по нескольким базам
+ *
+ * Шард игры выбирается по Query::shardKey (game_id) консистентным
+ * хешированием: у каждого шарда kVirtualNodes точек на кольце, ключ
+ * достаётся шарду первой точки не меньше хеша ключа. Точки считаются от
+ * имени шарда, поэтому новый шард забирает у остальных около 1/N игр, а
+ * не перемешивает все.
+ *
+ * Запросы без ключа:
+ *  - чтения (fetchSingle/fetchMultiple/fetchRows) идут на все шарды
+ *    параллельно, результаты склеиваются;
+ *  - команды и конвейеры идут в первый шард. Справочники (players, cards,
+ *    player_colors, game_statuses) должны быть на всех шардах одинаковыми:
+ *    на них ссылаются таблицы игр.
+ *
+ * executeBatch принимает только пакеты одного шарда: транзакция атомарна
+ * лишь внутри одной базы. Пакет на несколько шардов отвергается с
+ * std::invalid_argument, делить его — забота вызывающего
+ * (GroupCommitDatabase делит).
+ *
+ * Чтения без ключа выполняются в пуле из одного потока на шард, а не в
+ * новом потоке на каждый запрос.
+ */
+struct ShardedDatabase final : AbstractDatabase {
+  struct Shard {
+    // Имя определяет место шарда на кольце: при переименовании игры
+    // переедут
+    std::string name;
+    std::shared_ptr<AbstractDatabase> db;
+  };
+
+  explicit ShardedDatabase(std::vector<Shard> shards,
+                           size_t virtualNodes = kVirtualNodes);
+
+  size_t executeCommand(Query query) final;
+
+  std::vector<size_t> executeBatch(std::vector<Query> queries) final;
+
+  RowFields fetchSingle(Query query) final;
+
+  std::vector<RowFields> fetchMultiple(Query query) final;
+
+  void fetchRows(Query query, const RowConsumer &consumer) final;
+
+  std::vector<std::vector<RowFields>>
+  fetchPipeline(std::vector<Query> queries) final;
+
+  size_t shardOf(const boost::uuids::uuid &key) const final;
+
+  /// Прогревает все шарды параллельно
+  void warmUp(std::vector<Query> queries) final;
+
+  static constexpr size_t kVirtualNodes = 64;
+
+private:
+  // Номер шарда запроса с ключом, иначе первого
+  size_t shardIndex(const Query &query) const;
+  // Шард запроса с ключом, иначе первый
+  AbstractDatabase &route(const Query &query);
+
+  // Выполняет @p run на всех шардах параллельно, результаты по порядку
+  // шардов
+  template <typename Fn> auto fanOut(Fn &&run);
+
+  std::vector<Shard> shards_;
+  // Точки кольца: хеш и номер шарда, по возрастанию хеша
+  std::vector<std::pair<uint64_t, size_t>> ring_;
+  // Потоки fanOut; объявлен последним и останавливается первым
+  boost::asio::thread_pool pool_;
+};
+} // namespace database
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <boost/hana.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <pqxx/pqxx>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "database_iface.hpp"
+#include "pqxx_traits.hpp"
+
+/**
+ * @file typed_query.hpp
+ * @brief Типизированные запросы поверх структур BOOST_HANA_DEFINE_STRUCT.
+ *
+ * Текст SELECT/INSERT/DELETE собирается на этапе компиляции из имён полей
+ * структуры, параметры привязываются по ссылке с явным приведением к типу
+ * колонки, а строки результата разбираются прямо в поля структуры, минуя
+ * RowFields и std::variant.
+ *
+ * @code
+ * struct Game {
+ *   BOOST_HANA_DEFINE_STRUCT(Game, (boost::uuids::uuid, game_id),
+ *                            (int32_t, status_id));
+ * };
+ * using Games = database::TypedTable<"games", Game>;
+ * db.executeCommand(Games::insert(game));
+ * auto games = Games::fetch(db, Games::select());
+ * @endcode
+ */
+namespace database {
+namespace hana = boost::hana;
+
+/**
+ * @brief Строка, пригодная для передачи параметром шаблона
+ */
+template <size_t N> struct FixedString {
+  constexpr FixedString(const char (&str)[N]) { std::copy_n(str, N, value); }
+  constexpr std::string_view view() const { return {value, N - 1}; }
+  char value[N]{};
+};
+
+namespace detail {
+template <typename M> constexpr std::string_view sqlType() {
+  if constexpr (std::is_same_v<M, boost::uuids::uuid>) {
+    return "uuid";
+  } else if constexpr (std::is_same_v<M, std::string>) {
+    return "text";
+  } else if constexpr (std::is_same_v<M, bool>) {
+    return "bool";
+  } else if constexpr (std::is_same_v<M, int16_t>) {
+    return "int2";
+  } else if constexpr (std::is_same_v<M, int32_t>) {
+    return "int4";
+  } else if constexpr (std::is_same_v<M, int64_t>) {
+    return "int8";
+  } else if constexpr (std::is_same_v<M, float>) {
+    return "float4";
+  } else if constexpr (std::is_same_v<M, double>) {
+    return "float8";
+  } else {
+    static_assert(sizeof(M) == 0, "Unsupported column type");
+  }
+}
+
+template <typename T> constexpr auto columnNames() {
+  return hana::unpack(hana::accessors<T>(), [](auto... member) {
+    return std::array<std::string_view, sizeof...(member)>{std::string_view(
+        std::remove_cvref_t<decltype(hana::first(member))>::c_str())...};
+  });
+}
+
+template <typename T> constexpr auto columnTypes() {
+  return hana::unpack(hana::accessors<T>(), [](auto... member) {
+    return std::array<std::string_view, sizeof...(member)>{
+        sqlType<std::remove_cvref_t<decltype(hana::second(member)(
+            std::declval<T &>()))>>()...};
+  });
+}
+
+template <typename T, FixedString Column> constexpr size_t columnIndex() {
+  constexpr auto names = columnNames<T>();
+  constexpr auto idx = std::ranges::find(names, Column.view()) - names.begin();
+  static_assert(idx < names.size(), "Unknown column");
+  return idx;
+}
+
+// Плейсхолдер вида $N::type
+constexpr void appendParam(std::string &out, size_t number,
+                           std::string_view type) {
+  std::string digits;
+  do {
+    digits.insert(digits.begin(), char('0' + number % 10));
+    number /= 10;
+  } while (number != 0);
+  out += '$';
+  out += digits;
+  out += "::";
+  out += type;
+}
+
+constexpr void appendJoined(std::string &out,
+                            std::span<const std::string_view> names) {
+  for (size_t idx = 0; idx < names.size(); ++idx) {
+    if (idx != 0) {
+      out += ", ";
+    }
+    out += names[idx];
+  }
+}
+
+// Переносит строку, собранную в constexpr-контексте, в статический массив
+template <auto Build> constexpr auto freeze() {
+  constexpr size_t size = Build().size();
+  std::array<char, size + 1> out{};
+  auto text = Build();
+  std::ranges::copy(text, out.begin());
+  return out;
+}
+
+template <auto Build> inline constexpr auto kFrozen = freeze<Build>();
+
+template <auto Build> constexpr std::string_view frozen() {
+  return {kFrozen<Build>.data(), kFrozen<Build>.size() - 1};
+}
+
+template <typename V> void bind(pqxx::params &params, const V &value) {
+  if constexpr (std::is_same_v<V, std::string>) {
+    // Без копии: строка должна пережить запрос
+    params.append(pqxx::zview(value));
+  } else {
+    params.append(value);
+  }
+}
+} // namespace detail
+
+/**
+ * @brief Таблица @p Name, строки которой описываются структурой @p T
+ *
+ * @warning Строковые параметры привязываются по ссылке, поэтому объект,
+ * из которого построен запрос, должен пережить его выполнение.
+ */
+template <FixedString Name, typename T> struct TypedTable {
+  using Row = T;
+  static constexpr auto kColumns = detail::columnNames<T>();
+  static constexpr auto kTypes = detail::columnTypes<T>();
+
+  /// SELECT всех полей структуры
+  static constexpr std::string_view kSelect = detail::frozen<[] {
+    std::string sql = "SELECT ";
+    detail::appendJoined(sql, kColumns);
+    sql += " FROM ";
+    sql += Name.view();
+    return sql;
+  }>();
+
+  /// INSERT всех полей структуры
+  static constexpr std::string_view kInsert = detail::frozen<[] {
+    std::string sql = "INSERT INTO ";
+    sql += Name.view();
+    sql += " (";
+    detail::appendJoined(sql, kColumns);
+    sql += ") VALUES (";
+    for (size_t idx = 0; idx < kTypes.size(); ++idx) {
+      if (idx != 0) {
+        sql += ", ";
+      }
+      detail::appendParam(sql, idx + 1, kTypes[idx]);
+    }
+    sql += ")";
+    return sql;
+  }>();
+
+  /// INSERT, пропускающий строку с уже существующим ключом
+  static constexpr std::string_view kInsertOrSkip = detail::frozen<[] {
+    std::string sql{kInsert};
+    sql += " ON CONFLICT DO NOTHING";
+    return sql;
+  }>();
+
+  /// SELECT всех полей структуры с фильтром по колонке @p Column
+  template <FixedString Column>
+  static constexpr std::string_view kSelectWhere = detail::frozen<[] {
+    constexpr auto idx = detail::columnIndex<T, Column>();
+    std::string sql{kSelect};
+    sql += " WHERE ";
+    sql += Column.view();
+    sql += " = ";
+    detail::appendParam(sql, 1, kTypes[idx]);
+    return sql;
+  }>();
+
+  /// DELETE с фильтром по колонке @p Column
+  template <FixedString Column>
+  static constexpr std::string_view kDeleteWhere = detail::frozen<[] {
+    constexpr auto idx = detail::columnIndex<T, Column>();
+    std::string sql = "DELETE FROM ";
+    sql += Name.view();
+    sql += " WHERE ";
+    sql += Column.view();
+    sql += " = ";
+    detail::appendParam(sql, 1, kTypes[idx]);
+    return sql;
+  }>();
+
+  static Query select() {
+    Query query;
+    query.sql = kSelect;
+    return query;
+  }
+
+  static Query insert(const T &object,
+                      OnConflict onConflict = OnConflict::fail) {
+    Query query;
+    query.sql = onConflict == OnConflict::skip ? kInsertOrSkip : kInsert;
+    query.params.reserve(kColumns.size());
+    hana::for_each(hana::accessors<T>(), [&](auto &&member) {
+      detail::bind(query.params, hana::second(member)(object));
+    });
+    return query;
+  }
+
+  template <FixedString Column, typename V>
+  static Query selectWhere(const V &value) {
+    Query query;
+    query.sql = kSelectWhere<Column>;
+    detail::bind(query.params, value);
+    return query;
+  }
+
+  template <FixedString Column, typename V>
+  static Query deleteWhere(const V &value) {
+    Query query;
+    query.sql = kDeleteWhere<Column>;
+    detail::bind(query.params, value);
+    return query;
+  }
+
+  /**
+   * @brief Разбирает строку результата в структуру
+   *
+   * Колонки читаются по позиции, поэтому запрос должен выбирать их в порядке
+   * полей структуры (как это делает kSelect).
+   */
+  static T decode(const pqxx::row &row) {
+    T object{};
+    pqxx::row::size_type idx = 0;
+    hana::for_each(hana::accessors<T>(), [&](auto &&member) {
+      auto &field = hana::second(member)(object);
+      field = row[idx++].template as<std::remove_cvref_t<decltype(field)>>();
+    });
+    return object;
+  }
+
+  static std::vector<T> fetch(AbstractDatabase &db, Query query) {
+    std::vector<T> result;
+    db.fetchRows(std::move(query), [&result](const pqxx::row &row) {
+      result.push_back(decode(row));
+    });
+    return result;
+  }
+};
+} // namespace database
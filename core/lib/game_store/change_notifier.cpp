@@ -0,0 +1,58 @@
+#include "change_notifier.hpp"
+
+namespace asio = boost::asio;
+
+namespace core {
+asio::awaitable<bool>
+ChangeNotifier::wait(const boost::uuids::uuid &game,
+                     std::function<bool()> changed,
+                     std::chrono::milliseconds timeout) {
+  auto waiter = std::make_shared<Waiter>(co_await asio::this_coro::executor);
+  waiter->timer.expires_after(timeout);
+  {
+    std::lock_guard lock(mutex_);
+    waiters_[game].insert(waiter);
+    ++waiting_;
+  }
+  if (!changed()) {
+    // Истёкший таймер или отмена — оба исхода нас устраивают
+    co_await waiter->timer.async_wait(asio::as_tuple(asio::use_awaitable));
+  }
+  {
+    std::lock_guard lock(mutex_);
+    if (auto it = waiters_.find(game); it != waiters_.end()) {
+      waiting_ -= it->second.erase(waiter);
+      if (it->second.empty()) {
+        waiters_.erase(it);
+      }
+    }
+  }
+  co_return changed();
+}
+
+void ChangeNotifier::notify(const boost::uuids::uuid &game) {
+  Waiters woken;
+  {
+    std::lock_guard lock(mutex_);
+    auto it = waiters_.find(game);
+    if (it == waiters_.end()) {
+      return;
+    }
+    woken = std::move(it->second);
+    waiters_.erase(it);
+    waiting_ -= woken.size();
+  }
+  for (auto &&waiter : woken) {
+    // Срок в прошлом, а не cancel(): если корутина ещё не успела
+    // заснуть, её async_wait завершится сразу
+    asio::post(waiter->timer.get_executor(), [waiter] {
+      waiter->timer.expires_at(asio::steady_timer::time_point::min());
+    });
+  }
+}
+
+size_t ChangeNotifier::waiting() const {
+  std::lock_guard lock(mutex_);
+  return waiting_;
+}
+} // namespace core
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/container_hash/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace core {
+/**
+ * @brief Парковка запросов до изменения игры (long-poll)
+ *
+ * Ожидающий запрос — это корутина, спящая на собственном steady_timer:
+ * ни потока, ни сокета на ожидание не тратится, только кадр корутины и
+ * таймер. notify будит всех ожидающих игры, переводя их таймеры в прошлое.
+ */
+struct ChangeNotifier {
+  /**
+   * @brief Ждёт, пока changed() не станет истинным, но не дольше timeout
+   *
+   * changed() проверяется после регистрации ожидания, поэтому изменение,
+   * случившееся между проверкой клиента и парковкой, не теряется.
+   *
+   * @return Значение changed() после пробуждения
+   */
+  boost::asio::awaitable<bool> wait(const boost::uuids::uuid &game,
+                                    std::function<bool()> changed,
+                                    std::chrono::milliseconds timeout);
+
+  /// Будит все запросы, ожидающие изменения игры
+  void notify(const boost::uuids::uuid &game);
+
+  /// Сколько запросов сейчас припарковано
+  size_t waiting() const;
+
+private:
+  struct Waiter {
+    explicit Waiter(boost::asio::any_io_executor executor)
+        : timer(std::move(executor)) {}
+    boost::asio::steady_timer timer;
+  };
+  using Waiters = std::unordered_set<std::shared_ptr<Waiter>>;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<boost::uuids::uuid, Waiters,
+                     boost::hash<boost::uuids::uuid>>
+      waiters_;
+  size_t waiting_ = 0;
+};
+} // namespace core
@@ -0,0 +1,313 @@
+#include "game_engine.hpp"
+#include "ids.hpp"
+#include "typed_query.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace core {
+namespace {
+struct GamePlayerRow {
+  BOOST_HANA_DEFINE_STRUCT(GamePlayerRow, (boost::uuids::uuid, game_player_id),
+                           (boost::uuids::uuid, game_id),
+                           (boost::uuids::uuid, player_id), (int32_t, color_id),
+                           (int32_t, score), (bool, is_host));
+};
+using GamePlayers = database::TypedTable<"game_players", GamePlayerRow>;
+
+struct RoundCardRow {
+  BOOST_HANA_DEFINE_STRUCT(RoundCardRow, (boost::uuids::uuid, round_card_id),
+                           (boost::uuids::uuid, round_id),
+                           (boost::uuids::uuid, game_player_id),
+                           (boost::uuids::uuid, card_id));
+};
+using RoundCards = database::TypedTable<"round_cards", RoundCardRow>;
+
+struct MoveRow {
+  BOOST_HANA_DEFINE_STRUCT(MoveRow, (boost::uuids::uuid, move_id),
+                           (boost::uuids::uuid, round_id),
+                           (boost::uuids::uuid, voter_id),
+                           (boost::uuids::uuid, chosen_card_id));
+};
+using Moves = database::TypedTable<"moves", MoveRow>;
+
+struct ScoreRow {
+  BOOST_HANA_DEFINE_STRUCT(ScoreRow, (boost::uuids::uuid, score_id),
+                           (boost::uuids::uuid, game_player_id),
+                           (boost::uuids::uuid, round_id), (int32_t, points));
+};
+using Scores = database::TypedTable<"scores", ScoreRow>;
+} // namespace
+
+const GameState::Player &GameState::join(const boost::uuids::uuid &playerId) {
+  if (round.number != 0) {
+    throw GameRuleError("game already started");
+  }
+  if (std::ranges::any_of(players, [&](auto &&player) {
+        return player.playerId == playerId;
+      })) {
+    throw GameRuleError("player already joined");
+  }
+  if (players.size() == kMaxPlayers) {
+    throw GameRuleError("game is full");
+  }
+  apply(events::Joined{.gamePlayerId = ids::generateV7(), .playerId = playerId});
+  return players.back();
+}
+
+const GameState::Round &
+GameState::startRound(const boost::uuids::uuid &narratorId,
+                      const boost::uuids::uuid &cardId, std::string clue) {
+  if (phase != Phase::lobby) {
+    throw GameRuleError("round in progress");
+  }
+  if (players.size() < kMinPlayers) {
+    throw GameRuleError("not enough players");
+  }
+  if (nextNarrator().gamePlayerId != narratorId) {
+    throw GameRuleError("not your turn to narrate");
+  }
+  apply(events::RoundStarted{.roundId = ids::generateV7(),
+                             .narratorId = narratorId,
+                             .roundCardId = ids::generateV7(),
+                             .cardId = cardId,
+                             .clue = std::move(clue)});
+  return round;
+}
+
+const GameState::Card &
+GameState::playCard(const boost::uuids::uuid &gamePlayerId,
+                    const boost::uuids::uuid &cardId) {
+  if (phase != Phase::playing) {
+    throw GameRuleError("no round to play a card in");
+  }
+  if (!findPlayer(gamePlayerId)) {
+    throw GameRuleError("unknown player");
+  }
+  if (std::ranges::any_of(cards, [&](auto &&card) {
+        return card.gamePlayerId == gamePlayerId or card.cardId == cardId;
+      })) {
+    throw GameRuleError("card already played");
+  }
+  apply(events::CardPlayed{.roundCardId = ids::generateV7(),
+                           .gamePlayerId = gamePlayerId,
+                           .cardId = cardId});
+  return cards.back();
+}
+
+bool GameState::vote(const boost::uuids::uuid &voterId,
+                     const boost::uuids::uuid &roundCardId) {
+  if (phase != Phase::voting) {
+    throw GameRuleError("voting is not open");
+  }
+  if (!findPlayer(voterId)) {
+    throw GameRuleError("unknown player");
+  }
+  if (voterId == round.narratorId) {
+    throw GameRuleError("narrator does not vote");
+  }
+  if (std::ranges::any_of(
+          votes, [&](auto &&vote) { return vote.voterId == voterId; })) {
+    throw GameRuleError("already voted");
+  }
+  auto card = std::ranges::find_if(
+      cards, [&](auto &&card) { return card.roundCardId == roundCardId; });
+  if (card == cards.end()) {
+    throw GameRuleError("unknown card");
+  }
+  if (card->gamePlayerId == voterId) {
+    throw GameRuleError("cannot vote for own card");
+  }
+  apply(events::Voted{.voterId = voterId, .roundCardId = roundCardId});
+  return phase == Phase::lobby;
+}
+
+void GameState::apply(const GameChange &change) {
+  std::visit([this](auto &&change) { applyChange(change); }, change);
+  changes_.push_back(change);
+}
+
+void GameState::replay(const GameChange &change) {
+  onConflict_ = database::OnConflict::skip;
+  apply(change);
+  onConflict_ = database::OnConflict::fail;
+}
+
+void GameState::applyChange(const events::Joined &change) {
+  // Первый свободный цвет
+  int32_t colorId = 1;
+  while (std::ranges::any_of(players, [&](auto &&player) {
+    return player.colorId == colorId;
+  })) {
+    ++colorId;
+  }
+  auto &player = players.emplace_back(Player{.gamePlayerId = change.gamePlayerId,
+                                             .playerId = change.playerId,
+                                             .colorId = colorId,
+                                             .score = 0,
+                                             .isHost = players.empty()});
+  writes_.push_back(GamePlayers::insert(
+      GamePlayerRow{
+          .game_player_id = player.gamePlayerId,
+          .game_id = gameId,
+          .player_id = player.playerId,
+          .color_id = player.colorId,
+          .score = player.score,
+          .is_host = player.isHost,
+      },
+      onConflict_));
+}
+
+void GameState::applyChange(const events::RoundStarted &change) {
+  round = Round{.roundId = change.roundId,
+                .number = round.number + 1,
+                .narratorId = change.narratorId,
+                .clue = change.clue};
+  phase = Phase::playing;
+  cards.clear();
+  votes.clear();
+  if (round.number == 1) {
+    writes_.push_back(database::QueryBuilder().generic(
+        "UPDATE games SET status_id = $1, updated_at = NOW() "
+        "WHERE game_id = $2",
+        {kActiveStatus, gameId}));
+  }
+  // Подсказка копируется в параметры: запрос переживёт это состояние
+  writes_.push_back(database::QueryBuilder{.onConflict = onConflict_}.insert(
+      "rounds", {{"round_id", round.roundId},
+                 {"game_id", gameId},
+                 {"round_number", round.number},
+                 {"narrator_id", round.narratorId},
+                 {"clue", round.clue}}));
+  applyChange(events::CardPlayed{.roundCardId = change.roundCardId,
+                                 .gamePlayerId = change.narratorId,
+                                 .cardId = change.cardId});
+}
+
+void GameState::applyChange(const events::CardPlayed &change) {
+  auto &card = cards.emplace_back(Card{.roundCardId = change.roundCardId,
+                                       .gamePlayerId = change.gamePlayerId,
+                                       .cardId = change.cardId});
+  writes_.push_back(RoundCards::insert(
+      RoundCardRow{
+          .round_card_id = card.roundCardId,
+          .round_id = round.roundId,
+          .game_player_id = card.gamePlayerId,
+          .card_id = card.cardId,
+      },
+      onConflict_));
+  if (cards.size() == players.size()) {
+    phase = Phase::voting;
+  }
+}
+
+void GameState::applyChange(const events::Voted &change) {
+  votes.push_back(
+      Vote{.voterId = change.voterId, .roundCardId = change.roundCardId});
+  writes_.push_back(Moves::insert(
+      MoveRow{
+          .move_id = ids::generateV7(),
+          .round_id = round.roundId,
+          .voter_id = change.voterId,
+          .chosen_card_id = change.roundCardId,
+      },
+      onConflict_));
+  if (votes.size() + 1 < players.size()) {
+    return;
+  }
+  score();
+  phase = Phase::lobby;
+}
+
+void GameState::score() {
+  auto narratorCard = std::ranges::find_if(cards, [this](auto &&card) {
+    return card.gamePlayerId == round.narratorId;
+  });
+  auto owner = [this](const boost::uuids::uuid &roundCardId) {
+    return std::ranges::find_if(cards, [&](auto &&card) {
+             return card.roundCardId == roundCardId;
+           })->gamePlayerId;
+  };
+  size_t correct = std::ranges::count_if(votes, [&](auto &&vote) {
+    return vote.roundCardId == narratorCard->roundCardId;
+  });
+  // Все или никто не угадали: ведущему 0, остальным по 2.
+  // Иначе ведущему и угадавшим по 3.
+  bool everyoneOrNobody = correct == 0 or correct == votes.size();
+  std::vector<int32_t> points(players.size(), 0);
+  for (size_t idx = 0; idx < players.size(); ++idx) {
+    auto &&id = players[idx].gamePlayerId;
+    if (id == round.narratorId) {
+      points[idx] = everyoneOrNobody ? 0 : 3;
+      continue;
+    }
+    auto vote = std::ranges::find_if(
+        votes, [&](auto &&vote) { return vote.voterId == id; });
+    if (everyoneOrNobody) {
+      points[idx] = 2;
+    } else if (vote != votes.end() and
+               vote->roundCardId == narratorCard->roundCardId) {
+      points[idx] = 3;
+    }
+    // И по очку за каждый голос, отданный за свою карту
+    points[idx] += std::ranges::count_if(
+        votes, [&](auto &&vote) { return owner(vote.roundCardId) == id; });
+  }
+  for (size_t idx = 0; idx < players.size(); ++idx) {
+    auto &player = players[idx];
+    player.score += points[idx];
+    writes_.push_back(Scores::insert(
+        ScoreRow{
+            .score_id = ids::generateV7(),
+            .game_player_id = player.gamePlayerId,
+            .round_id = round.roundId,
+            .points = points[idx],
+        },
+        onConflict_));
+    if (points[idx] != 0) {
+      writes_.push_back(database::QueryBuilder().generic(
+          "UPDATE game_players SET score = $1 WHERE game_player_id = $2",
+          {player.score, player.gamePlayerId}));
+    }
+  }
+}
+
+const GameState::Player &GameState::nextNarrator() const {
+  if (players.empty()) {
+    throw GameRuleError("no players");
+  }
+  return players[round.number % players.size()];
+}
+
+std::vector<database::Query> GameState::takeWrites() {
+  // Все команды игры лежат в её шарде
+  for (auto &&write : writes_) {
+    write.shardKey = gameId;
+  }
+  return std::exchange(writes_, {});
+}
+
+std::vector<GameChange> GameState::takeChanges() {
+  return std::exchange(changes_, {});
+}
+
+const GameState::Player *
+GameState::findPlayer(const boost::uuids::uuid &gamePlayerId) const {
+  auto it = std::ranges::find_if(players, [&](auto &&player) {
+    return player.gamePlayerId == gamePlayerId;
+  });
+  return it == players.end() ? nullptr : &*it;
+}
+
+std::string_view phaseName(GameState::Phase phase) {
+  switch (phase) {
+  case GameState::Phase::lobby:
+    return "lobby";
+  case GameState::Phase::playing:
+    return "playing";
+  case GameState::Phase::voting:
+    return "voting";
+  }
+  return "unknown";
+}
+} // namespace core
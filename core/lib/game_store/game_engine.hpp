@@ -0,0 +1,199 @@
+#pragma once
+
+#include <boost/uuid/uuid.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "query_builder.hpp"
+
+namespace core {
+/**
+ * @brief Ход, нарушающий правила: не в свою фазу, повторный голос и т. п.
+ */
+struct GameRuleError : std::logic_error {
+  using std::logic_error::logic_error;
+};
+
+/**
+ * @brief Изменения игры: их пишет журнал и переигрывает восстановление
+ *
+ * Идентификаторы строк сгенерированы заранее и лежат в самом изменении,
+ * поэтому повторное применение даёт в точности то же состояние.
+ */
+namespace events {
+struct Created {};
+struct Joined {
+  boost::uuids::uuid gamePlayerId;
+  boost::uuids::uuid playerId;
+};
+struct RoundStarted {
+  boost::uuids::uuid roundId;
+  boost::uuids::uuid narratorId;
+  boost::uuids::uuid roundCardId;
+  boost::uuids::uuid cardId;
+  std::string clue;
+};
+struct CardPlayed {
+  boost::uuids::uuid roundCardId;
+  boost::uuids::uuid gamePlayerId;
+  boost::uuids::uuid cardId;
+};
+// Подсчёт очков детерминирован и происходит при последнем голосе
+struct Voted {
+  boost::uuids::uuid voterId;
+  boost::uuids::uuid roundCardId;
+};
+struct Deleted {};
+} // namespace events
+
+using GameChange =
+    std::variant<events::Created, events::Joined, events::RoundStarted,
+                 events::CardPlayed, events::Voted, events::Deleted>;
+
+/**
+ * @brief Авторитетное состояние активной игры в памяти (правила Dixit)
+ *
+ * Игроков не больше шести, поэтому всё хранится в небольших векторах
+ * плоских структур и ищется линейным проходом: один-два кэш-промаха вместо
+ * обхода хеш-таблиц. Состояние не потокобезопасно, им владеет strand игры.
+ *
+ * Ход проверяет правила, оформляет изменение (GameChange) и применяет его.
+ * Применённые изменения забирает takeChanges() для журнала, а команды для
+ * базы — takeWrites(): GameStore отправляет их асинхронно (write-behind).
+ * Идентификаторы строк генерируются здесь же, поэтому ответ клиенту не ждёт
+ * базу.
+ */
+struct GameState {
+  enum class Phase : uint8_t {
+    // Набор игроков или пауза между раундами
+    lobby,
+    // Ведущий загадал карту, игроки выкладывают свои
+    playing,
+    // Все карты выложены, идёт голосование
+    voting,
+  };
+
+  struct Player {
+    boost::uuids::uuid gamePlayerId;
+    boost::uuids::uuid playerId;
+    int32_t colorId;
+    int32_t score;
+    bool isHost;
+  };
+
+  struct Card {
+    boost::uuids::uuid roundCardId;
+    boost::uuids::uuid gamePlayerId;
+    boost::uuids::uuid cardId;
+  };
+
+  struct Vote {
+    boost::uuids::uuid voterId;
+    boost::uuids::uuid roundCardId;
+  };
+
+  struct Round {
+    boost::uuids::uuid roundId;
+    int32_t number = 0;
+    boost::uuids::uuid narratorId;
+    std::string clue;
+  };
+
+  // Цветов в player_colors шесть, меньше трёх игроков в Dixit не играют
+  static constexpr size_t kMaxPlayers = 6;
+  static constexpr size_t kMinPlayers = 3;
+  // game_statuses: 'active'
+  static constexpr int32_t kActiveStatus = 2;
+
+  explicit GameState(boost::uuids::uuid gameId) : gameId(gameId) {}
+
+  /**
+   * @brief Добавляет игрока в игру
+   *
+   * @throws GameRuleError если игра уже идёт, мест нет или игрок уже в игре
+   */
+  const Player &join(const boost::uuids::uuid &playerId);
+
+  /**
+   * @brief Ведущий начинает раунд: выкладывает карту и загадывает ассоциацию
+   *
+   * Ведущие сменяются по кругу в порядке присоединения.
+   *
+   * @throws GameRuleError если ходит не тот игрок или раунд уже идёт
+   */
+  const Round &startRound(const boost::uuids::uuid &narratorId,
+                          const boost::uuids::uuid &cardId, std::string clue);
+
+  /**
+   * @brief Игрок выкладывает карту; последняя карта открывает голосование
+   *
+   * @throws GameRuleError если карта уже выложена или раунд не идёт
+   */
+  const Card &playCard(const boost::uuids::uuid &gamePlayerId,
+                       const boost::uuids::uuid &cardId);
+
+  /**
+   * @brief Игрок голосует за карту; последний голос завершает раунд
+   *
+   * @return true, если раунд подсчитан
+   * @throws GameRuleError если голосует ведущий, голос повторный или за
+   * собственную карту
+   */
+  bool vote(const boost::uuids::uuid &voterId,
+            const boost::uuids::uuid &roundCardId);
+
+  /**
+   * @brief Применяет уже проверенное изменение
+   *
+   * Через него проходят и живые ходы, и восстановление из журнала.
+   * Created и Deleted касаются игры целиком и здесь ничего не меняют.
+   */
+  void apply(const GameChange &change);
+
+  /**
+   * @brief Применяет изменение из журнала
+   *
+   * Его строки могли успеть попасть в базу до падения, поэтому вставки
+   * пропускают уже существующие.
+   */
+  void replay(const GameChange &change);
+
+  /// Ведущий следующего раунда
+  const Player &nextNarrator() const;
+
+  /// Забирает накопленные команды для базы
+  std::vector<database::Query> takeWrites();
+
+  /// Забирает применённые изменения
+  std::vector<GameChange> takeChanges();
+
+  const Player *findPlayer(const boost::uuids::uuid &gamePlayerId) const;
+
+  boost::uuids::uuid gameId;
+  Phase phase = Phase::lobby;
+  Round round;
+  std::vector<Player> players;
+  std::vector<Card> cards;
+  std::vector<Vote> votes;
+
+private:
+  void applyChange(const events::Created &) {}
+  void applyChange(const events::Joined &change);
+  void applyChange(const events::RoundStarted &change);
+  void applyChange(const events::CardPlayed &change);
+  void applyChange(const events::Voted &change);
+  void applyChange(const events::Deleted &) {}
+  void score();
+
+  std::vector<database::Query> writes_;
+  std::vector<GameChange> changes_;
+  database::OnConflict onConflict_ = database::OnConflict::fail;
+};
+
+/// Имя фазы для API: "lobby", "playing", "voting"
+std::string_view phaseName(GameState::Phase phase);
+} // namespace core
@@ -0,0 +1,556 @@
+#include "game_log.hpp"
+
+#include <boost/crc.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace interprocess = boost::interprocess;
+namespace fs = std::filesystem;
+
+namespace core {
+namespace {
+constexpr std::string_view kSnapshotMagic = "RNRSNAP1";
+constexpr std::string_view kSnapshotName = "snapshot.bin";
+constexpr std::string_view kSegmentPrefix = "segment-";
+constexpr std::string_view kSegmentSuffix = ".log";
+// Длина тела и его CRC32
+constexpr size_t kFrameHeader = 2 * sizeof(uint32_t);
+
+enum class Record : uint8_t {
+  created,
+  joined,
+  roundStarted,
+  cardPlayed,
+  voted,
+  deleted,
+  state,
+};
+
+struct Encoder {
+  template <typename T> void raw(const T &value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+  void u8(uint8_t value) { out.push_back(char(value)); }
+  void id(const boost::uuids::uuid &uuid) {
+    out.append(reinterpret_cast<const char *>(&*uuid.begin()), uuid.size());
+  }
+  void str(std::string_view text) {
+    raw(uint32_t(text.size()));
+    out.append(text);
+  }
+
+  std::string &out;
+};
+
+struct Decoder {
+  template <typename T> T raw() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)).data(), sizeof(T));
+    return value;
+  }
+  uint8_t u8() { return raw<uint8_t>(); }
+  boost::uuids::uuid id() {
+    boost::uuids::uuid uuid;
+    auto bytes = take(uuid.size());
+    std::copy(bytes.begin(), bytes.end(), uuid.begin());
+    return uuid;
+  }
+  std::string str() { return std::string(take(raw<uint32_t>())); }
+
+  std::string_view take(size_t size) {
+    if (in.size() < size) {
+      throw std::runtime_error("truncated log record");
+    }
+    auto bytes = in.substr(0, size);
+    in.remove_prefix(size);
+    return bytes;
+  }
+
+  std::string_view in;
+};
+
+void encode(Encoder &out, const events::Created &) {
+  out.u8(uint8_t(Record::created));
+}
+void encode(Encoder &out, const events::Joined &change) {
+  out.u8(uint8_t(Record::joined));
+  out.id(change.gamePlayerId);
+  out.id(change.playerId);
+}
+void encode(Encoder &out, const events::RoundStarted &change) {
+  out.u8(uint8_t(Record::roundStarted));
+  out.id(change.roundId);
+  out.id(change.narratorId);
+  out.id(change.roundCardId);
+  out.id(change.cardId);
+  out.str(change.clue);
+}
+void encode(Encoder &out, const events::CardPlayed &change) {
+  out.u8(uint8_t(Record::cardPlayed));
+  out.id(change.roundCardId);
+  out.id(change.gamePlayerId);
+  out.id(change.cardId);
+}
+void encode(Encoder &out, const events::Voted &change) {
+  out.u8(uint8_t(Record::voted));
+  out.id(change.voterId);
+  out.id(change.roundCardId);
+}
+void encode(Encoder &out, const events::Deleted &) {
+  out.u8(uint8_t(Record::deleted));
+}
+
+void encode(Encoder &out, const GameState &state) {
+  out.u8(uint8_t(Record::state));
+  out.u8(uint8_t(state.phase));
+  out.id(state.round.roundId);
+  out.raw(state.round.number);
+  out.id(state.round.narratorId);
+  out.str(state.round.clue);
+  out.u8(uint8_t(state.players.size()));
+  for (auto &&player : state.players) {
+    out.id(player.gamePlayerId);
+    out.id(player.playerId);
+    out.raw(player.colorId);
+    out.raw(player.score);
+    out.u8(player.isHost);
+  }
+  out.u8(uint8_t(state.cards.size()));
+  for (auto &&card : state.cards) {
+    out.id(card.roundCardId);
+    out.id(card.gamePlayerId);
+    out.id(card.cardId);
+  }
+  out.u8(uint8_t(state.votes.size()));
+  for (auto &&vote : state.votes) {
+    out.id(vote.voterId);
+    out.id(vote.roundCardId);
+  }
+}
+
+GameState decodeState(Decoder &in, const boost::uuids::uuid &game) {
+  GameState state(game);
+  state.phase = GameState::Phase(in.u8());
+  state.round.roundId = in.id();
+  state.round.number = in.raw<int32_t>();
+  state.round.narratorId = in.id();
+  state.round.clue = in.str();
+  state.players.resize(in.u8());
+  for (auto &player : state.players) {
+    player.gamePlayerId = in.id();
+    player.playerId = in.id();
+    player.colorId = in.raw<int32_t>();
+    player.score = in.raw<int32_t>();
+    player.isHost = in.u8() != 0;
+  }
+  state.cards.resize(in.u8());
+  for (auto &card : state.cards) {
+    card.roundCardId = in.id();
+    card.gamePlayerId = in.id();
+    card.cardId = in.id();
+  }
+  state.votes.resize(in.u8());
+  for (auto &vote : state.votes) {
+    vote.voterId = in.id();
+    vote.roundCardId = in.id();
+  }
+  return state;
+}
+
+GameChange decodeChange(Record kind, Decoder &in) {
+  switch (kind) {
+  case Record::created:
+    return events::Created{};
+  case Record::joined:
+    return events::Joined{.gamePlayerId = in.id(), .playerId = in.id()};
+  case Record::roundStarted:
+    return events::RoundStarted{.roundId = in.id(),
+                                .narratorId = in.id(),
+                                .roundCardId = in.id(),
+                                .cardId = in.id(),
+                                .clue = in.str()};
+  case Record::cardPlayed:
+    return events::CardPlayed{
+        .roundCardId = in.id(), .gamePlayerId = in.id(), .cardId = in.id()};
+  case Record::voted:
+    return events::Voted{.voterId = in.id(), .roundCardId = in.id()};
+  case Record::deleted:
+    return events::Deleted{};
+  default:
+    throw std::runtime_error("unknown log record");
+  }
+}
+
+// Заполняет заголовок записи, начатой в out на позиции frameStart
+void frame(std::string &out, size_t frameStart) {
+  auto bodyStart = frameStart + kFrameHeader;
+  uint32_t length = out.size() - bodyStart;
+  boost::crc_32_type crc;
+  crc.process_bytes(out.data() + bodyStart, length);
+  uint32_t checksum = crc.checksum();
+  std::memcpy(out.data() + frameStart, &length, sizeof(length));
+  std::memcpy(out.data() + frameStart + sizeof(length), &checksum,
+              sizeof(checksum));
+}
+
+template <typename Body>
+void appendRecord(std::string &out, const boost::uuids::uuid &game,
+                  const Body &body) {
+  auto frameStart = out.size();
+  out.resize(frameStart + kFrameHeader);
+  Encoder encoder{out};
+  encoder.id(game);
+  encode(encoder, body);
+  frame(out, frameStart);
+}
+
+/**
+ * @brief Применяет записи из буфера к играм
+ *
+ * Останавливается на нулевой длине или на записи с неверной CRC.
+ *
+ * @return Число применённых записей
+ */
+size_t replayRecords(std::string_view records, GameLog::Games &games,
+                     std::vector<database::Query> *writes) {
+  size_t applied = 0;
+  while (records.size() >= kFrameHeader) {
+    uint32_t length;
+    uint32_t checksum;
+    std::memcpy(&length, records.data(), sizeof(length));
+    std::memcpy(&checksum, records.data() + sizeof(length), sizeof(checksum));
+    if (length == 0 or records.size() - kFrameHeader < length) {
+      break;
+    }
+    auto body = records.substr(kFrameHeader, length);
+    boost::crc_32_type crc;
+    crc.process_bytes(body.data(), body.size());
+    if (crc.checksum() != checksum) {
+      BOOST_LOG_TRIVIAL(warning)
+          << "[Журнал] Оборванная запись, дальше не читаю" << std::endl;
+      break;
+    }
+    records.remove_prefix(kFrameHeader + length);
+    ++applied;
+
+    Decoder in{body};
+    auto game = in.id();
+    auto kind = Record(in.u8());
+    if (kind == Record::state) {
+      games.insert_or_assign(game, decodeState(in, game));
+      continue;
+    }
+    if (kind == Record::created) {
+      games.try_emplace(game, game);
+      continue;
+    }
+    if (kind == Record::deleted) {
+      games.erase(game);
+      continue;
+    }
+    auto it = games.find(game);
+    if (it == games.end()) {
+      continue;
+    }
+    auto &state = it->second;
+    state.replay(decodeChange(kind, in));
+    state.takeChanges();
+    auto stateWrites = state.takeWrites();
+    if (writes) {
+      std::ranges::move(stateWrites, std::back_inserter(*writes));
+    }
+  }
+  return applied;
+}
+
+std::string readFile(const fs::path &path) {
+  std::ifstream file(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
+}
+
+fs::path segmentPath(const fs::path &directory, uint64_t seq) {
+  char digits[20];
+  auto [end, ec] = std::to_chars(std::begin(digits), std::end(digits), seq);
+  std::string name(kSegmentPrefix);
+  // Нули слева: имена сортируются так же, как номера
+  name.append(std::end(digits) - end, '0');
+  name.append(digits, end);
+  name.append(kSegmentSuffix);
+  return directory / name;
+}
+
+// Номера сегментов в каталоге шарда по возрастанию
+std::vector<uint64_t> listSegments(const fs::path &directory) {
+  std::vector<uint64_t> seqs;
+  for (auto &&entry : fs::directory_iterator(directory)) {
+    auto name = entry.path().filename().string();
+    if (!name.starts_with(kSegmentPrefix) or !name.ends_with(kSegmentSuffix)) {
+      continue;
+    }
+    uint64_t seq = 0;
+    auto digits = std::string_view(name).substr(
+        kSegmentPrefix.size(),
+        name.size() - kSegmentPrefix.size() - kSegmentSuffix.size());
+    if (std::from_chars(digits.begin(), digits.end(), seq).ec == std::errc{}) {
+      seqs.push_back(seq);
+    }
+  }
+  std::ranges::sort(seqs);
+  return seqs;
+}
+
+// Снимок: магия, номер последнего свёрнутого сегмента, записи состояний
+uint64_t readSnapshot(const fs::path &directory, GameLog::Games &games) {
+  auto path = directory / kSnapshotName;
+  if (!fs::exists(path)) {
+    return 0;
+  }
+  auto content = readFile(path);
+  std::string_view view(content);
+  if (!view.starts_with(kSnapshotMagic)) {
+    throw std::runtime_error("corrupt snapshot " + path.string());
+  }
+  view.remove_prefix(kSnapshotMagic.size());
+  Decoder in{view};
+  auto lastSeq = in.raw<uint64_t>();
+  replayRecords(in.in, games, nullptr);
+  return lastSeq;
+}
+
+void writeSnapshot(const fs::path &directory, const GameLog::Games &games,
+                   uint64_t lastSeq) {
+  std::string content(kSnapshotMagic);
+  Encoder{content}.raw(lastSeq);
+  for (auto &&[game, state] : games) {
+    appendRecord(content, game, state);
+  }
+  // Новый снимок появляется атомарно, старый остаётся целым до rename
+  auto temporary = directory / (std::string(kSnapshotName) + ".tmp");
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), content.size());
+    if (!file.flush()) {
+      throw std::runtime_error("failed to write " + temporary.string());
+    }
+  }
+  fs::rename(temporary, directory / kSnapshotName);
+}
+
+size_t replaySegment(const fs::path &path, GameLog::Games &games,
+                     std::vector<database::Query> *writes) {
+  interprocess::file_mapping file(path.c_str(), interprocess::read_only);
+  interprocess::mapped_region region(file, interprocess::read_only);
+  return replayRecords(
+      {static_cast<const char *>(region.get_address()), region.get_size()},
+      games, writes);
+}
+} // namespace
+
+struct GameLog::Segment {
+  Segment(fs::path path, uint64_t seq, size_t bytes)
+      : path(std::move(path)), seq(seq) {
+    {
+      // Файл заранее заполнен нулями: нулевая длина — конец журнала
+      std::ofstream create(this->path, std::ios::binary | std::ios::trunc);
+    }
+    fs::resize_file(this->path, bytes);
+    file = interprocess::file_mapping(this->path.c_str(),
+                                      interprocess::read_write);
+    region = interprocess::mapped_region(file, interprocess::read_write);
+  }
+
+  char *data() { return static_cast<char *>(region.get_address()); }
+
+  fs::path path;
+  uint64_t seq;
+  interprocess::file_mapping file;
+  interprocess::mapped_region region;
+  size_t offset = 0;
+};
+
+struct GameLog::Shard {
+  size_t index;
+  fs::path directory;
+  std::mutex mutex;
+  // Открывается при первой записи, после восстановления
+  std::unique_ptr<Segment> active;
+  uint64_t nextSeq = 1;
+  // Закрытые сегменты, ещё не свёрнутые в снимок
+  std::vector<uint64_t> sealed;
+};
+
+GameLog::GameLog(Options options) : options_(std::move(options)) {
+  for (size_t idx = 0; idx < std::max<size_t>(options_.shards, 1); ++idx) {
+    auto shard = std::make_unique<Shard>();
+    shard->index = idx;
+    shard->directory = options_.directory / ("shard-" + std::to_string(idx));
+    fs::create_directories(shard->directory);
+    shard->sealed = listSegments(shard->directory);
+    if (!shard->sealed.empty()) {
+      shard->nextSeq = shard->sealed.back() + 1;
+    }
+    shards_.push_back(std::move(shard));
+  }
+  compactor_ = std::thread([this] { loop(); });
+}
+
+GameLog::~GameLog() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wakeUp_.notify_one();
+  compactor_.join();
+}
+
+size_t GameLog::shardOf(const boost::uuids::uuid &game) const {
+  return boost::hash<boost::uuids::uuid>()(game) % shards_.size();
+}
+
+void GameLog::append(const boost::uuids::uuid &game,
+                     std::span<const GameChange> changes,
+                     const std::function<void()> &afterAppend) {
+  thread_local std::string records;
+  records.clear();
+  for (auto &&change : changes) {
+    std::visit(
+        [&](auto &&change) { appendRecord(records, game, change); }, change);
+  }
+  write(game, records, afterAppend);
+}
+
+void GameLog::appendState(const GameState &state) {
+  thread_local std::string records;
+  records.clear();
+  appendRecord(records, state.gameId, state);
+  write(state.gameId, records, {});
+}
+
+void GameLog::write(const boost::uuids::uuid &game, std::string_view records,
+                     const std::function<void()> &afterAppend) {
+  if (records.size() > options_.segmentBytes) {
+    throw std::length_error("log record does not fit into a segment");
+  }
+  auto &shard = *shards_.at(shardOf(game));
+  std::lock_guard lock(shard.mutex);
+  if (!shard.active or
+      shard.active->offset + records.size() > options_.segmentBytes) {
+    openSegment(shard);
+  }
+  auto &segment = *shard.active;
+  std::memcpy(segment.data() + segment.offset, records.data(), records.size());
+  segment.offset += records.size();
+  if (afterAppend) {
+    afterAppend();
+  }
+}
+
+void GameLog::openSegment(Shard &shard) {
+  if (shard.active) {
+    shard.sealed.push_back(shard.active->seq);
+    shard.active->region.flush(0, shard.active->offset, /*async*/ true);
+    std::lock_guard lock(mutex_);
+    pending_.push_back(shard.index);
+    wakeUp_.notify_one();
+  }
+  auto seq = shard.nextSeq++;
+  shard.active = std::make_unique<Segment>(
+      segmentPath(shard.directory, seq), seq, options_.segmentBytes);
+}
+
+GameLog::Games GameLog::replay(std::vector<database::Query> &writes) {
+  Games games;
+  size_t records = 0;
+  for (auto &&shard : shards_) {
+    std::lock_guard lock(shard->mutex);
+    auto lastSeq = readSnapshot(shard->directory, games);
+    std::vector<uint64_t> unfolded;
+    for (auto seq : shard->sealed) {
+      auto path = segmentPath(shard->directory, seq);
+      if (seq <= lastSeq) {
+        // Свёрнут, но не удалён до падения
+        fs::remove(path);
+        continue;
+      }
+      records += replaySegment(path, games, &writes);
+      unfolded.push_back(seq);
+    }
+    shard->sealed = std::move(unfolded);
+  }
+  BOOST_LOG_TRIVIAL(info) << "[Журнал] Восстановлено игр: " << games.size()
+                          << ", записей журнала: " << records << std::endl;
+  return games;
+}
+
+void GameLog::compact() {
+  std::lock_guard lock(mutex_);
+  for (size_t idx = 0; idx < shards_.size(); ++idx) {
+    pending_.push_back(idx);
+  }
+  wakeUp_.notify_one();
+}
+
+void GameLog::compactShard(size_t idx) {
+  auto &shard = *shards_.at(idx);
+  std::vector<uint64_t> sealed;
+  {
+    std::lock_guard lock(shard.mutex);
+    sealed = shard.sealed;
+  }
+  if (sealed.empty()) {
+    return;
+  }
+  if (options_.durabilityBarrier) {
+    options_.durabilityBarrier();
+  }
+  Games games;
+  auto lastSeq = readSnapshot(shard.directory, games);
+  for (auto seq : sealed) {
+    if (seq > lastSeq) {
+      replaySegment(segmentPath(shard.directory, seq), games, nullptr);
+    }
+  }
+  writeSnapshot(shard.directory, games, sealed.back());
+  for (auto seq : sealed) {
+    fs::remove(segmentPath(shard.directory, seq));
+  }
+  {
+    std::lock_guard lock(shard.mutex);
+    std::erase_if(shard.sealed,
+                  [&](uint64_t seq) { return seq <= sealed.back(); });
+  }
+  BOOST_LOG_TRIVIAL(info) << "[Журнал] Шард " << idx << ": снимок из "
+                          << games.size() << " игр, свёрнуто сегментов "
+                          << sealed.size() << std::endl;
+}
+
+void GameLog::loop() {
+  std::unique_lock lock(mutex_);
+  for (;;) {
+    wakeUp_.wait(lock, [this] { return stopping_ or not pending_.empty(); });
+    if (stopping_) {
+      return;
+    }
+    auto idx = pending_.front();
+    pending_.pop_front();
+    lock.unlock();
+    try {
+      compactShard(idx);
+    } catch (const std::exception &e) {
+      // Сегменты остаются на месте, свёртка повторится со следующим
+      BOOST_LOG_TRIVIAL(error)
+          << "[Журнал] Не удалось свернуть шард " << idx << ": " << e.what()
+          << std::endl;
+    }
+    lock.lock();
+  }
+}
+} // namespace core
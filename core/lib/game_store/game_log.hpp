@@ -0,0 +1,111 @@
+#pragma once
+
+#include <boost/container_hash/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "game_engine.hpp"
+
+namespace core {
+/**
+ * @brief Журнал изменений активных игр (write-ahead log) со снимками
+ *
+ * Состояние активных игр живёт в памяти, а в Postgres уходит с задержкой
+ * (write-behind). Чтобы падение процесса не теряло идущие раунды, каждое
+ * изменение сначала дописывается в журнал своего шарда: это memcpy в
+ * отображённый в память сегмент, без системных вызовов на запись.
+ *
+ * Шард — каталог shard-<N> с сегментами segment-<seq>.log фиксированного
+ * размера и файлом snapshot.bin. Запись сегмента: длина, CRC32 и тело;
+ * нулевая длина означает конец, а запись с неверной CRC (оборванная при
+ * падении) — тоже. Заполненный сегмент закрывается, и фоновый поток
+ * сворачивает закрытые сегменты вместе с прежним снимком в новый снимок,
+ * после чего удаляет их.
+ *
+ * Перед свёрткой вызывается барьер: он должен дождаться, пока все команды
+ * для базы, отправленные при дописывании свёрнутых изменений, дойдут до
+ * Postgres. Тогда после восстановления повторно отправлять в базу нужно
+ * только изменения из несвёрнутых сегментов.
+ *
+ * @warning Формат использует порядок байт машины и переносим только между
+ * одинаковыми архитектурами. Данные переживают падение процесса, но не ОС:
+ * сброс страниц на диск оставлен ядру.
+ */
+struct GameLog {
+  using Games = std::unordered_map<boost::uuids::uuid, GameState,
+                                   boost::hash<boost::uuids::uuid>>;
+
+  struct Options {
+    std::filesystem::path directory;
+    size_t shards = 4;
+    size_t segmentBytes = size_t(64) << 20;
+    // Дожидается, пока отправленные в базу команды будут зафиксированы;
+    // исключение откладывает свёртку до следующего раза
+    std::function<void()> durabilityBarrier;
+  };
+
+  explicit GameLog(Options options);
+  ~GameLog();
+
+  GameLog(const GameLog &) = delete;
+  GameLog &operator=(const GameLog &) = delete;
+
+  /**
+   * @brief Дописывает изменения игры в журнал её шарда
+   *
+   * @param afterAppend Вызывается под замком шарда сразу после записи:
+   * отправленные в нём команды упорядочены относительно закрытия сегмента
+   */
+  void append(const boost::uuids::uuid &game,
+              std::span<const GameChange> changes,
+              const std::function<void()> &afterAppend = {});
+
+  /// Полное состояние игры, загруженной из базы: дальше журнал идёт от него
+  void appendState(const GameState &state);
+
+  /**
+   * @brief Восстанавливает игры из снимков и сегментов всех шардов
+   *
+   * Вызывается до приёма запросов, пока в журнал никто не пишет.
+   *
+   * @param writes Сюда попадают команды для базы из переигранных сегментов:
+   * их могло не успеть донести до Postgres
+   */
+  Games replay(std::vector<database::Query> &writes);
+
+  /// Ставит в очередь свёртку всех закрытых сегментов во всех шардах
+  void compact();
+
+  size_t shardOf(const boost::uuids::uuid &game) const;
+
+private:
+  struct Segment;
+  struct Shard;
+
+  void write(const boost::uuids::uuid &game, std::string_view records,
+             const std::function<void()> &afterAppend);
+  void openSegment(Shard &shard);
+  void compactShard(size_t shard);
+  void loop();
+
+  const Options options_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  std::mutex mutex_;
+  std::condition_variable wakeUp_;
+  std::deque<size_t> pending_;
+  bool stopping_ = false;
+  std::thread compactor_;
+};
+} // namespace core
@@ -1,9 +1,23 @@
 #include "game_store.hpp"
+#include "context_executor.hpp"
+#include "etag.hpp"
+#include "ids.hpp"
+#include "json_writer.hpp"
 #include "query_builder.hpp"
+#include "request_arena.hpp"
 #include "serializer.hpp"
+#include "typed_query.hpp"
 
 #include <boost/json.hpp>
 #include <boost/log/trivial.hpp>
+#include <boost/url/parse.hpp>
+#include <boost/uuid/nil_generator.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <exception>
+#include <map>
+#include <stdexcept>
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -12,42 +26,538 @@ namespace asio = boost::asio;
 using tcp = asio::ip::tcp;
 
 namespace core {
+namespace {
+// 304 Not Modified, если клиент прислал актуальный ETag
+std::optional<AbstractServer::Response>
+notModified(const AbstractServer::Request &req, const std::string &etag) {
+  auto ifNoneMatch = req[http::field::if_none_match];
+  if (ifNoneMatch.empty() or !etagMatches(ifNoneMatch, etag)) {
+    return std::nullopt;
+  }
+  http::response<http::string_body> res{http::status::not_modified,
+                                        req.version()};
+  res.set(http::field::etag, etag);
+  return res;
+}
+
+// Целое из параметра запроса; std::nullopt, если это не число
+std::optional<uint64_t> toNumber(std::string_view text) {
+  uint64_t value = 0;
+  auto [end, ec] = std::from_chars(text.begin(), text.end(), value);
+  if (ec != std::errc{} or end != text.end()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+struct GameRow {
+  BOOST_HANA_DEFINE_STRUCT(GameRow, (boost::uuids::uuid, game_id),
+                           (int32_t, status_id));
+};
+using Games = database::TypedTable<"games", GameRow>;
+
+struct GameIdRow {
+  BOOST_HANA_DEFINE_STRUCT(GameIdRow, (boost::uuids::uuid, game_id));
+};
+using GameIds = database::TypedTable<"games", GameIdRow>;
+
+struct PlayerScoreRow {
+  BOOST_HANA_DEFINE_STRUCT(PlayerScoreRow, (boost::uuids::uuid, game_id),
+                           (boost::uuids::uuid, player_id), (int32_t, score));
+};
+using PlayerScores = database::TypedTable<"game_players", PlayerScoreRow>;
+
+AbstractServer::Response jsonResponse(http::status status,
+                                      const AbstractServer::Request &req,
+                                      const json::object &body) {
+  http::response<http::string_body> res{status, req.version()};
+  res.set(http::field::content_type, "application/json");
+  res.body() = json::serialize(body);
+  return res;
+}
+
+boost::uuids::uuid uuidField(const json::object &body, std::string_view key) {
+  return ids::parse(body.at(key).as_string()).value();
+}
+
+int32_t intField(const database::RowFields &row, const std::string &key) {
+  auto &&field = row.at(key);
+  return std::holds_alternative<int32_t>(field) ? std::get<int32_t>(field) : 0;
+}
+
+json::string toJson(const boost::uuids::uuid &uuid,
+                    json::storage_ptr storage = {}) {
+  char text[ids::kUuidLength];
+  ids::format(uuid, text);
+  return json::string(std::string_view(text, ids::kUuidLength),
+                      std::move(storage));
+}
+
+// JSON запроса и ответа живёт в арене соединения, см. RequestArena
+json::storage_ptr storageOf(const AbstractServer::Request &req) {
+  return jsonStorage(req.get_allocator().resource());
+}
+} // namespace
+
+std::shared_ptr<GameStore::ActiveGame>
+GameStore::activeGame(const boost::uuids::uuid &game,
+                      asio::any_io_executor executor) {
+  std::lock_guard lock(activeMutex_);
+  auto &active = active_[game];
+  if (!active) {
+    active = std::make_shared<ActiveGame>(std::move(executor));
+    if (auto it = recovered_.find(game); it != recovered_.end()) {
+      active->state = std::move(it->second);
+      recovered_.erase(it);
+    }
+  }
+  return active;
+}
+
+void GameStore::flush() { writeBehind_->drain(); }
+
+void GameStore::settleWrites() {
+  std::vector<FailedWrite> failed;
+  {
+    std::lock_guard lock(failedMutex_);
+    failed.swap(failed_);
+  }
+  // Отвергнутые команды не зафиксированы: повтор безопасен
+  for (auto &&write : failed) {
+    submitWrite(std::move(write.game), std::move(write.query));
+  }
+  writeBehind_->drain();
+  std::lock_guard lock(failedMutex_);
+  if (!failed_.empty()) {
+    throw std::runtime_error(std::to_string(failed_.size()) +
+                             " write-behind commands are not in the database");
+  }
+}
+
+void GameStore::recover(GameLog::Options options) {
+  // Журнал сворачивается, только если всё отправленное до барьера в базе
+  options.durabilityBarrier = [this] { settleWrites(); };
+  auto start = std::chrono::steady_clock::now();
+  log_ = std::make_unique<GameLog>(std::move(options));
+  std::vector<database::Query> writes;
+  auto games = log_->replay(writes);
+  auto replayed = writes.size();
+  for (auto &&write : writes) {
+    submitWrite(nullptr, std::move(write));
+  }
+  {
+    std::lock_guard lock(activeMutex_);
+    recovered_ = std::move(games);
+  }
+  log_->compact();
+  BOOST_LOG_TRIVIAL(info)
+      << "[Игра] Журнал переигран за "
+      << std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start)
+             .count()
+      << " мс, повторно отправлено команд: " << replayed << std::endl;
+}
+
+void GameStore::rebuildLeaderboard() {
+  auto start = std::chrono::steady_clock::now();
+  leaderboard_.clear();
+  database::Query query;
+  query.sql = "SELECT game_id, player_id, COALESCE(score, 0) "
+              "FROM game_players";
+  // Строки разбираются по мере получения, без промежуточного вектора
+  db_->fetchRows(std::move(query), [this](const pqxx::row &row) {
+    auto entry = PlayerScores::decode(row);
+    leaderboard_.update(entry.game_id, entry.player_id, entry.score);
+  });
+  {
+    // Журнал мог опередить базу: счёт из восстановленных игр новее
+    std::lock_guard lock(activeMutex_);
+    for (auto &&[game, state] : recovered_) {
+      for (auto &&player : state.players) {
+        leaderboard_.update(game, player.playerId, player.score);
+      }
+    }
+  }
+  BOOST_LOG_TRIVIAL(info)
+      << "[Игра] Таблица лидеров построена: " << leaderboard_.size()
+      << " игроков за "
+      << std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start)
+             .count()
+      << " мс" << std::endl;
+}
+
+void GameStore::record(const boost::uuids::uuid &game, GameChange change) {
+  if (log_) {
+    log_->append(game, std::span(&change, 1));
+  }
+}
+
+namespace {
+// Запросы, восстанавливающие состояние игры; порядок важен для load()
+std::vector<database::Query> loadQueries(const boost::uuids::uuid &game) {
+  auto byGame = [&game](std::string_view sql) {
+    auto query = database::QueryBuilder().generic(sql, {game});
+    query.shardKey = game;
+    return query;
+  };
+  return {
+      byGame("SELECT game_id FROM games WHERE game_id = $1"),
+      byGame(R"sql(
+          SELECT game_player_id, player_id, color_id, score,
+                 is_host::int4 AS is_host
+          FROM game_players WHERE game_id = $1
+          ORDER BY joined_at, game_player_id)sql"),
+      byGame(R"sql(
+          SELECT round_id, round_number, narrator_id, clue
+          FROM rounds WHERE game_id = $1
+          ORDER BY round_number DESC LIMIT 1)sql"),
+      byGame(R"sql(
+          SELECT round_cards.round_card_id, round_cards.game_player_id,
+                 round_cards.card_id
+          FROM round_cards JOIN rounds USING (round_id)
+          WHERE rounds.game_id = $1 AND rounds.round_number =
+              (SELECT max(round_number) FROM rounds WHERE game_id = $1)
+          ORDER BY round_cards.played_at, round_cards.round_card_id)sql"),
+      byGame(R"sql(
+          SELECT moves.voter_id, moves.chosen_card_id
+          FROM moves JOIN rounds USING (round_id)
+          WHERE rounds.game_id = $1 AND rounds.round_number =
+              (SELECT max(round_number) FROM rounds WHERE game_id = $1))sql"),
+  };
+}
+} // namespace
+
+void GameStore::warmUp() {
+  // Игры с нулевым id нет: запросы те же, что у первого хода, но пустые
+  db_->warmUp(loadQueries(boost::uuids::nil_uuid()));
+}
+
+std::optional<GameState> GameStore::load(const boost::uuids::uuid &game) {
+  // Все пять запросов уходят одним round-trip
+  auto results = db_->fetchPipeline(loadQueries(game));
+  if (results.at(0).empty()) {
+    return std::nullopt;
+  }
+  GameState state(game);
+  for (auto &&row : results.at(1)) {
+    state.players.push_back(GameState::Player{
+        .gamePlayerId = std::get<boost::uuids::uuid>(row.at("game_player_id")),
+        .playerId = std::get<boost::uuids::uuid>(row.at("player_id")),
+        .colorId = intField(row, "color_id"),
+        .score = intField(row, "score"),
+        .isHost = intField(row, "is_host") != 0});
+  }
+  if (!results.at(2).empty()) {
+    auto &&row = results.at(2).front();
+    state.round = GameState::Round{
+        .roundId = std::get<boost::uuids::uuid>(row.at("round_id")),
+        .number = intField(row, "round_number"),
+        .narratorId = std::get<boost::uuids::uuid>(row.at("narrator_id")),
+        .clue = std::get<std::string>(row.at("clue"))};
+  }
+  for (auto &&row : results.at(3)) {
+    state.cards.push_back(GameState::Card{
+        .roundCardId = std::get<boost::uuids::uuid>(row.at("round_card_id")),
+        .gamePlayerId = std::get<boost::uuids::uuid>(row.at("game_player_id")),
+        .cardId = std::get<boost::uuids::uuid>(row.at("card_id"))});
+  }
+  for (auto &&row : results.at(4)) {
+    state.votes.push_back(GameState::Vote{
+        .voterId = std::get<boost::uuids::uuid>(row.at("voter_id")),
+        .roundCardId = std::get<boost::uuids::uuid>(row.at("chosen_card_id"))});
+  }
+  if (state.round.number != 0 and state.cards.size() < state.players.size()) {
+    state.phase = GameState::Phase::playing;
+  } else if (state.round.number != 0 and
+             state.votes.size() + 1 < state.players.size()) {
+    state.phase = GameState::Phase::voting;
+  }
+  BOOST_LOG_TRIVIAL(info) << "[Игра] Состояние загружено из базы: "
+                          << ids::toString(game) << std::endl;
+  if (log_) {
+    log_->appendState(state);
+  }
+  return state;
+}
+
+asio::awaitable<std::optional<GameStore::Response>>
+GameStore::play(const Request &req, std::string_view gameId, Action action) {
+  auto uuid = ids::parse(gameId);
+  json::object body(storageOf(req));
+  try {
+    body = std::move(json::parse(req.body(), body.storage()).as_object());
+  } catch (const std::exception &e) {
+    co_return jsonResponse(http::status::bad_request, req,
+                           {{"error", e.what()}});
+  }
+  if (!uuid) {
+    co_return jsonResponse(http::status::not_found, req, {});
+  }
+  // Strand переживает запрос: его исполнитель не несёт срок запроса
+  auto game = activeGame(
+      *uuid, withoutQueryContext(co_await asio::this_coro::executor));
+  // Один писатель на игру: ход целиком выполняется на её strand, под
+  // сроком запроса
+  co_return co_await asio::co_spawn(
+      withQueryContext(game->strand),
+      [&]() -> asio::awaitable<Response> {
+        if (!game->state) {
+          game->state = load(*uuid);
+        }
+        if (!game->state) {
+          co_return jsonResponse(http::status::not_found, req, {});
+        }
+        Outcome outcome;
+        try {
+          outcome = action(*game->state, body);
+        } catch (const GameRuleError &e) {
+          co_return jsonResponse(http::status::conflict, req,
+                                 {{"error", e.what()}});
+        } catch (const std::exception &e) {
+          co_return jsonResponse(http::status::bad_request, req,
+                                 {{"error", e.what()}});
+        }
+        auto writes = game->state->takeWrites();
+        // Запись уйдёт из чужого потока: автор для read-your-writes — в ней
+        auto client = server_->clientOf(req);
+        for (auto &&write : writes) {
+          write.client = client;
+        }
+        auto changes = game->state->takeChanges();
+        auto submit = [&] { writeBehind(game, std::move(writes)); };
+        if (outcome.writeThrough) {
+          try {
+            db_->executeBatch(std::move(writes));
+          } catch (const std::exception &e) {
+            // База отвергла ход: перечитаем состояние при следующем обращении
+            game->state.reset();
+            co_return jsonResponse(http::status::conflict, req,
+                                   {{"error", e.what()}});
+          }
+          if (log_) {
+            log_->append(*uuid, changes);
+          }
+        } else if (log_) {
+          // Сначала журнал: команды уходят в базу под замком его шарда
+          log_->append(*uuid, changes, submit);
+        } else {
+          submit();
+        }
+        if (outcome.standingsChanged) {
+          for (auto &&player : game->state->players) {
+            leaderboard_.update(*uuid, player.playerId, player.score);
+          }
+        }
+        versions_.touch(*uuid);
+        notify(*uuid, outcome.event);
+        co_return jsonResponse(http::status::created, req, outcome.body);
+      },
+      asio::use_awaitable);
+}
+
+void GameStore::writeBehind(std::shared_ptr<ActiveGame> game,
+                            std::vector<database::Query> writes) {
+  for (auto &&write : writes) {
+    submitWrite(game, std::move(write));
+  }
+}
+
+void GameStore::submitWrite(std::shared_ptr<ActiveGame> game,
+                            database::Query write) {
+  // Копия нужна для повтора, если база команду отвергнет
+  auto retry = write;
+  writeBehind_->submit(
+      std::move(write),
+      [this, game, retry](std::exception_ptr error, size_t) mutable {
+        if (!error) {
+          return;
+        }
+        try {
+          std::rethrow_exception(error);
+        } catch (const std::exception &e) {
+          BOOST_LOG_TRIVIAL(error)
+              << "[Игра] База отвергла команду игры "
+              << (retry.shardKey ? ids::toString(*retry.shardKey) : "")
+              << ", журнал не свернётся до повтора: " << e.what()
+              << std::endl;
+        }
+        if (game) {
+          // Состояние в памяти разошлось с базой и будет перечитано.
+          // Им владеет strand игры, а это поток группировщика.
+          asio::post(game->strand, [game] { game->state.reset(); });
+        }
+        std::lock_guard lock(failedMutex_);
+        failed_.push_back({std::move(game), std::move(retry)});
+      });
+}
+
+void GameStore::requireCard(const boost::uuids::uuid &game,
+                            const boost::uuids::uuid &card) {
+  {
+    std::lock_guard lock(cardsMutex_);
+    if (cards_.contains(card)) {
+      return;
+    }
+  }
+  // Каталог карт одинаков на всех шардах: спрашиваем шард игры
+  auto query = database::QueryBuilder().generic(
+      "SELECT card_id FROM cards WHERE card_id = $1", {card});
+  query.shardKey = game;
+  if (db_->fetchSingle(std::move(query)).empty()) {
+    throw std::invalid_argument("unknown card_id");
+  }
+  std::lock_guard lock(cardsMutex_);
+  cards_.insert(card);
+}
+
+asio::awaitable<std::optional<GameStore::Response>>
+GameStore::state(const Request &req, std::string_view gameId) {
+  auto uuid = ids::parse(gameId);
+  if (!uuid) {
+    co_return jsonResponse(http::status::not_found, req, {});
+  }
+  auto game = activeGame(
+      *uuid, withoutQueryContext(co_await asio::this_coro::executor));
+  co_return co_await asio::co_spawn(
+      withQueryContext(game->strand),
+      [&]() -> asio::awaitable<Response> {
+        if (!game->state) {
+          game->state = load(*uuid);
+        }
+        if (!game->state) {
+          co_return jsonResponse(http::status::not_found, req, {});
+        }
+        auto &&current = *game->state;
+        auto storage = storageOf(req);
+        json::array players(storage);
+        for (auto &&player : current.players) {
+          players.emplace_back(json::object(
+              {{"game_player_id", toJson(player.gamePlayerId, storage)},
+               {"player_id", toJson(player.playerId, storage)},
+               {"color_id", player.colorId},
+               {"score", player.score},
+               {"is_host", player.isHost}},
+              storage));
+        }
+        json::object response({{"phase", phaseName(current.phase)},
+                               {"round_number", current.round.number}},
+                              storage);
+        response["players"] = std::move(players);
+        if (current.round.number != 0) {
+          response["round_id"] = toJson(current.round.roundId, storage);
+          response["narrator_id"] = toJson(current.round.narratorId, storage);
+          response["clue"] = current.round.clue;
+        }
+        // Пока идёт раунд, авторы карт скрыты
+        json::array cards(storage);
+        for (auto &&card : current.cards) {
+          json::object entry(
+              {{"round_card_id", toJson(card.roundCardId, storage)}}, storage);
+          if (current.phase != GameState::Phase::playing) {
+            entry["card_id"] = toJson(card.cardId, storage);
+          }
+          if (current.phase == GameState::Phase::lobby) {
+            entry["game_player_id"] = toJson(card.gamePlayerId, storage);
+          }
+          cards.emplace_back(std::move(entry));
+        }
+        response["cards"] = std::move(cards);
+        response["votes"] = current.votes.size();
+        co_return jsonResponse(http::status::ok, req, response);
+      },
+      asio::use_awaitable);
+}
+
+void GameStore::notify(const boost::uuids::uuid &game,
+                       std::string_view event) {
+  changes_.notify(game);
+  if (!server_) {
+    return;
+  }
+  std::string url = "/games/";
+  ids::appendTo(url, game);
+  // Событие сериализуется один раз и уходит всем подписчикам
+  std::string payload;
+  JsonWriter(payload)
+      .beginObject()
+      .key("event")
+      .value(event)
+      .key("url")
+      .value(url)
+      .endObject();
+  server_->publish(url + "/events", payload);
+  server_->publish(kListTopic, std::move(payload));
+}
 
 void GameStore::attachTo(std::shared_ptr<core::AbstractServer> server) {
   BOOST_LOG_TRIVIAL(info) << "[Сервер] Регистрация маршрутов..." << std::endl;
+  server_ = server;
+  server->stream(kListTopic);
+  server->stream(kGameTopic);
+  server->longPoll("/games/{gameId}", "wait");
   // Добавим обработчики для ресурса /games
-  server->get("/games", [this](Request req, auto _) -> std::optional<Response> {
-    json::object response;
-    json::array gameList;
-    database::Query query;
-    query.sql = R"sql(
-      SELECT game_id FROM games
-    )sql";
-    auto rows = db_->fetchMultiple(query);
-    for (auto &&row : rows) {
-      auto uuidField = row["game_id"];
-      auto uuid = std::get<boost::uuids::uuid>(uuidField);
-      auto gameId = boost::uuids::to_string(uuid);
-      json::object entry{{"url", "/games/" + gameId}};
-      gameList.push_back(std::move(entry));
-    }
-    response["games"] = std::move(gameList);
-    http::response<http::string_body> res{http::status::ok, req.version()};
-    res.result(http::status::ok);
-    res.body() = json::serialize(response);
-    BOOST_LOG_TRIVIAL(info)
-        << "[API] Получен список всех игр. Количество: " << rows.size()
-        << std::endl;
-    return res;
-  });
-  server->post(
-      "/games", [this](Request req, auto _) -> std::optional<Response> {
-        boost::uuids::uuid uuid = boost::uuids::random_generator()();
-        std::string gameId = boost::uuids::to_string(uuid);
-        database::RowFields fields{{"status_id", int(1)}, {"game_id", uuid}};
-        auto query =
-            database::QueryBuilder().insert("games", std::move(fields));
-        db_->executeCommand(query);
+  server->get(
+      "/games",
+      [this](const Request &req, const auto &) -> std::optional<Response> {
+        auto version = versions_.listVersion();
+        auto etag = versions_.etag(version);
+        if (auto res = notModified(req, etag); res) {
+          return res;
+        }
+        std::vector<GameIdRow> rows;
+        {
+          // Список содержит игры всех клиентов: читаем без автора, чтобы
+          // реплика догнала последнюю запись вообще, а не только его
+          // (см. RoutingDatabase). Версия меняется уже после фиксации,
+          // поэтому ответ содержит всё, что отражает тег
+          database::QueryContext anyone;
+          if (auto *context = database::QueryContext::current(); context) {
+            anyone = *context;
+          }
+          anyone.client = 0;
+          database::QueryContext::Scope scope(anyone);
+          rows = GameIds::fetch(*db_, GameIds::select());
+        }
+        http::response<http::string_body> res{http::status::ok, req.version()};
+        res.result(http::status::ok);
+        // Список изменился во время чтения: неизвестно, какую версию
+        // отражает ответ, и тег не выдаём
+        if (versions_.listVersion() == version) {
+          res.set(http::field::etag, etag);
+        }
+        // Плоский список пишем сразу в тело ответа, без DOM
+        auto &body = res.body();
+        body.reserve(kGameListEntrySize * (rows.size() + 1));
+        JsonWriter writer(body);
+        writer.beginObject().key("games").beginArray();
+        std::string url;
+        for (auto &&row : rows) {
+          url.assign("/games/");
+          ids::appendTo(url, row.game_id);
+          writer.beginObject().key("url").value(url).endObject();
+        }
+        writer.endArray().endObject();
+        BOOST_LOG_TRIVIAL(info)
+            << "[API] Получен список всех игр. Количество: " << rows.size()
+            << std::endl;
+        return res;
+      });
+  server->postAsync(
+      "/games",
+      [this](const Request &req,
+             const auto &) -> asio::awaitable<std::optional<Response>> {
+        GameRow game{.game_id = ids::generateV7(), .status_id = 1};
+        std::string gameId = ids::toString(game.game_id);
+        auto insert = Games::insert(game);
+        insert.shardKey = game.game_id;
+        insert.client = server_->clientOf(req);
+        // Ответ ждёт фиксации вставки, но поток io_context не занят
+        co_await writeBehind_->asyncSubmit(std::move(insert),
+                                           asio::use_awaitable);
+        record(game.game_id, events::Created{});
+        versions_.create(game.game_id);
+        notify(game.game_id, "created");
         std::string url = "/games/" + gameId;
         json::object response;
         response["url"] = url;
@@ -56,22 +566,96 @@ void GameStore::attachTo(std::shared_ptr<core::AbstractServer> server) {
         res.body() = json::serialize(response);
         BOOST_LOG_TRIVIAL(info)
             << "[API] Создана новая игра с id: " << gameId << std::endl;
-        return res;
+        co_return res;
+      });
+  server->postAsync(
+      "/games/batch",
+      [this](const Request &req,
+             const auto &) -> asio::awaitable<std::optional<Response>> {
+        int64_t count = 0;
+        try {
+          count = json::parse(req.body(), storageOf(req))
+                      .at("count")
+                      .to_number<int64_t>();
+        } catch (const std::exception &e) {
+          BOOST_LOG_TRIVIAL(info)
+              << "[API] Некорректный запрос пакетного создания: " << e.what()
+              << std::endl;
+        }
+        if (count <= 0 or count > kMaxBatchSize) {
+          http::response<http::string_body> res{http::status::bad_request,
+                                                req.version()};
+          co_return res;
+        }
+        // Строки по шардам: в каждый шард уходит одна вставка
+        std::map<size_t, std::vector<database::RowFields>> rowsByShard;
+        json::array gameList;
+        gameList.reserve(count);
+        std::string url;
+        for (int64_t i = 0; i < count; ++i) {
+          boost::uuids::uuid uuid = ids::generateV7();
+          rowsByShard[db_->shardOf(uuid)].push_back(
+              {{"status_id", int(1)}, {"game_id", uuid}});
+          url.assign("/games/");
+          ids::appendTo(url, uuid);
+          gameList.push_back(json::object{{"url", url}});
+        }
+        // Многострочная вставка на шард уходит через группировщик, как
+        // POST /games: поток io_context не ждёт базу. Шарды фиксируются по
+        // отдельности: если упадёт следующий, игры уже созданных учтены
+        std::vector<boost::uuids::uuid> created;
+        for (auto &&[shard, rows] : rowsByShard) {
+          created.clear();
+          for (auto &&row : rows) {
+            created.push_back(std::get<boost::uuids::uuid>(row.at("game_id")));
+          }
+          auto insert =
+              database::QueryBuilder().insertMany("games", std::move(rows));
+          insert.shardKey = created.front();
+          insert.client = server_->clientOf(req);
+          co_await writeBehind_->asyncSubmit(std::move(insert),
+                                             asio::use_awaitable);
+          for (auto &&game : created) {
+            record(game, events::Created{});
+            versions_.create(game);
+            notify(game, "created");
+          }
+        }
+        json::object response;
+        response["games"] = std::move(gameList);
+        http::response<http::string_body> res{http::status::created,
+                                              req.version()};
+        res.body() = json::serialize(response);
+        BOOST_LOG_TRIVIAL(info)
+            << "[API] Создано игр пакетом: " << count << std::endl;
+        co_return res;
       });
   server->get(
       "/games/{gameId}",
-      [this](Request req, auto matches) -> std::optional<Response> {
-        auto &&gameId = matches.at("gameId");
-        database::Query query;
-        query.sql = R"sql(
+      [this](const Request &req,
+             const auto &matches) -> std::optional<Response> {
+        std::string_view gameId = matches.at("gameId");
+        auto uuid = ids::parse(gameId);
+        if (auto version = uuid ? versions_.gameVersion(*uuid) : std::nullopt;
+            version) {
+          if (auto res = notModified(req, versions_.etag(*version)); res) {
+            return res;
+          }
+        }
+        database::RowFields fields;
+        if (uuid) {
+          database::Query query;
+          query.sql = R"sql(
                   SELECT game_statuses.status_name as status_name
                   FROM games LEFT JOIN game_statuses
                   ON games.status_id = game_statuses.status_id
                   WHERE games.game_id = $1)sql";
-        query.append(gameId);
-        BOOST_LOG_TRIVIAL(info)
-            << "[API] Запрашиваю данные игры: " << query.sql;
-        auto fields = db_->fetchSingle(query);
+          query.append(*uuid);
+          query.shardKey = *uuid;
+          BOOST_LOG_TRIVIAL(info)
+              << "[API] Запрашиваю данные игры: " << query.sql;
+          fields = db_->fetchSingle(query);
+        }
         if (fields.empty()) {
           BOOST_LOG_TRIVIAL(info)
               << "[API] Игра с id " << gameId << " не найдена." << std::endl;
@@ -81,28 +665,211 @@ void GameStore::attachTo(std::shared_ptr<core::AbstractServer> server) {
         }
 
         http::response<http::string_body> res{http::status::ok, req.version()};
+        auto version = versions_.remember(*uuid);
+        res.set(http::field::etag, versions_.etag(version));
         auto statusName = std::get<std::string>(fields.at("status_name"));
-        json::object response{{"url", "/games/" + gameId},
-                              {"status", statusName}};
+        json::object response{{"url", std::string("/games/").append(gameId)},
+                              {"status", statusName},
+                              {"version", version}};
         res.body() = json::serialize(response);
         return res;
       });
-  server->del("/games/{gameId}",
-              [this](Request req, auto matches) -> std::optional<Response> {
-                auto &&gameId = matches.at("gameId");
-                database::Query query;
-                query.sql = R"sql(
-                  DELETE FROM games WHERE game_id=$1;
-                )sql";
-                query.append(gameId);
-                auto affectedRows = db_->executeCommand(query);
-                auto status = affectedRows == 1 ? http::status::no_content
-                                                : http::status::not_found;
-                http::response<http::string_body> res{status, req.version()};
-                BOOST_LOG_TRIVIAL(info)
-                    << "[API] Удалена игра: " << gameId << std::endl;
-                return res;
-              });
+  // Long-poll: GET /games/{gameId}?wait=<сек>&since=<версия> ждёт, пока
+  // версия игры не отличится от since, и отдаёт её обычным GET выше
+  server->getAsync(
+      "/games/{gameId}",
+      [this](const Request &req,
+             const auto &matches) -> asio::awaitable<std::optional<Response>> {
+        auto target = boost::urls::parse_origin_form(req.target());
+        auto uuid = ids::parse(matches.at("gameId"));
+        if (!target or !uuid) {
+          co_return std::nullopt;
+        }
+        auto params = target->params();
+        auto waitParam = params.find("wait");
+        if (waitParam == params.end()) {
+          co_return std::nullopt;
+        }
+        auto current = versions_.gameVersion(*uuid);
+        auto wait = toNumber((*waitParam).value);
+        auto since = current;
+        auto sinceParam = params.find("since");
+        if (sinceParam != params.end()) {
+          since = toNumber((*sinceParam).value);
+        }
+        if (!wait or (!since and sinceParam != params.end())) {
+          co_return http::response<http::string_body>{http::status::bad_request,
+                                                      req.version()};
+        }
+        if (!current) {
+          // Игру ещё не читали: версию клиент узнает из обычного ответа
+          co_return std::nullopt;
+        }
+        std::chrono::seconds timeout(
+            std::min<uint64_t>(*wait, kMaxLongPollWait.count()));
+        co_await changes_.wait(
+            *uuid,
+            [this, game = *uuid, since] {
+              return versions_.gameVersion(game) != since;
+            },
+            timeout);
+        // По таймауту обычный GET ответит 304 на прежний If-None-Match
+        co_return std::nullopt;
+      });
+  // Ходы активных игр выполняются в памяти, см. GameState
+  server->postAsync(
+      "/games/{gameId}/players",
+      [this](const Request &req,
+             const auto &matches) -> asio::awaitable<std::optional<Response>> {
+        co_return co_await play(
+            req, matches.at("gameId"),
+            [](GameState &game, const json::object &body) {
+              auto &&player = game.join(uuidField(body, "player_id"));
+              return Outcome{
+                  .body = {{"game_player_id", toJson(player.gamePlayerId)},
+                           {"color_id", player.colorId},
+                           {"is_host", player.isHost}},
+                  .event = "player_joined",
+                  .writeThrough = true,
+                  .standingsChanged = true};
+            });
+      });
+  server->postAsync(
+      "/games/{gameId}/rounds",
+      [this](const Request &req,
+             const auto &matches) -> asio::awaitable<std::optional<Response>> {
+        co_return co_await play(
+            req, matches.at("gameId"),
+            [this](GameState &game, const json::object &body) {
+              auto card = uuidField(body, "card_id");
+              requireCard(game.gameId, card);
+              auto &&round = game.startRound(
+                  uuidField(body, "game_player_id"), card,
+                  std::string(body.at("clue").as_string()));
+              return Outcome{.body = {{"round_id", toJson(round.roundId)},
+                                      {"round_number", round.number}},
+                             .event = "round_started"};
+            });
+      });
+  server->postAsync(
+      "/games/{gameId}/cards",
+      [this](const Request &req,
+             const auto &matches) -> asio::awaitable<std::optional<Response>> {
+        co_return co_await play(
+            req, matches.at("gameId"),
+            [this](GameState &game, const json::object &body) {
+              auto cardId = uuidField(body, "card_id");
+              requireCard(game.gameId, cardId);
+              auto &&card =
+                  game.playCard(uuidField(body, "game_player_id"), cardId);
+              bool voting = game.phase == GameState::Phase::voting;
+              return Outcome{
+                  .body = {{"round_card_id", toJson(card.roundCardId)}},
+                  .event = voting ? "voting_started" : "card_played"};
+            });
+      });
+  server->postAsync(
+      "/games/{gameId}/votes",
+      [this](const Request &req,
+             const auto &matches) -> asio::awaitable<std::optional<Response>> {
+        co_return co_await play(
+            req, matches.at("gameId"),
+            [](GameState &game, const json::object &body) {
+              bool scored = game.vote(uuidField(body, "game_player_id"),
+                                      uuidField(body, "round_card_id"));
+              return Outcome{.body = {{"scored", scored}},
+                             .event = scored ? "round_scored" : "vote_cast",
+                             .standingsChanged = scored};
+            });
+      });
+  server->getAsync(
+      "/games/{gameId}/state",
+      [this](const Request &req,
+             const auto &matches) -> asio::awaitable<std::optional<Response>> {
+        co_return co_await state(req, matches.at("gameId"));
+      });
+  server->get(
+      "/leaderboard",
+      [this](const Request &req, const auto &) -> std::optional<Response> {
+        size_t limit = kDefaultLeaderboardLimit;
+        if (auto target = boost::urls::parse_origin_form(req.target());
+            target) {
+          if (auto param = target->params().find("limit");
+              param != target->params().end()) {
+            auto value = toNumber((*param).value);
+            if (!value or *value == 0) {
+              return jsonResponse(http::status::bad_request, req, {});
+            }
+            limit = std::min<uint64_t>(*value, kMaxLeaderboardLimit);
+          }
+        }
+        auto storage = storageOf(req);
+        json::array players(storage);
+        for (auto &&standing : leaderboard_.top(limit)) {
+          players.emplace_back(
+              json::object({{"player_id", toJson(standing.playerId, storage)},
+                            {"score", standing.score},
+                            {"rank", standing.rank}},
+                           storage));
+        }
+        json::object response(storage);
+        response["players"] = std::move(players);
+        return jsonResponse(http::status::ok, req, response);
+      });
+  server->get(
+      "/players/{playerId}/rank",
+      [this](const Request &req,
+             const auto &matches) -> std::optional<Response> {
+        auto uuid = ids::parse(matches.at("playerId"));
+        auto standing = uuid ? leaderboard_.rank(*uuid) : std::nullopt;
+        if (!standing) {
+          return jsonResponse(http::status::not_found, req, {});
+        }
+        return jsonResponse(http::status::ok, req,
+                            {{"player_id", toJson(standing->playerId)},
+                             {"score", standing->score},
+                             {"rank", standing->rank}});
+      });
+  server->delAsync(
+      "/games/{gameId}",
+      [this](const Request &req,
+             const auto &matches) -> asio::awaitable<std::optional<Response>> {
+        std::string_view gameId = matches.at("gameId");
+        auto uuid = ids::parse(gameId);
+        size_t affectedRows = 0;
+        if (uuid) {
+          auto query = Games::deleteWhere<"game_id">(*uuid);
+          query.shardKey = *uuid;
+          query.client = server_->clientOf(req);
+          // Через ту же очередь, что и ходы: удаление не обгонит их
+          affectedRows = co_await writeBehind_->asyncSubmit(
+              std::move(query), asio::use_awaitable);
+        }
+        if (affectedRows != 0) {
+          {
+            std::lock_guard lock(activeMutex_);
+            active_.erase(*uuid);
+            recovered_.erase(*uuid);
+          }
+          {
+            // Строк удалённой игры в базе уже не будет: повторять нечего
+            std::lock_guard lock(failedMutex_);
+            std::erase_if(failed_, [&uuid](const FailedWrite &write) {
+              return write.query.shardKey == *uuid;
+            });
+          }
+          leaderboard_.forgetGame(*uuid);
+          record(*uuid, events::Deleted{});
+          versions_.forget(*uuid);
+          notify(*uuid, "deleted");
+        }
+        auto status = affectedRows == 1 ? http::status::no_content
+                                        : http::status::not_found;
+        http::response<http::string_body> res{status, req.version()};
+        BOOST_LOG_TRIVIAL(info)
+            << "[API] Удалена игра: " << gameId << std::endl;
+        co_return res;
+      });
 }
 
 } // namespace core
\ No newline at end of file
@@ -1,19 +1,204 @@
 #pragma once
 
+#include "change_notifier.hpp"
 #include "database_iface.hpp"
+#include "game_engine.hpp"
+#include "game_log.hpp"
+#include "leaderboard.hpp"
+#include "group_commit.hpp"
 #include "server_iface.hpp"
+#include "version_map.hpp"
+
+#include <boost/container_hash/hash.hpp>
+#include <boost/json.hpp>
+
+#include <mutex>
+#include <unordered_set>
 
 namespace core {
 struct GameStore : std::enable_shared_from_this<GameStore> {
-  explicit GameStore(std::shared_ptr<database::AbstractDatabase> db)
-      : db_(db) {}
+  /**
+   * @param window Окно накопления отложенных записей
+   * @param maxBatch Больше команд в одну транзакцию не объединяется
+   */
+  explicit GameStore(std::shared_ptr<database::AbstractDatabase> db,
+                     std::chrono::microseconds window = kWriteBehindWindow,
+                     size_t maxBatch = kWriteBehindBatch)
+      : db_(db), writeBehind_(std::make_shared<database::GroupCommitDatabase>(
+                     db, window, maxBatch)) {}
   using Request = core::AbstractServer::Request;
   using Response = core::AbstractServer::Response;
   void attachTo(std::shared_ptr<core::AbstractServer> server);
 
+  /**
+   * @brief Включает журнал активных игр и восстанавливает их из него
+   *
+   * Вызывается до приёма запросов. Команды для базы из несвёрнутой части
+   * журнала отправляются повторно, вставки пропускают уже существующие
+   * строки (см. GameState::replay()). Журнал сворачивается, только когда
+   * все команды до снимка в базе.
+   */
+  void recover(GameLog::Options options);
+
+  /**
+   * @brief Строит таблицу лидеров по game_players и восстановленным играм
+   *
+   * Вызывается до приёма запросов, после recover().
+   */
+  void rebuildLeaderboard();
+
+  /**
+   * @brief Прогревает соединения с базой запросами загрузки игры
+   *
+   * Вызывается после attachTo(), пока сервер ещё не объявил готовность:
+   * иначе первые ходы платили бы за холодные соединения и кэши сервера
+   * базы.
+   */
+  void warmUp();
+
+  /**
+   * @brief Дожидается, пока отложенные записи дойдут до базы
+   *
+   * Вызывается при остановке, когда запросов уже нет.
+   */
+  void flush();
+
+  // Темы WebSocket-событий: общая для списка игр и своя у каждой игры
+  static constexpr std::string_view kListTopic = "/games/events";
+  static constexpr std::string_view kGameTopic = "/games/{gameId}/events";
+
+  // Postgres ограничивает запрос 65535 параметрами, на одну игру уходит два
+  static constexpr int64_t kMaxBatchSize = 1000;
+  // {"url":"/games/<uuid>"}, — оценка для резервирования тела списка
+  static constexpr size_t kGameListEntrySize = 56;
+  // Дольше не держим припаркованный GET /games/{gameId}?wait=...
+  static constexpr std::chrono::seconds kMaxLongPollWait{60};
+  // Ходы уходят в базу пакетами в фоне, не задерживая ответ; создание и
+  // удаление игр ждут фиксации, не занимая поток io_context
+  static constexpr std::chrono::milliseconds kWriteBehindWindow{2};
+  static constexpr size_t kWriteBehindBatch = 256;
+  // GET /leaderboard?limit=...
+  static constexpr size_t kDefaultLeaderboardLimit = 10;
+  static constexpr size_t kMaxLeaderboardLimit = 100;
+
 private:
+  /**
+   * @brief Активная игра: состояние в памяти и strand его единственного
+   * писателя
+   */
+  struct ActiveGame {
+    explicit ActiveGame(boost::asio::any_io_executor executor)
+        : strand(boost::asio::make_strand(std::move(executor))) {}
+    boost::asio::strand<boost::asio::any_io_executor> strand;
+    // Загружается из базы при первом обращении
+    std::optional<GameState> state;
+  };
+
+  /// Итог хода: тело ответа и имя события для подписчиков
+  struct Outcome {
+    boost::json::object body;
+    std::string_view event;
+    // Вступление в игру пишется сразу: базе нужно проверить игрока
+    bool writeThrough = false;
+    // Изменился состав игроков или их счёт
+    bool standingsChanged = false;
+  };
+  using Action =
+      std::function<Outcome(GameState &game, const boost::json::object &body)>;
+
+  /**
+   * @brief Выполняет ход на strand игры
+   *
+   * Команды для базы, накопленные ходом, уходят в фоновый group commit,
+   * поэтому задержка хода определяется памятью, а не SQL.
+   */
+  boost::asio::awaitable<std::optional<Response>>
+  play(const Request &req, std::string_view gameId, Action action);
+
+  /// Состояние игры для GET /games/{gameId}/state
+  boost::asio::awaitable<std::optional<Response>>
+  state(const Request &req, std::string_view gameId);
+
+  std::shared_ptr<ActiveGame>
+  activeGame(const boost::uuids::uuid &game,
+             boost::asio::any_io_executor executor);
+
+  /// Восстанавливает состояние игры из базы одним конвейером запросов
+  std::optional<GameState> load(const boost::uuids::uuid &game);
+
+  /**
+   * @brief Проверяет, что карта есть в каталоге, до того как ход принят
+   *
+   * Иначе ответ 201 ушёл бы раньше, чем база отвергнет вставку в
+   * round_cards по внешнему ключу. Известные карты кэшируются.
+   *
+   * @throws std::invalid_argument если карты нет
+   */
+  void requireCard(const boost::uuids::uuid &game,
+                   const boost::uuids::uuid &card);
+
+  /**
+   * @brief Отправляет команды хода в write-behind
+   *
+   * Если база отвергла команду, состояние игры в памяти разошлось с ней:
+   * оно сбрасывается на strand игры и перечитывается при следующем ходе.
+   */
+  void writeBehind(std::shared_ptr<ActiveGame> game,
+                   std::vector<database::Query> writes);
+
+  /**
+   * @brief Отправляет команду в write-behind и запоминает её, если база её
+   * отвергла
+   *
+   * @param game Игра, чьё состояние сбросить при ошибке, или nullptr
+   */
+  void submitWrite(std::shared_ptr<ActiveGame> game, database::Query write);
+
+  /**
+   * @brief Барьер перед снимком журнала
+   *
+   * Повторяет отвергнутые ранее команды и ждёт всё отправленное до вызова.
+   *
+   * @throws std::runtime_error если какие-то команды так и не попали в
+   * базу: тогда снимок не строится и сегменты журнала остаются
+   */
+  void settleWrites();
+
+  /// Пишет в журнал создание или удаление игры
+  void record(const boost::uuids::uuid &game, GameChange change);
+
+  /**
+   * @brief Публикует событие об игре в её тему и в тему списка
+   *
+   * @param event Имя события, например "created" или "deleted"
+   */
+  void notify(const boost::uuids::uuid &game, std::string_view event);
+
+  std::shared_ptr<core::AbstractServer> server_;
   // std::unordered_map<std::string, std::string> games_;
   std::shared_ptr<database::AbstractDatabase> db_;
+  VersionMap versions_;
+  ChangeNotifier changes_;
+  Leaderboard leaderboard_;
+  // Команды, отвергнутые базой, ждут повтора в settleWrites();
+  // объявлены раньше writeBehind_, который вызывает обработчики до конца
+  struct FailedWrite {
+    std::shared_ptr<ActiveGame> game;
+    database::Query query;
+  };
+  std::mutex failedMutex_;
+  std::vector<FailedWrite> failed_;
+  std::shared_ptr<database::GroupCommitDatabase> writeBehind_;
+  std::unique_ptr<GameLog> log_;
+  std::mutex activeMutex_;
+  std::unordered_map<boost::uuids::uuid, std::shared_ptr<ActiveGame>,
+                     boost::hash<boost::uuids::uuid>>
+      active_;
+  // Восстановленные из журнала игры, ещё не получившие strand
+  GameLog::Games recovered_;
+  std::mutex cardsMutex_;
+  std::unordered_set<boost::uuids::uuid, boost::hash<boost::uuids::uuid>>
+      cards_;
 };
 
 } // namespace core
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "leaderboard.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+namespace core {
+void Leaderboard::update(const boost::uuids::uuid &game,
+                         const boost::uuids::uuid &player, int32_t gameScore) {
+  std::unique_lock lock(mutex_);
+  auto &players = games_[game];
+  auto it = std::ranges::find(players, player,
+                              &std::pair<boost::uuids::uuid, int32_t>::first);
+  if (it == players.end()) {
+    players.emplace_back(player, gameScore);
+    add(player, gameScore);
+    return;
+  }
+  if (it->second != gameScore) {
+    add(player, int64_t(gameScore) - it->second);
+    it->second = gameScore;
+  }
+}
+
+void Leaderboard::forgetGame(const boost::uuids::uuid &game) {
+  std::unique_lock lock(mutex_);
+  auto it = games_.find(game);
+  if (it == games_.end()) {
+    return;
+  }
+  for (auto &&[player, score] : it->second) {
+    add(player, -int64_t(score));
+  }
+  games_.erase(it);
+}
+
+void Leaderboard::add(const boost::uuids::uuid &player, int64_t delta) {
+  auto [total, inserted] = totals_.try_emplace(player, 0);
+  if (!inserted) {
+    if (delta == 0) {
+      return;
+    }
+    order_.erase({total->second, player});
+  }
+  total->second += delta;
+  order_.insert({total->second, player});
+}
+
+size_t Leaderboard::ahead(int64_t score) const {
+  // Нулевой uuid меньше любого другого: ключ встаёт перед всеми с тем же
+  // счётом
+  return order_.rank({score, boost::uuids::uuid{}});
+}
+
+std::vector<Leaderboard::Standing> Leaderboard::top(size_t limit) const {
+  std::shared_lock lock(mutex_);
+  std::vector<Standing> standings;
+  standings.reserve(std::min(limit, order_.size()));
+  order_.visit(0, limit, [&](const Key &key) {
+    size_t rank = standings.size() + 1;
+    if (!standings.empty() and standings.back().score == key.score) {
+      rank = standings.back().rank;
+    }
+    standings.push_back(
+        Standing{.playerId = key.playerId, .score = key.score, .rank = rank});
+  });
+  return standings;
+}
+
+std::optional<Leaderboard::Standing>
+Leaderboard::rank(const boost::uuids::uuid &player) const {
+  std::shared_lock lock(mutex_);
+  auto it = totals_.find(player);
+  if (it == totals_.end()) {
+    return std::nullopt;
+  }
+  return Standing{
+      .playerId = player, .score = it->second, .rank = ahead(it->second) + 1};
+}
+
+size_t Leaderboard::size() const {
+  std::shared_lock lock(mutex_);
+  return order_.size();
+}
+
+void Leaderboard::clear() {
+  std::unique_lock lock(mutex_);
+  totals_.clear();
+  games_.clear();
+  order_.clear();
+}
+} // namespace core
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <boost/container_hash/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "order_statistic_tree.hpp"
+
+namespace core {
+/**
+ * @brief Таблица лидеров, обновляемая по мере начисления очков
+ *
+ * Хранит счёт каждого игрока в каждой игре и сумму по всем играм. Суммы
+ * упорядочены деревом с поиском по номеру, поэтому первые N и место
+ * игрока находятся за O(log n) без агрегирующих запросов к scores.
+ * Игроки с равным счётом делят место.
+ */
+struct Leaderboard {
+  struct Standing {
+    boost::uuids::uuid playerId;
+    int64_t score;
+    // Место, начиная с 1
+    size_t rank;
+  };
+
+  /**
+   * @brief Запоминает текущий счёт игрока в игре
+   *
+   * Счёт абсолютный, поэтому повторное обновление безопасно.
+   */
+  void update(const boost::uuids::uuid &game, const boost::uuids::uuid &player,
+              int32_t gameScore);
+
+  /// Удалённая игра: её очки вычитаются из сумм игроков
+  void forgetGame(const boost::uuids::uuid &game);
+
+  /// Первые @p limit игроков
+  std::vector<Standing> top(size_t limit) const;
+
+  /// Место игрока, если он сыграл хоть одну игру
+  std::optional<Standing> rank(const boost::uuids::uuid &player) const;
+
+  size_t size() const;
+
+  void clear();
+
+private:
+  struct Key {
+    int64_t score;
+    boost::uuids::uuid playerId;
+  };
+  // Сначала больший счёт, при равенстве — по id
+  struct Order {
+    bool operator()(const Key &lhs, const Key &rhs) const {
+      if (lhs.score != rhs.score) {
+        return lhs.score > rhs.score;
+      }
+      return lhs.playerId < rhs.playerId;
+    }
+  };
+  using UuidHash = boost::hash<boost::uuids::uuid>;
+
+  void add(const boost::uuids::uuid &player, int64_t delta);
+  // Сколько игроков набрали строго больше
+  size_t ahead(int64_t score) const;
+
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<boost::uuids::uuid, int64_t, UuidHash> totals_;
+  // Игроков в игре не больше шести: плоский вектор вместо вложенной таблицы
+  std::unordered_map<boost::uuids::uuid,
+                     std::vector<std::pair<boost::uuids::uuid, int32_t>>,
+                     UuidHash>
+      games_;
+  OrderStatisticTree<Key, Order> order_;
+};
+} // namespace core
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace core {
+/**
+ * @brief Упорядоченное множество с поиском по номеру (order-statistic tree)
+ *
+ * Декартово дерево (treap), каждый узел которого знает размер своего
+ * поддерева. Вставка, удаление, номер ключа и ключ по номеру — за
+ * O(log n) в среднем. Узлы лежат в одном векторе и ссылаются друг на
+ * друга индексами: меньше указателей и аллокаций, освободившиеся узлы
+ * переиспользуются.
+ */
+template <typename Key, typename Compare = std::less<Key>>
+struct OrderStatisticTree {
+  /// Вставляет ключ; false, если такой уже есть
+  bool insert(const Key &key) {
+    if (contains(key)) {
+      return false;
+    }
+    auto node = allocate(key);
+    auto [less, rest] = split(root_, key);
+    root_ = merge(merge(less, node), rest);
+    return true;
+  }
+
+  /// Удаляет ключ; false, если его не было
+  bool erase(const Key &key) {
+    if (!contains(key)) {
+      return false;
+    }
+    auto [less, rest] = split(root_, key);
+    // Первый узел rest — искомый ключ: отрезаем его
+    auto [found, greater] = splitFirst(rest);
+    free_.push_back(found);
+    root_ = merge(less, greater);
+    return true;
+  }
+
+  bool contains(const Key &key) const {
+    auto node = root_;
+    while (node != kNil) {
+      auto &&current = nodes_[node];
+      if (compare_(key, current.key)) {
+        node = current.left;
+      } else if (compare_(current.key, key)) {
+        node = current.right;
+      } else {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Сколько ключей строго меньше @p key
+  size_t rank(const Key &key) const {
+    size_t before = 0;
+    auto node = root_;
+    while (node != kNil) {
+      auto &&current = nodes_[node];
+      if (compare_(current.key, key)) {
+        before += sizeOf(current.left) + 1;
+        node = current.right;
+      } else {
+        node = current.left;
+      }
+    }
+    return before;
+  }
+
+  /// Ключ с номером @p index в порядке возрастания
+  const Key &at(size_t index) const {
+    if (index >= size()) {
+      throw std::out_of_range("OrderStatisticTree::at");
+    }
+    auto node = root_;
+    for (;;) {
+      auto &&current = nodes_[node];
+      auto leftSize = sizeOf(current.left);
+      if (index < leftSize) {
+        node = current.left;
+      } else if (index == leftSize) {
+        return current.key;
+      } else {
+        index -= leftSize + 1;
+        node = current.right;
+      }
+    }
+  }
+
+  /// Обходит до @p count ключей по порядку, начиная с номера @p first
+  template <typename F> void visit(size_t first, size_t count, F &&fn) const {
+    visit(root_, first, count, fn);
+  }
+
+  size_t size() const { return sizeOf(root_); }
+
+  void clear() {
+    nodes_.clear();
+    free_.clear();
+    root_ = kNil;
+  }
+
+private:
+  using Index = uint32_t;
+  static constexpr Index kNil = std::numeric_limits<Index>::max();
+
+  struct Node {
+    Key key;
+    uint32_t priority;
+    uint32_t size;
+    Index left;
+    Index right;
+  };
+
+  size_t sizeOf(Index node) const {
+    return node == kNil ? 0 : nodes_[node].size;
+  }
+
+  void update(Index node) {
+    auto &current = nodes_[node];
+    current.size = 1 + sizeOf(current.left) + sizeOf(current.right);
+  }
+
+  Index allocate(const Key &key) {
+    Node node{.key = key,
+              .priority = uint32_t(random_()),
+              .size = 1,
+              .left = kNil,
+              .right = kNil};
+    if (!free_.empty()) {
+      auto index = free_.back();
+      free_.pop_back();
+      nodes_[index] = std::move(node);
+      return index;
+    }
+    nodes_.push_back(std::move(node));
+    return Index(nodes_.size() - 1);
+  }
+
+  // Делит дерево на ключи < key и >= key
+  std::pair<Index, Index> split(Index node, const Key &key) {
+    if (node == kNil) {
+      return {kNil, kNil};
+    }
+    if (compare_(nodes_[node].key, key)) {
+      auto [less, rest] = split(nodes_[node].right, key);
+      nodes_[node].right = less;
+      update(node);
+      return {node, rest};
+    }
+    auto [less, rest] = split(nodes_[node].left, key);
+    nodes_[node].left = rest;
+    update(node);
+    return {less, node};
+  }
+
+  // Отделяет наименьший узел
+  std::pair<Index, Index> splitFirst(Index node) {
+    if (nodes_[node].left == kNil) {
+      auto rest = nodes_[node].right;
+      nodes_[node].right = kNil;
+      update(node);
+      return {node, rest};
+    }
+    auto [first, rest] = splitFirst(nodes_[node].left);
+    nodes_[node].left = rest;
+    update(node);
+    return {first, node};
+  }
+
+  Index merge(Index left, Index right) {
+    if (left == kNil) {
+      return right;
+    }
+    if (right == kNil) {
+      return left;
+    }
+    if (nodes_[left].priority > nodes_[right].priority) {
+      nodes_[left].right = merge(nodes_[left].right, right);
+      update(left);
+      return left;
+    }
+    nodes_[right].left = merge(left, nodes_[right].left);
+    update(right);
+    return right;
+  }
+
+  template <typename F>
+  void visit(Index node, size_t &first, size_t &count, F &fn) const {
+    if (node == kNil or count == 0) {
+      return;
+    }
+    auto &&current = nodes_[node];
+    auto leftSize = sizeOf(current.left);
+    if (first < leftSize) {
+      visit(current.left, first, count, fn);
+    } else {
+      first -= leftSize;
+    }
+    if (count == 0) {
+      return;
+    }
+    if (first == 0) {
+      fn(current.key);
+      --count;
+    } else {
+      --first;
+    }
+    visit(current.right, first, count, fn);
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<Index> free_;
+  Index root_ = kNil;
+  std::minstd_rand random_{std::random_device{}()};
+  [[no_unique_address]] Compare compare_;
+};
+} // namespace core
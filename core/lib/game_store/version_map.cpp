@@ -0,0 +1,103 @@
+#include "version_map.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include <boost/container_hash/hash.hpp>
+
+namespace core {
+namespace {
+uint64_t makeEpoch() {
+  std::random_device device;
+  auto now = std::chrono::system_clock::now().time_since_epoch().count();
+  return uint64_t(now) ^ (uint64_t(device()) << 32 | device());
+}
+} // namespace
+
+size_t VersionMap::UuidHash::operator()(
+    const boost::uuids::uuid &uuid) const noexcept {
+  return boost::hash_range(uuid.begin(), uuid.end());
+}
+
+VersionMap::VersionMap(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)), epoch_(makeEpoch()) {}
+
+uint64_t VersionMap::listVersion() const {
+  std::shared_lock lock(mutex_);
+  return listVersion_;
+}
+
+std::optional<uint64_t>
+VersionMap::gameVersion(const boost::uuids::uuid &game) const {
+  std::shared_lock lock(mutex_);
+  if (auto it = games_.find(game); it != games_.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+uint64_t VersionMap::create(const boost::uuids::uuid &game) {
+  std::unique_lock lock(mutex_);
+  auto version = ++counter_;
+  store(game, version);
+  listVersion_ = version;
+  return version;
+}
+
+uint64_t VersionMap::touch(const boost::uuids::uuid &game) {
+  std::unique_lock lock(mutex_);
+  auto version = ++counter_;
+  store(game, version);
+  return version;
+}
+
+uint64_t VersionMap::remember(const boost::uuids::uuid &game) {
+  std::unique_lock lock(mutex_);
+  if (auto it = games_.find(game); it != games_.end()) {
+    return it->second;
+  }
+  auto version = ++counter_;
+  store(game, version);
+  return version;
+}
+
+void VersionMap::store(const boost::uuids::uuid &game, uint64_t version) {
+  games_[game] = version;
+  if (games_.size() <= capacity_) {
+    return;
+  }
+  // Забываем четверть самых старых разом, чтобы не искать их на каждой
+  // вставке
+  std::vector<uint64_t> versions;
+  versions.reserve(games_.size());
+  for (auto &&[_, known] : games_) {
+    versions.push_back(known);
+  }
+  auto keep = capacity_ - capacity_ / 4;
+  auto oldest = versions.end() - keep;
+  std::ranges::nth_element(versions, oldest);
+  std::erase_if(games_,
+                [threshold = *oldest](auto &&entry) {
+                  return entry.second < threshold;
+                });
+}
+
+void VersionMap::forget(const boost::uuids::uuid &game) {
+  std::unique_lock lock(mutex_);
+  games_.erase(game);
+  listVersion_ = ++counter_;
+}
+
+size_t VersionMap::size() const {
+  std::shared_lock lock(mutex_);
+  return games_.size();
+}
+
+std::string VersionMap::etag(uint64_t version) const {
+  return std::format("\"{:x}-{}\"", epoch_, version);
+}
+} // namespace core
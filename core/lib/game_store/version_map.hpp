@@ -0,0 +1,80 @@
+#pragma once
+
+#include <boost/uuid/uuid.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace core {
+/**
+ * @brief Версии игр и списка игр в памяти процесса
+ *
+ * Любое изменение игры получает новый номер из общего монотонного счётчика,
+ * поэтому номер версии заодно упорядочивает изменения во времени. По этим
+ * номерам строятся сильные ETag: условный GET отвечает 304 без обращения
+ * к PostgreSQL и без сериализации.
+ *
+ * Помнит не больше @c capacity игр: сверх того забываются давно не
+ * менявшиеся. Забытая игра при следующем чтении получает новую версию,
+ * так что клиент лишь перечитает её, но не получит устаревший 304.
+ *
+ * @warning Версии верны, пока этот процесс — единственный, кто пишет в
+ * таблицу games. Эпоха процесса в ETag обнуляет теги после перезапуска.
+ */
+struct VersionMap {
+  explicit VersionMap(size_t capacity = kDefaultCapacity);
+
+  /// Версия списка игр: меняется при создании и удалении любой игры
+  uint64_t listVersion() const;
+
+  /// Версия игры, если она известна процессу
+  std::optional<uint64_t> gameVersion(const boost::uuids::uuid &game) const;
+
+  /// Новая игра: меняет версию игры и списка, возвращает версию игры
+  uint64_t create(const boost::uuids::uuid &game);
+
+  /**
+   * @brief Отмечает изменение игры, возвращает её новую версию
+   *
+   * Список игр содержит только ссылки на них, поэтому его версия остаётся
+   * прежней.
+   */
+  uint64_t touch(const boost::uuids::uuid &game);
+
+  /**
+   * @brief Запоминает игру, прочитанную из базы
+   *
+   * Если игра уже известна, версия не меняется.
+   */
+  uint64_t remember(const boost::uuids::uuid &game);
+
+  /// Удалённая игра: забываем её версию и меняем версию списка
+  void forget(const boost::uuids::uuid &game);
+
+  /// Сильный ETag для версии: "<эпоха>-<версия>"
+  std::string etag(uint64_t version) const;
+
+  /// Сколько игр помнит процесс
+  size_t size() const;
+
+  static constexpr size_t kDefaultCapacity = 100'000;
+
+private:
+  /// Записывает версию игры и при переполнении забывает самые старые
+  void store(const boost::uuids::uuid &game, uint64_t version);
+
+  struct UuidHash {
+    size_t operator()(const boost::uuids::uuid &uuid) const noexcept;
+  };
+
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<boost::uuids::uuid, uint64_t, UuidHash> games_;
+  uint64_t counter_ = 0;
+  uint64_t listVersion_ = 0;
+  const size_t capacity_;
+  const uint64_t epoch_;
+};
+} // namespace core
@@ -0,0 +1,134 @@
+#include "ids.hpp"
+
+#include <boost/uuid/random_generator.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace ids {
+namespace {
+// Позиции дефисов в канонической записи, считая в байтах UUID
+constexpr bool isDashBefore(std::size_t byte) {
+  return byte == 4 or byte == 6 or byte == 8 or byte == 10;
+}
+
+// Два шестнадцатеричных символа на каждое значение байта
+constexpr auto kHexPairs = [] {
+  constexpr std::string_view digits = "0123456789abcdef";
+  std::array<std::array<char, 2>, 256> table{};
+  for (std::size_t value = 0; value < table.size(); ++value) {
+    table[value] = {digits[value >> 4], digits[value & 0x0f]};
+  }
+  return table;
+}();
+
+constexpr std::uint8_t kInvalid = 0xff;
+
+// Значение шестнадцатеричной цифры или kInvalid
+constexpr auto kHexValues = [] {
+  std::array<std::uint8_t, 256> table{};
+  table.fill(kInvalid);
+  for (std::uint8_t digit = 0; digit < 10; ++digit) {
+    table['0' + digit] = digit;
+  }
+  for (std::uint8_t digit = 0; digit < 6; ++digit) {
+    table['a' + digit] = 10 + digit;
+    table['A' + digit] = 10 + digit;
+  }
+  return table;
+}();
+
+// Криптостойкий источник ОС, свой у каждого потока: состояние mt19937
+// восстанавливается по выданным id
+void fillRandom(boost::uuids::uuid &uuid) {
+  thread_local boost::uuids::random_generator generator;
+  uuid = generator();
+}
+
+void setVersion(boost::uuids::uuid &uuid, std::uint8_t version) {
+  uuid.data[6] = std::uint8_t((uuid.data[6] & 0x0f) | (version << 4));
+  // Вариант RFC 4122/9562: 10xx
+  uuid.data[8] = std::uint8_t((uuid.data[8] & 0x3f) | 0x80);
+}
+} // namespace
+
+boost::uuids::uuid generateV4() {
+  boost::uuids::uuid uuid;
+  fillRandom(uuid);
+  setVersion(uuid, 4);
+  return uuid;
+}
+
+boost::uuids::uuid generateV7() {
+  thread_local std::uint64_t lastMillis = 0;
+  thread_local std::uint16_t counter = 0;
+  auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::system_clock::now().time_since_epoch())
+                 .count();
+  std::uint64_t millis = now > 0 ? std::uint64_t(now) : 0;
+  boost::uuids::uuid uuid;
+  fillRandom(uuid);
+  if (millis > lastMillis) {
+    lastMillis = millis;
+    // Счётчик новой миллисекунды начинается со случайных бит этого id
+    counter = std::uint16_t((uuid.data[6] << 8 | uuid.data[7]) & 0x01ff);
+  } else if (++counter > 0x0fff) {
+    // Счётчик исчерпан: одалживаем следующую миллисекунду
+    ++lastMillis;
+    counter = 0;
+  }
+
+  for (std::size_t byte = 0; byte < 6; ++byte) {
+    uuid.data[byte] = std::uint8_t(lastMillis >> (40 - byte * 8));
+  }
+  uuid.data[6] = std::uint8_t(counter >> 8);
+  uuid.data[7] = std::uint8_t(counter);
+  setVersion(uuid, 7);
+  return uuid;
+}
+
+char *format(const boost::uuids::uuid &uuid, char *out) noexcept {
+  for (std::size_t byte = 0; byte < uuid.size(); ++byte) {
+    if (isDashBefore(byte)) {
+      *out++ = '-';
+    }
+    auto &&pair = kHexPairs[uuid.data[byte]];
+    *out++ = pair[0];
+    *out++ = pair[1];
+  }
+  return out;
+}
+
+void appendTo(std::string &out, const boost::uuids::uuid &uuid) {
+  auto offset = out.size();
+  out.resize(offset + kUuidLength);
+  format(uuid, out.data() + offset);
+}
+
+std::string toString(const boost::uuids::uuid &uuid) {
+  std::string out;
+  appendTo(out, uuid);
+  return out;
+}
+
+std::optional<boost::uuids::uuid> parse(std::string_view text) noexcept {
+  if (text.size() != kUuidLength) {
+    return std::nullopt;
+  }
+  boost::uuids::uuid uuid;
+  const char *it = text.data();
+  for (std::size_t byte = 0; byte < uuid.size(); ++byte) {
+    if (isDashBefore(byte) and *it++ != '-') {
+      return std::nullopt;
+    }
+    auto high = kHexValues[std::uint8_t(*it++)];
+    auto low = kHexValues[std::uint8_t(*it++)];
+    if (high == kInvalid or low == kInvalid) {
+      return std::nullopt;
+    }
+    uuid.data[byte] = std::uint8_t(high << 4 | low);
+  }
+  return uuid;
+}
+} // namespace ids
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <boost/uuid/uuid.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Генерация и разбор идентификаторов на горячем пути запросов.
+ *
+ * Генераторы живут по одному на поток и берут случайность у ОС, а
+ * форматирование и разбор идут по таблицам и пишут прямо в буфер вызывающего
+ * без временных строк.
+ */
+namespace ids {
+// Длина канонической записи xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
+constexpr std::size_t kUuidLength = 36;
+
+/**
+ * @brief Случайный UUID версии 4
+ *
+ * @note Источник случайности — криптостойкий генератор ОС через
+ * boost::uuids::random_generator своего потока: id игр служат ссылками
+ * на них, и по выданным id нельзя предсказать следующие. Цена — чтение
+ * из ОС (getrandom) на каждый id.
+ */
+boost::uuids::uuid generateV4();
+
+/**
+ * @brief UUID версии 7 (RFC 9562): миллисекунды Unix-времени в старших битах
+ *
+ * Такие ключи монотонно растут, поэтому вставки ложатся в правый край
+ * B-дерева индекса. В пределах одной миллисекунды порядок внутри потока
+ * сохраняется за счёт 12-битного счётчика.
+ */
+boost::uuids::uuid generateV7();
+
+/**
+ * @brief Пишет каноническую запись UUID в @p out
+ *
+ * @param out Буфер минимум на kUuidLength символов
+ * @return Указатель за последним записанным символом
+ */
+char *format(const boost::uuids::uuid &uuid, char *out) noexcept;
+
+/**
+ * @brief Дописывает каноническую запись UUID в конец строки
+ */
+void appendTo(std::string &out, const boost::uuids::uuid &uuid);
+
+std::string toString(const boost::uuids::uuid &uuid);
+
+/**
+ * @brief Разбирает каноническую запись UUID (регистр не важен)
+ *
+ * @return std::nullopt, если строка не является UUID
+ */
+std::optional<boost::uuids::uuid> parse(std::string_view text) noexcept;
+} // namespace ids
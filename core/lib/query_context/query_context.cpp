@@ -0,0 +1,72 @@
+#include "query_context.hpp"
+
+#include <algorithm>
+
+namespace database {
+namespace {
+thread_local const QueryContext *currentContext = nullptr;
+} // namespace
+
+const QueryContext *QueryContext::current() { return currentContext; }
+
+QueryContext::Scope::Scope(const QueryContext &context)
+    : previous_(currentContext) {
+  currentContext = &context;
+}
+
+QueryContext::Scope::~Scope() { currentContext = previous_; }
+
+QueryWatchdog::QueryWatchdog(std::function<void()> cancel)
+    : cancel_(std::move(cancel)), worker_([this] { loop(); }) {}
+
+QueryWatchdog::~QueryWatchdog() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wakeUp_.notify_one();
+  worker_.join();
+}
+
+QueryWatchdog::Watch QueryWatchdog::watch(const QueryContext &context) {
+  {
+    std::lock_guard lock(mutex_);
+    watched_ = &context;
+    fired_ = false;
+  }
+  wakeUp_.notify_one();
+  return Watch(*this);
+}
+
+QueryWatchdog::Watch::~Watch() {
+  std::lock_guard lock(owner_.mutex_);
+  owner_.watched_ = nullptr;
+}
+
+bool QueryWatchdog::Watch::fired() const {
+  std::lock_guard lock(owner_.mutex_);
+  return owner_.fired_;
+}
+
+void QueryWatchdog::loop() {
+  std::unique_lock lock(mutex_);
+  while (!stopping_) {
+    if (!watched_ or fired_) {
+      wakeUp_.wait(lock);
+      continue;
+    }
+    auto now = QueryContext::Clock::now();
+    if (now >= watched_->deadline or
+        (watched_->abandoned and watched_->abandoned())) {
+      fired_ = true;
+      cancel_();
+      continue;
+    }
+    auto wake = watched_->deadline;
+    if (watched_->abandoned) {
+      wake = std::min(wake, now + kPollInterval);
+    }
+    wakeUp_.wait_until(lock, wake);
+  }
+}
+} // namespace database
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace database {
+/**
+ * @brief Срок запроса и признак ухода клиента, идущие от HTTP к базе
+ *
+ * Сервер делает контекст текущим на время синхронного обработчика
+ * (Scope), а асинхронный запускает на исполнителе, который ставит Scope
+ * при каждом возобновлении. Database читает его перед каждым запросом:
+ * не отправляет запрос с истёкшим сроком и поручает QueryWatchdog
+ * отменить его, если срок истечёт или клиент отключится.
+ */
+struct QueryContext {
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point deadline = Clock::time_point::max();
+  // Вызывается из потока сторожа; true — результат больше никому не нужен
+  std::function<bool()> abandoned;
+  // Хеш клиента для read-your-writes в RoutingDatabase; 0 — неизвестен
+  size_t client = 0;
+
+  /// Контекст текущего потока или nullptr
+  static const QueryContext *current();
+
+  /**
+   * @brief Делает контекст текущим для потока до конца области видимости
+   *
+   * Только вокруг синхронного кода: через co_await контекст достался бы
+   * другим корутинам того же потока.
+   */
+  struct Scope {
+    explicit Scope(const QueryContext &context);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    const QueryContext *previous_;
+  };
+};
+
+/**
+ * @brief Запрос отменён: истёк срок или клиент отключился
+ */
+struct QueryCancelled : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Поток, отменяющий запрос по сроку или уходу клиента
+ *
+ * Соединение с базой выполняет один запрос за раз, поэтому сторож следит
+ * за одним контекстом. Отмена вызывается под его мьютексом: закончившийся
+ * запрос снимается с наблюдения только после неё, и отмена не достанется
+ * следующему.
+ */
+struct QueryWatchdog {
+  /**
+   * @param cancel Отменяет текущий запрос соединения (PQcancel)
+   */
+  explicit QueryWatchdog(std::function<void()> cancel);
+  ~QueryWatchdog();
+
+  QueryWatchdog(const QueryWatchdog &) = delete;
+  QueryWatchdog &operator=(const QueryWatchdog &) = delete;
+
+  /**
+   * @brief Наблюдение за запросом, пока объект жив
+   */
+  struct Watch {
+    ~Watch();
+
+    Watch(const Watch &) = delete;
+    Watch &operator=(const Watch &) = delete;
+
+    /// Сторож отменил запрос
+    bool fired() const;
+
+  private:
+    friend QueryWatchdog;
+    explicit Watch(QueryWatchdog &owner) : owner_(owner) {}
+
+    QueryWatchdog &owner_;
+  };
+
+  /**
+   * @brief Следит за @p context до разрушения результата
+   *
+   * @p context должен пережить Watch.
+   */
+  Watch watch(const QueryContext &context);
+
+  // Как часто спрашивать, не ушёл ли клиент
+  static constexpr std::chrono::milliseconds kPollInterval{50};
+
+private:
+  void loop();
+
+  std::function<void()> cancel_;
+  mutable std::mutex mutex_;
+  std::condition_variable wakeUp_;
+  const QueryContext *watched_ = nullptr;
+  bool fired_ = false;
+  bool stopping_ = false;
+  std::thread worker_;
+};
+} // namespace database
@@ -151,7 +151,7 @@ ResourceTree::tryMatch(segments_encoded_view::const_iterator it,
       // Поле замены
       auto &&id = child.seg.id();
       BOOST_ASSERT(!matches.contains(id));
-      matches[id] = segment;
+      matches[id] = std::string_view(segment.data(), segment.size());
       if (!needBranching) {
         // Идём вглубь, мы нашли единственный вариант на этом уровне
         cur = &child;
@@ -16,14 +16,18 @@
 #include <boost/url/parse_path.hpp>
 
 #include <deque>
+#include <memory_resource>
 #include <stdexcept>
+#include <string>
 #include <unordered_map>
 
 namespace boost {
 namespace urls {
 namespace router {
 
-using MatchesStorage = std::unordered_map<std::string_view, std::string>;
+// Ключи ссылаются на шаблоны маршрутов, значения выделяются из арены запроса
+using MatchesStorage =
+    std::pmr::unordered_map<std::string_view, std::pmr::string>;
 
 // Паттерн сегмента пути к ресурсу
 struct SegmentPattern {
@@ -0,0 +1,173 @@
+#include "admission.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace asio = boost::asio;
+
+namespace core {
+GradientLimiter::GradientLimiter(size_t initial, size_t min, size_t max)
+    : limit_(double(std::clamp(initial, min, max))), min_(double(min)),
+      max_(double(max)) {}
+
+void GradientLimiter::sample(std::chrono::nanoseconds latency,
+                             size_t inFlight) {
+  // Нулевая задержка бывает у ответов из кэша и ломает отношение
+  double current = std::max<double>(double(latency.count()), 1.0);
+  if (longLatency_ == 0) {
+    shortLatency_ = longLatency_ = current;
+  } else {
+    shortLatency_ += (current - shortLatency_) / kShortWindow;
+    longLatency_ += (current - longLatency_) / kLongWindow;
+  }
+  // Нагрузка спала: долгая средняя слишком отстала, подтягиваем её
+  if (longLatency_ / shortLatency_ > 2) {
+    longLatency_ *= 0.95;
+  }
+  if (double(inFlight) < limit_ / 2) {
+    return;
+  }
+  double gradient =
+      std::clamp(kTolerance * longLatency_ / shortLatency_, 0.5, 1.0);
+  double target = limit_ * gradient + std::sqrt(limit_);
+  limit_ = std::clamp(limit_ * (1 - kSmoothing) + target * kSmoothing, min_,
+                      max_);
+}
+
+size_t GradientLimiter::limit() const { return size_t(limit_); }
+
+AdmissionController::AdmissionController(AdmissionOptions options)
+    : options_(options),
+      limiter_(options.initialLimit, options.minLimit, options.maxLimit) {}
+
+AdmissionController::Permit::Permit(AdmissionController &owner,
+                                    size_t inFlight)
+    : owner_(&owner), inFlight_(inFlight),
+      start_(std::chrono::steady_clock::now()) {}
+
+AdmissionController::Permit::Permit(Permit &&other) noexcept
+    : owner_(std::exchange(other.owner_, nullptr)), inFlight_(other.inFlight_),
+      start_(other.start_) {}
+
+AdmissionController::Permit::~Permit() {
+  if (owner_) {
+    owner_->release(std::chrono::steady_clock::now() - start_, inFlight_);
+  }
+}
+
+void AdmissionController::configure(AdmissionOptions options) {
+  std::shared_ptr<Waiter> acceptor;
+  {
+    std::lock_guard lock(mutex_);
+    options_ = options;
+    limiter_ = GradientLimiter(options.initialLimit, options.minLimit,
+                               options.maxLimit);
+    // Предел соединений могли поднять: acceptor проверит его заново
+    acceptor = std::exchange(acceptor_, nullptr);
+  }
+  if (acceptor) {
+    wake(acceptor);
+  }
+}
+
+asio::awaitable<std::optional<AdmissionController::Permit>>
+AdmissionController::admit() {
+  auto executor = co_await asio::this_coro::executor;
+  std::shared_ptr<Waiter> waiter;
+  {
+    std::lock_guard lock(mutex_);
+    if (inFlight_ < limiter_.limit()) {
+      ++inFlight_;
+      co_return Permit(*this, inFlight_);
+    }
+    if (queue_.size() >= options_.queueSize) {
+      co_return std::nullopt;
+    }
+    waiter = std::make_shared<Waiter>(executor);
+    waiter->timer.expires_after(options_.queueTimeout);
+    queue_.push_back(waiter);
+  }
+  // Истечение срока — отказ, пробуждение — слот уже наш
+  co_await waiter->timer.async_wait(asio::as_tuple(asio::use_awaitable));
+  std::lock_guard lock(mutex_);
+  if (waiter->granted) {
+    co_return Permit(*this, inFlight_);
+  }
+  std::erase(queue_, waiter);
+  co_return std::nullopt;
+}
+
+void AdmissionController::release(std::chrono::nanoseconds latency,
+                                  size_t inFlight) {
+  std::shared_ptr<Waiter> next;
+  {
+    std::lock_guard lock(mutex_);
+    limiter_.sample(latency, inFlight);
+    // Слот переходит первому в очереди, если лимит его ещё допускает
+    if (!queue_.empty() and inFlight_ <= limiter_.limit()) {
+      next = std::move(queue_.front());
+      queue_.pop_front();
+      next->granted = true;
+    } else {
+      --inFlight_;
+    }
+  }
+  if (next) {
+    wake(next);
+  }
+}
+
+asio::awaitable<void> AdmissionController::enterSession() {
+  auto executor = co_await asio::this_coro::executor;
+  for (;;) {
+    std::shared_ptr<Waiter> waiter;
+    {
+      std::lock_guard lock(mutex_);
+      if (sessions_ < options_.maxSessions) {
+        ++sessions_;
+        co_return;
+      }
+      waiter = std::make_shared<Waiter>(executor);
+      waiter->timer.expires_at(asio::steady_timer::time_point::max());
+      acceptor_ = waiter;
+    }
+    co_await waiter->timer.async_wait(asio::as_tuple(asio::use_awaitable));
+  }
+}
+
+void AdmissionController::leaveSession() {
+  std::shared_ptr<Waiter> acceptor;
+  {
+    std::lock_guard lock(mutex_);
+    --sessions_;
+    acceptor = std::exchange(acceptor_, nullptr);
+  }
+  if (acceptor) {
+    wake(acceptor);
+  }
+}
+
+void AdmissionController::wake(const std::shared_ptr<Waiter> &waiter) {
+  // Срок в прошлом, а не cancel(): если корутина ещё не успела заснуть,
+  // её async_wait завершится сразу
+  asio::post(waiter->timer.get_executor(), [waiter] {
+    waiter->timer.expires_at(asio::steady_timer::time_point::min());
+  });
+}
+
+size_t AdmissionController::inFlight() const {
+  std::lock_guard lock(mutex_);
+  return inFlight_;
+}
+
+size_t AdmissionController::limit() const {
+  std::lock_guard lock(mutex_);
+  return limiter_.limit();
+}
+
+size_t AdmissionController::sessions() const {
+  std::lock_guard lock(mutex_);
+  return sessions_;
+}
+} // namespace core
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace core {
+/**
+ * @brief Пределы нагрузки на сервер
+ */
+struct AdmissionOptions {
+  // Одновременных соединений; на пределе acceptor перестаёт принимать
+  size_t maxSessions = 10'000;
+  // Границы и начальное значение адаптивного лимита запросов в работе
+  size_t minLimit = 4;
+  size_t maxLimit = 512;
+  size_t initialLimit = 32;
+  // Сколько запросов сверх лимита может ждать слота и как долго
+  size_t queueSize = 64;
+  std::chrono::milliseconds queueTimeout{100};
+  // Значение Retry-After в ответе 503
+  std::chrono::seconds retryAfter{1};
+
+  friend bool operator==(const AdmissionOptions &,
+                         const AdmissionOptions &) = default;
+};
+
+/**
+ * @brief Адаптивный лимит параллелизма по градиенту задержки
+ *
+ * Сравнивает короткую (последние запросы) и долгую среднюю задержку, как
+ * TCP Vegas сравнивает RTT с базовым. Пока они близки, очереди нет и
+ * лимит растёт на sqrt(limit); когда короткая растёт, лимит уменьшается
+ * пропорционально их отношению. Если запросов в работе меньше половины
+ * лимита, замер лимит не меняет: нагрузки нет, и задержка ничего не
+ * говорит о пропускной способности.
+ *
+ * Не потокобезопасен.
+ */
+struct GradientLimiter {
+  GradientLimiter(size_t initial, size_t min, size_t max);
+
+  /**
+   * @brief Учитывает задержку одного запроса
+   *
+   * @param inFlight Сколько запросов было в работе, когда он начался
+   */
+  void sample(std::chrono::nanoseconds latency, size_t inFlight);
+
+  size_t limit() const;
+
+private:
+  // Допустимый рост задержки, при котором лимит ещё не снижается
+  static constexpr double kTolerance = 1.5;
+  static constexpr double kSmoothing = 0.2;
+  static constexpr double kShortWindow = 10;
+  static constexpr double kLongWindow = 600;
+
+  double limit_;
+  double min_;
+  double max_;
+  double shortLatency_ = 0;
+  double longLatency_ = 0;
+};
+
+/**
+ * @brief Admission control: сколько запросов и соединений сервер берёт в
+ * работу
+ *
+ * Запрос получает разрешение (Permit), пока в работе меньше адаптивного
+ * лимита. Иначе он ждёт слота в ограниченной очереди не дольше
+ * queueTimeout, а если очередь полна или время вышло — получает отказ, и
+ * сервер сразу отвечает 503. Завершившийся запрос отдаёт слот первому из
+ * очереди и сообщает лимитеру свою задержку.
+ */
+struct AdmissionController {
+  explicit AdmissionController(AdmissionOptions options = {});
+
+  /**
+   * @brief Разрешение на обработку одного запроса
+   *
+   * Разрушение освобождает слот. Задержкой считается время жизни
+   * разрешения, без ожидания в очереди.
+   */
+  struct Permit {
+    Permit(Permit &&other) noexcept;
+    Permit &operator=(Permit &&) = delete;
+    ~Permit();
+
+  private:
+    friend AdmissionController;
+    Permit(AdmissionController &owner, size_t inFlight);
+
+    AdmissionController *owner_;
+    size_t inFlight_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  /// Меняет пределы; лимит начинается заново с initialLimit
+  void configure(AdmissionOptions options);
+
+  const AdmissionOptions &options() const { return options_; }
+
+  /// Разрешение или std::nullopt, если сервер перегружен
+  boost::asio::awaitable<std::optional<Permit>> admit();
+
+  /// Ждёт, пока соединений станет меньше maxSessions, и занимает место
+  boost::asio::awaitable<void> enterSession();
+
+  /// Соединение закрыто: его место может занять следующее
+  void leaveSession();
+
+  size_t inFlight() const;
+  size_t limit() const;
+  size_t sessions() const;
+
+private:
+  struct Waiter {
+    explicit Waiter(boost::asio::any_io_executor executor)
+        : timer(std::move(executor)) {}
+    boost::asio::steady_timer timer;
+    // Слот передан ожидающему завершившимся запросом
+    bool granted = false;
+  };
+
+  void release(std::chrono::nanoseconds latency, size_t inFlight);
+  static void wake(const std::shared_ptr<Waiter> &waiter);
+
+  mutable std::mutex mutex_;
+  AdmissionOptions options_;
+  GradientLimiter limiter_;
+  size_t inFlight_ = 0;
+  std::deque<std::shared_ptr<Waiter>> queue_;
+  size_t sessions_ = 0;
+  // Acceptor, ждущий освобождения места под соединение
+  std::shared_ptr<Waiter> acceptor_;
+};
+} // namespace core
@@ -0,0 +1,273 @@
+#include "compression.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+
+#if defined(CORE_WITH_GZIP)
+#include <zlib.h>
+#endif
+#if defined(CORE_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace core {
+namespace {
+std::string_view trim(std::string_view str) {
+  auto begin = str.find_first_not_of(" \t");
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  auto end = str.find_last_not_of(" \t");
+  return str.substr(begin, end - begin + 1);
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+  return std::ranges::equal(a, b, [](char x, char y) {
+    return std::tolower(static_cast<unsigned char>(x)) ==
+           std::tolower(static_cast<unsigned char>(y));
+  });
+}
+
+// Вес q в тысячных, как в RFC 9110 (не более трёх знаков после точки)
+int parseQuality(std::string_view params) {
+  int quality = 1000;
+  while (!params.empty()) {
+    auto semicolon = params.find(';');
+    auto param = trim(params.substr(0, semicolon));
+    if (param.size() > 2 and (param[0] == 'q' or param[0] == 'Q') and
+        param[1] == '=') {
+      auto value = param.substr(2);
+      double parsed = 0;
+      auto [_, ec] =
+          std::from_chars(value.data(), value.data() + value.size(), parsed);
+      quality = ec == std::errc() ? int(std::clamp(parsed, 0.0, 1.0) * 1000)
+                                  : 0;
+    }
+    if (semicolon == std::string_view::npos) {
+      break;
+    }
+    params.remove_prefix(semicolon + 1);
+  }
+  return quality;
+}
+
+constexpr bool isSupported(Encoding encoding) {
+  switch (encoding) {
+  case Encoding::identity:
+    return true;
+  case Encoding::gzip:
+#if defined(CORE_WITH_GZIP)
+    return true;
+#else
+    return false;
+#endif
+  case Encoding::zstd:
+#if defined(CORE_WITH_ZSTD)
+    return true;
+#else
+    return false;
+#endif
+  }
+  return false;
+}
+
+// Размер блока, которым растёт выходной буфер при потоковом сжатии
+constexpr size_t kChunkSize = 16 * 1024;
+
+#if defined(CORE_WITH_GZIP)
+struct GzipContext {
+  GzipContext() {
+    // 15 + 16: окно 32 КиБ и заголовок gzip вместо zlib
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      throw std::runtime_error("deflateInit2 failed");
+    }
+  }
+  ~GzipContext() { deflateEnd(&stream); }
+  GzipContext(const GzipContext &) = delete;
+  GzipContext &operator=(const GzipContext &) = delete;
+
+  z_stream stream{};
+};
+
+std::string gzip(std::string_view body, int level) {
+  thread_local GzipContext context;
+  auto &stream = context.stream;
+  deflateReset(&stream);
+  deflateParams(&stream, level, Z_DEFAULT_STRATEGY);
+  stream.next_in =
+      reinterpret_cast<Bytef *>(const_cast<char *>(body.data()));
+  stream.avail_in = uInt(body.size());
+  std::string out;
+  int status = Z_OK;
+  while (status != Z_STREAM_END) {
+    auto offset = out.size();
+    out.resize(offset + kChunkSize);
+    stream.next_out = reinterpret_cast<Bytef *>(out.data() + offset);
+    stream.avail_out = uInt(kChunkSize);
+    status = deflate(&stream, Z_FINISH);
+    if (status == Z_STREAM_ERROR) {
+      throw std::runtime_error("deflate failed");
+    }
+    out.resize(offset + kChunkSize - stream.avail_out);
+  }
+  return out;
+}
+#endif
+
+#if defined(CORE_WITH_ZSTD)
+struct ZstdContext {
+  ZstdContext() : cctx(ZSTD_createCCtx()) {
+    if (!cctx) {
+      throw std::runtime_error("ZSTD_createCCtx failed");
+    }
+  }
+  ~ZstdContext() { ZSTD_freeCCtx(cctx); }
+  ZstdContext(const ZstdContext &) = delete;
+  ZstdContext &operator=(const ZstdContext &) = delete;
+
+  ZSTD_CCtx *cctx;
+};
+
+std::string zstd(std::string_view body, int level) {
+  thread_local ZstdContext context;
+  ZSTD_CCtx_reset(context.cctx, ZSTD_reset_session_only);
+  ZSTD_CCtx_setParameter(context.cctx, ZSTD_c_compressionLevel, level);
+  ZSTD_CCtx_setPledgedSrcSize(context.cctx, body.size());
+  ZSTD_inBuffer input{body.data(), body.size(), 0};
+  std::string out;
+  size_t remaining = 0;
+  do {
+    auto offset = out.size();
+    out.resize(offset + kChunkSize);
+    ZSTD_outBuffer output{out.data() + offset, kChunkSize, 0};
+    remaining = ZSTD_compressStream2(context.cctx, &output, &input, ZSTD_e_end);
+    if (ZSTD_isError(remaining)) {
+      throw std::runtime_error(ZSTD_getErrorName(remaining));
+    }
+    out.resize(offset + output.pos);
+  } while (remaining != 0);
+  return out;
+}
+#endif
+} // namespace
+
+std::string_view encodingName(Encoding encoding) {
+  switch (encoding) {
+  case Encoding::gzip:
+    return "gzip";
+  case Encoding::zstd:
+    return "zstd";
+  case Encoding::identity:
+    break;
+  }
+  return "identity";
+}
+
+Encoding negotiateEncoding(std::string_view acceptEncoding) {
+  int gzipQuality = -1;
+  int zstdQuality = -1;
+  int anyQuality = -1;
+  while (!acceptEncoding.empty()) {
+    auto comma = acceptEncoding.find(',');
+    auto item = trim(acceptEncoding.substr(0, comma));
+    auto semicolon = item.find(';');
+    auto coding = trim(item.substr(0, semicolon));
+    int quality = semicolon == std::string_view::npos
+                      ? 1000
+                      : parseQuality(item.substr(semicolon + 1));
+    if (iequals(coding, "gzip") or iequals(coding, "x-gzip")) {
+      gzipQuality = quality;
+    } else if (iequals(coding, "zstd")) {
+      zstdQuality = quality;
+    } else if (coding == "*") {
+      anyQuality = quality;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    acceptEncoding.remove_prefix(comma + 1);
+  }
+  // Явно не названные кодировки получают вес "*"
+  if (gzipQuality < 0) {
+    gzipQuality = anyQuality;
+  }
+  if (zstdQuality < 0) {
+    zstdQuality = anyQuality;
+  }
+  if (!isSupported(Encoding::zstd)) {
+    zstdQuality = -1;
+  }
+  if (!isSupported(Encoding::gzip)) {
+    gzipQuality = -1;
+  }
+  if (zstdQuality > 0 and zstdQuality >= gzipQuality) {
+    return Encoding::zstd;
+  }
+  if (gzipQuality > 0) {
+    return Encoding::gzip;
+  }
+  return Encoding::identity;
+}
+
+std::string compress(std::string_view body, Encoding encoding, int level) {
+  switch (encoding) {
+#if defined(CORE_WITH_GZIP)
+  case Encoding::gzip:
+    return gzip(body, level);
+#endif
+#if defined(CORE_WITH_ZSTD)
+  case Encoding::zstd:
+    return zstd(body, level);
+#endif
+  default:
+    throw std::invalid_argument("Unsupported content encoding");
+  }
+}
+
+std::shared_ptr<const std::string>
+CompressionCache::find(const std::string &key) {
+  std::lock_guard lock(mutex_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  // Свежее использование — в начало списка
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return it->second->second;
+}
+
+void CompressionCache::insert(const std::string &key,
+                              std::shared_ptr<const std::string> body) {
+  std::lock_guard lock(mutex_);
+  if (body->size() > capacityBytes_) {
+    return;
+  }
+  if (auto it = index_.find(key); it != index_.end()) {
+    sizeBytes_ -= it->second->second->size();
+    lru_.erase(it->second);
+    index_.erase(it);
+  }
+  sizeBytes_ += body->size();
+  lru_.emplace_front(key, std::move(body));
+  index_[key] = lru_.begin();
+  evict();
+}
+
+void CompressionCache::setCapacity(size_t capacityBytes) {
+  std::lock_guard lock(mutex_);
+  capacityBytes_ = capacityBytes;
+  evict();
+}
+
+void CompressionCache::evict() {
+  while (sizeBytes_ > capacityBytes_ and !lru_.empty()) {
+    auto &&[key, body] = lru_.back();
+    sizeBytes_ -= body->size();
+    index_.erase(key);
+    lru_.pop_back();
+  }
+}
+} // namespace core
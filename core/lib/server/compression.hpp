@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace core {
+/**
+ * @brief Кодирование содержимого ответа (Content-Encoding)
+ *
+ * gzip доступен при сборке с zlib (CORE_WITH_GZIP), zstd — с libzstd
+ * (CORE_WITH_ZSTD). Без них ответы уходят несжатыми.
+ */
+enum class Encoding { identity, gzip, zstd };
+
+std::string_view encodingName(Encoding encoding);
+
+/**
+ * @brief Выбирает кодировку по заголовку Accept-Encoding
+ *
+ * Учитывает q-значения и "*", при равных весах предпочитает zstd.
+ * Кодировки, не собранные в бинарник, не предлагаются.
+ */
+Encoding negotiateEncoding(std::string_view acceptEncoding);
+
+/**
+ * @brief Сжимает @p body потоково, блоками прямо в выходную строку
+ *
+ * Контексты компрессоров создаются по одному на поток и переиспользуются
+ * между вызовами.
+ */
+std::string compress(std::string_view body, Encoding encoding, int level);
+
+struct CompressionOptions {
+  // Ответы меньше порога не сжимаются: выигрыш не окупает заголовки и CPU
+  size_t minSize = 1024;
+  int gzipLevel = 6;
+  int zstdLevel = 3;
+  // Предел памяти под кэш сжатых неизменяемых ответов
+  size_t cacheBytes = 8 * 1024 * 1024;
+};
+
+/**
+ * @brief LRU-кэш уже сжатых ответов
+ *
+ * Ключ включает ETag, поэтому попадание гарантирует, что тело не менялось:
+ * горячие ответы сжимаются один раз, а не на каждый запрос.
+ */
+struct CompressionCache {
+  explicit CompressionCache(size_t capacityBytes)
+      : capacityBytes_(capacityBytes) {}
+
+  std::shared_ptr<const std::string> find(const std::string &key);
+  void insert(const std::string &key,
+              std::shared_ptr<const std::string> body);
+
+  void setCapacity(size_t capacityBytes);
+
+private:
+  using Entry = std::pair<std::string, std::shared_ptr<const std::string>>;
+  void evict();
+
+  std::mutex mutex_;
+  std::list<Entry> lru_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  size_t capacityBytes_;
+  size_t sizeBytes_ = 0;
+};
+} // namespace core
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <boost/asio.hpp>
+
+#include <type_traits>
+#include <utility>
+
+#include "query_context.hpp"
+
+namespace core {
+/**
+ * @brief Исполнитель, делающий QueryContext запроса текущим на время
+ * каждого вызова
+ *
+ * QueryContext::Scope нельзя держать через co_await: контекст достался бы
+ * другим корутинам потока. Корутина, запущенная на ContextExecutor,
+ * возобновляется только через него и видит свой контекст после каждого
+ * co_await. Объекты, переживающие запрос (strand игры), создают на
+ * исполнителе без контекста, см. withoutQueryContext().
+ */
+template <typename Executor> struct ContextExecutor {
+  /**
+   * @param context Контекст, переживающий все вызовы; nullptr — без него
+   */
+  ContextExecutor(Executor inner, const database::QueryContext *context)
+      : inner_(std::move(inner)), context_(context) {}
+
+  const Executor &inner() const noexcept { return inner_; }
+
+  template <typename Function> void execute(Function &&function) const {
+    inner_.execute(
+        [context = context_,
+         function = std::forward<Function>(function)]() mutable {
+          if (!context) {
+            std::move(function)();
+            return;
+          }
+          database::QueryContext::Scope scope(*context);
+          std::move(function)();
+        });
+  }
+
+  template <typename Property>
+    requires boost::asio::can_query_v<const Executor &, const Property &>
+  decltype(auto) query(const Property &property) const {
+    return boost::asio::query(inner_, property);
+  }
+
+  template <typename Property>
+    requires boost::asio::can_require_v<const Executor &, const Property &>
+  auto require(const Property &property) const {
+    using Inner = std::decay_t<decltype(boost::asio::require(inner_,
+                                                             property))>;
+    return ContextExecutor<Inner>(boost::asio::require(inner_, property),
+                                  context_);
+  }
+
+  template <typename Property>
+    requires boost::asio::can_prefer_v<const Executor &, const Property &>
+  auto prefer(const Property &property) const {
+    using Inner = std::decay_t<decltype(boost::asio::prefer(inner_,
+                                                            property))>;
+    return ContextExecutor<Inner>(boost::asio::prefer(inner_, property),
+                                  context_);
+  }
+
+  bool operator==(const ContextExecutor &other) const noexcept {
+    return inner_ == other.inner_ and context_ == other.context_;
+  }
+
+private:
+  Executor inner_;
+  const database::QueryContext *context_;
+};
+
+/**
+ * @brief @p executor с контекстом текущего потока
+ */
+template <typename Executor>
+ContextExecutor<Executor> withQueryContext(Executor executor) {
+  return {std::move(executor), database::QueryContext::current()};
+}
+
+/**
+ * @brief Исполнитель под ContextExecutor, если @p executor им обёрнут
+ */
+inline boost::asio::any_io_executor
+withoutQueryContext(const boost::asio::any_io_executor &executor) {
+  if (auto *bound =
+          executor.target<ContextExecutor<boost::asio::any_io_executor>>()) {
+    return bound->inner();
+  }
+  return executor;
+}
+} // namespace core
@@ -0,0 +1,47 @@
+#include "etag.hpp"
+
+namespace core {
+namespace {
+std::string_view trim(std::string_view str) {
+  auto begin = str.find_first_not_of(" \t");
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  auto end = str.find_last_not_of(" \t");
+  return str.substr(begin, end - begin + 1);
+}
+
+std::string_view opaque(std::string_view tag) {
+  if (tag.starts_with("W/")) {
+    tag.remove_prefix(2);
+  }
+  return tag;
+}
+} // namespace
+
+bool etagMatches(std::string_view ifNoneMatch, std::string_view etag) {
+  if (etag.empty()) {
+    return false;
+  }
+  etag = opaque(etag);
+  while (!ifNoneMatch.empty()) {
+    auto comma = ifNoneMatch.find(',');
+    auto candidate = trim(ifNoneMatch.substr(0, comma));
+    if (candidate == "*" or opaque(candidate) == etag) {
+      return true;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    ifNoneMatch.remove_prefix(comma + 1);
+  }
+  return false;
+}
+
+std::string weakEtag(std::string_view etag) {
+  if (etag.starts_with("W/")) {
+    return std::string(etag);
+  }
+  return "W/" + std::string(etag);
+}
+} // namespace core
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace core {
+/**
+ * @brief Проверяет, совпадает ли @p etag с одним из значений If-None-Match
+ *
+ * Поддерживает списки через запятую и "*". Для If-None-Match по RFC 9110
+ * используется слабое сравнение, поэтому префикс W/ игнорируется.
+ */
+bool etagMatches(std::string_view ifNoneMatch, std::string_view etag);
+
+/**
+ * @brief Слабый вариант тега: W/"..."
+ *
+ * Сжатые gzip и zstd варианты ответа побайтно отличаются от исходного и
+ * друг от друга, поэтому сильный тег исходного им не подходит. Слабый
+ * тег говорит, что варианты равнозначны по смыслу, и If-None-Match с ним
+ * по-прежнему совпадает с исходным тегом.
+ */
+std::string weakEtag(std::string_view etag);
+} // namespace core
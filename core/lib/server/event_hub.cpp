@@ -0,0 +1,82 @@
+#include "event_hub.hpp"
+#include "ids.hpp"
+
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+
+namespace core {
+std::string topicOf(std::string_view path) {
+  std::string topic;
+  topic.reserve(path.size());
+  while (!path.empty()) {
+    auto slash = path.find('/', 1);
+    auto segment = path.substr(0, slash);
+    // Сегмент вместе с ведущим '/'
+    if (auto uuid = ids::parse(segment.substr(1)); uuid) {
+      topic.push_back('/');
+      ids::appendTo(topic, *uuid);
+    } else {
+      topic.append(segment);
+    }
+    path.remove_prefix(segment.size());
+  }
+  return topic;
+}
+
+std::shared_ptr<EventHub::Subscription>
+EventHub::subscribe(const std::string &topic,
+                    boost::asio::any_io_executor executor, size_t capacity) {
+  auto subscription =
+      std::make_shared<Subscription>(std::move(executor), capacity);
+  std::lock_guard lock(mutex_);
+  topics_[topic].push_back(subscription);
+  return subscription;
+}
+
+void EventHub::unsubscribe(const std::string &topic,
+                           const std::shared_ptr<Subscription> &subscription) {
+  std::lock_guard lock(mutex_);
+  auto it = topics_.find(topic);
+  if (it == topics_.end()) {
+    return;
+  }
+  std::erase_if(it->second, [&subscription](auto &&weak) {
+    auto locked = weak.lock();
+    return !locked or locked == subscription;
+  });
+  if (it->second.empty()) {
+    topics_.erase(it);
+  }
+}
+
+size_t EventHub::publish(std::string_view topic, std::string event) {
+  auto shared = std::make_shared<const std::string>(std::move(event));
+  std::vector<std::shared_ptr<Subscription>> receivers;
+  {
+    std::lock_guard lock(mutex_);
+    auto it = topics_.find(std::string(topic));
+    if (it == topics_.end()) {
+      return 0;
+    }
+    receivers.reserve(it->second.size());
+    for (auto &&weak : it->second) {
+      if (auto subscription = weak.lock(); subscription) {
+        receivers.push_back(std::move(subscription));
+      }
+    }
+  }
+  size_t delivered = 0;
+  for (auto &&subscription : receivers) {
+    if (subscription->channel.try_send(boost::system::error_code{}, shared)) {
+      ++delivered;
+      continue;
+    }
+    // Очередь переполнена: медленный клиент, отключаем
+    BOOST_LOG_TRIVIAL(warning)
+        << "[EventHub] Подписчик темы " << topic << " не успевает, отключаю";
+    subscription->channel.close();
+  }
+  return delivered;
+}
+} // namespace core
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace core {
+/**
+ * @brief Тема подписки по пути запроса на апгрейд
+ *
+ * Публикуют в темы с UUID в канонической строчной записи, а клиент мог
+ * написать его заглавными: такие сегменты пути приводятся к канонической
+ * записи, остальные остаются как есть.
+ */
+std::string topicOf(std::string_view path);
+
+/**
+ * @brief Брокер событий по темам (pub/sub) для push-уведомлений
+ *
+ * Событие сериализуется один раз и раздаётся подписчикам по общему
+ * указателю. У каждого подписчика ограниченная очередь: если клиент не
+ * успевает её вычитывать, он отключается, а не копит память сервера.
+ */
+struct EventHub {
+  using Event = std::shared_ptr<const std::string>;
+  using Channel = boost::asio::experimental::concurrent_channel<void(
+      boost::system::error_code, Event)>;
+
+  /**
+   * @brief Подписка одного соединения на одну тему
+   */
+  struct Subscription {
+    Subscription(boost::asio::any_io_executor executor, size_t capacity)
+        : channel(std::move(executor), capacity) {}
+    Channel channel;
+  };
+
+  /**
+   * @brief Подписывает соединение на тему
+   *
+   * @param capacity Сколько событий может ждать отправки клиенту
+   */
+  std::shared_ptr<Subscription>
+  subscribe(const std::string &topic, boost::asio::any_io_executor executor,
+            size_t capacity);
+
+  void unsubscribe(const std::string &topic,
+                   const std::shared_ptr<Subscription> &subscription);
+
+  /**
+   * @brief Рассылает событие всем подписчикам темы
+   *
+   * @return Сколько подписчиков получили событие
+   */
+  size_t publish(std::string_view topic, std::string event);
+
+private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::vector<std::weak_ptr<Subscription>>>
+      topics_;
+};
+} // namespace core
@@ -0,0 +1,112 @@
+#include "handoff.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) or defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define CORE_HAS_HANDOFF 1
+#endif
+
+namespace core {
+#ifdef CORE_HAS_HANDOFF
+std::optional<ListenerHandoff>
+ListenerHandoff::take(const std::filesystem::path &path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  auto &&native = path.native();
+  if (native.size() >= sizeof(address.sun_path)) {
+    throw std::system_error(ENAMETOOLONG, std::generic_category(),
+                            "handoff socket path");
+  }
+  std::memcpy(address.sun_path, native.c_str(), native.size() + 1);
+  int channel = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (channel < 0) {
+    throw std::system_error(errno, std::generic_category(), "socket");
+  }
+  if (::connect(channel, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) != 0) {
+    // Сокета нет или он остался от упавшего процесса: стартуем сами
+    ::close(channel);
+    return std::nullopt;
+  }
+  char byte = 0;
+  iovec data{.iov_base = &byte, .iov_len = 1};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+  msghdr message{};
+  message.msg_iov = &data;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  auto received = ::recvmsg(channel, &message, 0);
+  auto *header = CMSG_FIRSTHDR(&message);
+  if (received <= 0 or !header or header->cmsg_level != SOL_SOCKET or
+      header->cmsg_type != SCM_RIGHTS) {
+    ::close(channel);
+    throw std::runtime_error("handoff: no listener received");
+  }
+  int listener = -1;
+  std::memcpy(&listener, CMSG_DATA(header), sizeof(listener));
+  return ListenerHandoff(channel, listener);
+}
+
+void ListenerHandoff::give(int channel, int listener) {
+  char byte = 0;
+  iovec data{.iov_base = &byte, .iov_len = 1};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+  msghdr message{};
+  message.msg_iov = &data;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  auto *header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(header), &listener, sizeof(listener));
+  if (::sendmsg(channel, &message, 0) != 1) {
+    throw std::system_error(errno, std::generic_category(), "sendmsg");
+  }
+}
+
+void ListenerHandoff::waitForPredecessor() {
+  char buffer[64];
+  // Предыдущий процесс ничего не пишет: ждём EOF
+  for (;;) {
+    auto count = ::read(channel_, buffer, sizeof(buffer));
+    if (count == 0 or (count < 0 and errno != EINTR)) {
+      break;
+    }
+  }
+}
+
+ListenerHandoff::~ListenerHandoff() {
+  if (channel_ >= 0) {
+    ::close(channel_);
+  }
+}
+#else
+std::optional<ListenerHandoff>
+ListenerHandoff::take(const std::filesystem::path &) {
+  return std::nullopt;
+}
+
+void ListenerHandoff::give(int, int) {
+  throw std::system_error(std::make_error_code(std::errc::not_supported),
+                          "listener handoff");
+}
+
+void ListenerHandoff::waitForPredecessor() {}
+
+ListenerHandoff::~ListenerHandoff() = default;
+#endif
+
+ListenerHandoff::ListenerHandoff(ListenerHandoff &&other) noexcept
+    : channel_(std::exchange(other.channel_, -1)),
+      listener_(std::exchange(other.listener_, -1)) {}
+} // namespace core
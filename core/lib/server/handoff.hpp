@@ -0,0 +1,54 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+
+namespace core {
+/**
+ * @brief Передача слушающего сокета новому процессу при деплое
+ *
+ * Работающий сервер слушает Unix-сокет. Новый процесс подключается к
+ * нему и получает дескриптор слушающего TCP-сокета (SCM_RIGHTS), после
+ * чего старый перестаёт принимать соединения, дорабатывает начатые
+ * запросы, сбрасывает записи в базу и закрывает Unix-соединение.
+ *
+ * Новые соединения всё это время ждут в очереди ядра общего сокета и не
+ * теряются. Новый процесс начинает принимать их только после закрытия:
+ * активные игры живут в памяти одного процесса, и двум процессам нельзя
+ * вести их одновременно.
+ *
+ * Только POSIX; на других системах take() всегда пуст.
+ */
+struct ListenerHandoff {
+  /**
+   * @brief Забирает слушающий сокет у процесса, ожидающего на @p path
+   *
+   * @return std::nullopt, если никто не слушает @p path
+   */
+  static std::optional<ListenerHandoff> take(const std::filesystem::path &path);
+
+  ListenerHandoff(ListenerHandoff &&other) noexcept;
+  ListenerHandoff &operator=(ListenerHandoff &&) = delete;
+  ~ListenerHandoff();
+
+  /// Полученный слушающий сокет; владение переходит вызывающему
+  int listener() const { return listener_; }
+
+  /// Ждёт, пока предыдущий процесс завершит запросы и закроет соединение
+  void waitForPredecessor();
+
+  /**
+   * @brief Отдаёт @p listener процессу, подключившемуся по @p channel
+   *
+   * @throws std::system_error при ошибке sendmsg
+   */
+  static void give(int channel, int listener);
+
+private:
+  ListenerHandoff(int channel, int listener)
+      : channel_(channel), listener_(listener) {}
+
+  int channel_;
+  int listener_;
+};
+} // namespace core
@@ -0,0 +1,135 @@
+#include "json_writer.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+namespace core {
+void JsonWriter::separate() {
+  if (afterKey_) {
+    // Значение после ключа: запятая уже стоит перед ключом
+    afterKey_ = false;
+    return;
+  }
+  if (depth_ == 0) {
+    return;
+  }
+  uint64_t bit = uint64_t(1) << (depth_ - 1);
+  if (nonEmpty_ & bit) {
+    out_ += ',';
+  }
+  nonEmpty_ |= bit;
+}
+
+void JsonWriter::open(char bracket) {
+  separate();
+  out_ += bracket;
+  ++depth_;
+  nonEmpty_ &= ~(uint64_t(1) << (depth_ - 1));
+}
+
+void JsonWriter::close(char bracket) {
+  --depth_;
+  out_ += bracket;
+}
+
+JsonWriter &JsonWriter::beginObject() {
+  open('{');
+  return *this;
+}
+
+JsonWriter &JsonWriter::endObject() {
+  close('}');
+  return *this;
+}
+
+JsonWriter &JsonWriter::beginArray() {
+  open('[');
+  return *this;
+}
+
+JsonWriter &JsonWriter::endArray() {
+  close(']');
+  return *this;
+}
+
+JsonWriter &JsonWriter::key(std::string_view name) {
+  separate();
+  appendEscaped(name);
+  out_ += ':';
+  afterKey_ = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(std::string_view str) {
+  separate();
+  appendEscaped(str);
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(int64_t number) {
+  separate();
+  char buffer[24];
+  auto [end, _] = std::to_chars(std::begin(buffer), std::end(buffer), number);
+  out_.append(buffer, end);
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(bool flag) {
+  separate();
+  out_ += flag ? "true" : "false";
+  return *this;
+}
+
+JsonWriter &JsonWriter::null() {
+  separate();
+  out_ += "null";
+  return *this;
+}
+
+void JsonWriter::appendEscaped(std::string_view str) {
+  out_ += '"';
+  auto needsEscape = [](char c) {
+    return c == '"' or c == '\\' or static_cast<unsigned char>(c) < 0x20;
+  };
+  // Обычно экранировать нечего: копируем строку целиком
+  auto it = std::ranges::find_if(str, needsEscape);
+  out_.append(str.begin(), it);
+  for (; it != str.end(); ++it) {
+    char c = *it;
+    if (!needsEscape(c)) {
+      out_ += c;
+      continue;
+    }
+    switch (c) {
+    case '"':
+      out_ += "\\\"";
+      break;
+    case '\\':
+      out_ += "\\\\";
+      break;
+    case '\b':
+      out_ += "\\b";
+      break;
+    case '\f':
+      out_ += "\\f";
+      break;
+    case '\n':
+      out_ += "\\n";
+      break;
+    case '\r':
+      out_ += "\\r";
+      break;
+    case '\t':
+      out_ += "\\t";
+      break;
+    default: {
+      constexpr std::string_view digits = "0123456789abcdef";
+      out_ += "\\u00";
+      out_ += digits[static_cast<unsigned char>(c) >> 4];
+      out_ += digits[static_cast<unsigned char>(c) & 0x0f];
+    }
+    }
+  }
+  out_ += '"';
+}
+} // namespace core
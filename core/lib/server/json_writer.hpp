@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace core {
+/**
+ * @brief Потоковая запись JSON прямо в буфер тела ответа.
+ *
+ * В отличие от boost::json DOM не строит промежуточных объектов: каждое
+ * значение сразу дописывается в @c out. Подходит для плоских списков,
+ * где DOM означал бы по аллокации на каждый элемент.
+ *
+ * @code
+ * std::string body;
+ * JsonWriter writer(body);
+ * writer.beginObject().key("games").beginArray();
+ * writer.beginObject().key("url").value("/games/...").endObject();
+ * writer.endArray().endObject();
+ * @endcode
+ *
+ * @note Корректность вложенности не проверяется, глубина ограничена 64.
+ */
+struct JsonWriter {
+  explicit JsonWriter(std::string &out) : out_(out) {}
+
+  JsonWriter &beginObject();
+  JsonWriter &endObject();
+  JsonWriter &beginArray();
+  JsonWriter &endArray();
+
+  JsonWriter &key(std::string_view name);
+
+  JsonWriter &value(std::string_view str);
+  JsonWriter &value(const char *str) { return value(std::string_view(str)); }
+  JsonWriter &value(int64_t number);
+  JsonWriter &value(bool flag);
+  JsonWriter &null();
+
+private:
+  // Ставит запятую перед очередным элементом контейнера
+  void separate();
+  void open(char bracket);
+  void close(char bracket);
+  void appendEscaped(std::string_view str);
+
+  std::string &out_;
+  // Бит на каждый уровень вложенности: был ли на нём уже элемент
+  uint64_t nonEmpty_ = 0;
+  uint32_t depth_ = 0;
+  bool afterKey_ = false;
+};
+} // namespace core
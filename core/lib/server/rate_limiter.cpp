@@ -0,0 +1,137 @@
+#include "rate_limiter.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace core {
+namespace {
+constexpr uint64_t kMilli = 1000;
+
+uint64_t pack(uint32_t millis, uint32_t tokens) {
+  return uint64_t(millis) << 32 | tokens;
+}
+
+double toNumber(std::string_view text, std::string_view rule) {
+  double value = 0;
+  auto [end, ec] = std::from_chars(text.begin(), text.end(), value);
+  if (ec != std::errc{} or end != text.end() or !(value > 0)) {
+    throw std::invalid_argument("bad rate limit: " + std::string(rule));
+  }
+  return value;
+}
+} // namespace
+
+RateLimitRule parseRateLimitRule(std::string_view text) {
+  auto space = text.find(' ');
+  auto equals = text.rfind('=');
+  if (space == text.npos or equals == text.npos or equals < space) {
+    throw std::invalid_argument("bad rate limit: " + std::string(text));
+  }
+  RateLimitRule rule{.method = std::string(text.substr(0, space)),
+                     .route = std::string(
+                         text.substr(space + 1, equals - space - 1))};
+  auto numbers = text.substr(equals + 1);
+  auto colon = numbers.find(':');
+  rule.limit.rate = toNumber(numbers.substr(0, colon), text);
+  // Без явного всплеска — запас на секунду
+  rule.limit.burst = colon == numbers.npos
+                         ? std::max(rule.limit.rate, 1.0)
+                         : toNumber(numbers.substr(colon + 1), text);
+  return rule;
+}
+
+RateLimiter::RateLimiter(size_t capacity, size_t shards)
+    : epoch_(std::chrono::steady_clock::now()) {
+  shards = std::bit_ceil(std::max<size_t>(shards, 1));
+  auto perShard =
+      std::bit_ceil(std::max<size_t>(capacity / shards, kProbe));
+  shards_.resize(shards);
+  for (auto &shard : shards_) {
+    shard.slots = std::make_unique<Slot[]>(perShard);
+    shard.mask = perShard - 1;
+  }
+}
+
+RateLimiter::Decision RateLimiter::take(uint64_t key, RateLimit limit) {
+  return take(key, limit, std::chrono::steady_clock::now());
+}
+
+RateLimiter::Decision
+RateLimiter::take(uint64_t key, RateLimit limit,
+                  std::chrono::steady_clock::time_point now) {
+  key = key ? key : 1;
+  // Время по модулю 2^32 мс (~49 дней): разность беззнаковая
+  auto millis = uint32_t(
+      std::chrono::duration_cast<std::chrono::milliseconds>(now - epoch_)
+          .count());
+  auto full = uint32_t(std::min<double>(
+      limit.burst * kMilli, std::numeric_limits<uint32_t>::max()));
+  // Миллитокенов в миллисекунду — ровно rate токенов в секунду
+  double perMilli = limit.rate;
+  // Младшие биты выбирают слот, старшие — шард
+  auto &shard = shards_[(key >> 48) & (shards_.size() - 1)];
+  auto &slot = locate(shard, key, millis, full);
+  slot.referenced.store(true, std::memory_order_relaxed);
+  auto state = slot.state.load(std::memory_order_relaxed);
+  for (;;) {
+    auto last = uint32_t(state >> 32);
+    uint64_t tokens = uint32_t(state);
+    auto refill = uint64_t(double(uint32_t(millis - last)) * perMilli);
+    // Без пополнения время не сдвигаем, иначе малый rate не накопится
+    if (refill != 0) {
+      tokens = std::min<uint64_t>(tokens + refill, full);
+      last = millis;
+    }
+    if (tokens < kMilli) {
+      auto wait = std::ceil(double(kMilli - tokens) / perMilli);
+      return {.allowed = false,
+              .retryAfter = std::chrono::milliseconds(int64_t(wait))};
+    }
+    if (slot.state.compare_exchange_weak(state,
+                                         pack(last, uint32_t(tokens - kMilli)),
+                                         std::memory_order_relaxed)) {
+      return {.allowed = true};
+    }
+  }
+}
+
+RateLimiter::Slot &RateLimiter::locate(Shard &shard, uint64_t key,
+                                       uint32_t now, uint32_t full) {
+  auto start = key & shard.mask;
+  Slot *empty = nullptr;
+  for (size_t i = 0; i < kProbe; ++i) {
+    auto &slot = shard.slots[(start + i) & shard.mask];
+    auto current = slot.key.load(std::memory_order_acquire);
+    if (current == key) {
+      return slot;
+    }
+    if (current == 0 and !empty) {
+      empty = &slot;
+    }
+  }
+  // CLOCK: снимаем бит обращения, пока не найдём слот без него
+  Slot *victim = empty;
+  for (size_t i = 0; !victim and i <= kProbe; ++i) {
+    auto &slot = shard.slots[(start + i % kProbe) & shard.mask];
+    if (!slot.referenced.exchange(false, std::memory_order_relaxed)) {
+      victim = &slot;
+    }
+  }
+  if (!victim) {
+    // Биты успели выставить заново: вытесняем первый слот окна
+    victim = &shard.slots[start];
+  }
+  auto expected = victim->key.load(std::memory_order_relaxed);
+  if (victim->key.compare_exchange_strong(expected, key,
+                                          std::memory_order_acq_rel)) {
+    // Новый клиент начинает с полной корзиной
+    victim->state.store(pack(now, full), std::memory_order_release);
+  }
+  // Проиграли гонку за слот — делим его с победителем до вытеснения
+  return *victim;
+}
+} // namespace core
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core {
+/**
+ * @brief Предел частоты запросов: rate в секунду, всплеск до burst
+ */
+struct RateLimit {
+  double rate = 10;
+  double burst = 20;
+};
+
+/**
+ * @brief Правило "METHOD /route=rate[:burst]", например "POST /games=5:20"
+ */
+struct RateLimitRule {
+  std::string method;
+  std::string route;
+  RateLimit limit;
+};
+
+/// Разбирает правило; std::invalid_argument при ошибке формата
+RateLimitRule parseRateLimitRule(std::string_view text);
+
+/**
+ * @brief Таблица token bucket по клиентам без блокировок
+ *
+ * Ключ — 64-битный хеш клиента и маршрута. Таблица разбита на шарды с
+ * открытой адресацией: ключ ищется в окне из kProbe соседних слотов, так
+ * что запрос стоит O(1). Состояние корзины (время пополнения и токены)
+ * упаковано в одно 64-битное слово и меняется через CAS, а пополнение
+ * ленивое: токены за прошедшее время начисляются при следующем запросе.
+ *
+ * Если в окне нет ни ключа, ни свободного слота, вытесняется давно не
+ * использованный клиент: алгоритм CLOCK по битам обращения внутри окна
+ * (приближение LRU без общего списка и блокировок).
+ *
+ * @note Гонки здесь допустимы: при одновременном захвате слота клиент
+ * может получить лишний токен. Это ограничитель нагрузки, а не учёт.
+ */
+struct RateLimiter {
+  /**
+   * @brief Результат попытки взять токен
+   */
+  struct Decision {
+    bool allowed;
+    // Через сколько появится следующий токен, если отказано
+    std::chrono::milliseconds retryAfter{0};
+  };
+
+  explicit RateLimiter(size_t capacity = kDefaultCapacity,
+                       size_t shards = kDefaultShards);
+
+  RateLimiter(const RateLimiter &) = delete;
+  RateLimiter &operator=(const RateLimiter &) = delete;
+
+  /// Берёт токен из корзины ключа @p key
+  Decision take(uint64_t key, RateLimit limit);
+
+  /// То же в заданный момент (для тестов)
+  Decision take(uint64_t key, RateLimit limit,
+                std::chrono::steady_clock::time_point now);
+
+  static constexpr size_t kDefaultCapacity = 16 * 1024;
+  static constexpr size_t kDefaultShards = 16;
+  static constexpr size_t kProbe = 8;
+
+private:
+  struct alignas(64) Slot {
+    // 0 — свободный слот
+    std::atomic<uint64_t> key{0};
+    // Старшие 32 бита — миллисекунда пополнения, младшие — миллитокены
+    std::atomic<uint64_t> state{0};
+    std::atomic<bool> referenced{false};
+  };
+
+  struct Shard {
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+  };
+
+  Slot &locate(Shard &shard, uint64_t key, uint32_t now, uint32_t full);
+
+  const std::chrono::steady_clock::time_point epoch_;
+  std::vector<Shard> shards_;
+};
+} // namespace core
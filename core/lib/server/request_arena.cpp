@@ -0,0 +1,51 @@
+#include "request_arena.hpp"
+
+namespace core {
+RequestArena::RequestArena(size_t initialBytes)
+    : initialBytes_(initialBytes) {}
+
+void RequestArena::release() {
+  if (monotonic_) {
+    monotonic_->release();
+  }
+}
+
+void RequestArena::trim() {
+  monotonic_.reset();
+  buffer_.reset();
+}
+
+boost::json::storage_ptr RequestArena::jsonStorage() noexcept {
+  return boost::json::storage_ptr(&json_);
+}
+
+void *RequestArena::do_allocate(size_t bytes, size_t alignment) {
+  if (!monotonic_) {
+    buffer_ = std::make_unique_for_overwrite<std::byte[]>(initialBytes_);
+    monotonic_.emplace(buffer_.get(), initialBytes_,
+                       std::pmr::new_delete_resource());
+  }
+  return monotonic_->allocate(bytes, alignment);
+}
+
+bool RequestArena::do_is_equal(
+    const std::pmr::memory_resource &other) const noexcept {
+  return this == &other;
+}
+
+void *RequestArena::JsonResource::do_allocate(size_t bytes, size_t alignment) {
+  return arena_.allocate(bytes, alignment);
+}
+
+bool RequestArena::JsonResource::do_is_equal(
+    const boost::json::memory_resource &other) const noexcept {
+  return this == &other;
+}
+
+boost::json::storage_ptr jsonStorage(std::pmr::memory_resource *resource) {
+  if (auto *arena = dynamic_cast<RequestArena *>(resource); arena) {
+    return arena->jsonStorage();
+  }
+  return {};
+}
+} // namespace core
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <boost/json/memory_resource.hpp>
+#include <boost/json/storage_ptr.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace core {
+/**
+ * @brief Арена памяти для запросов одного соединения
+ *
+ * Заголовки и тело запроса, совпадения маршрута и разобранный JSON
+ * выделяются из монотонного ресурса: выделение — сдвиг указателя, а
+ * освобождение по одному ничего не делает. После ответа release() отдаёт
+ * всё разом, и следующий запрос соединения снова пишет в тот же начальный
+ * буфер. Запрос, не уместившийся в буфер, берёт дополнительные блоки из
+ * кучи, и они живут только до release().
+ *
+ * Начальный буфер выделяется при первом выделении, а trim() отдаёт его
+ * обратно: соединение без запроса в работе или с запросом, перенесённым в
+ * кучу на время долгого ожидания, не держит kInitialBytes.
+ *
+ * Не потокобезопасна: арена принадлежит одной сессии, а запрос сессии
+ * обрабатывается в каждый момент только одним потоком.
+ */
+struct RequestArena final : std::pmr::memory_resource {
+  static constexpr size_t kInitialBytes = size_t(16) << 10;
+
+  explicit RequestArena(size_t initialBytes = kInitialBytes);
+
+  RequestArena(const RequestArena &) = delete;
+  RequestArena &operator=(const RequestArena &) = delete;
+
+  /**
+   * @brief Освобождает всё выделенное с прошлого вызова
+   *
+   * @warning Объекты, выделенные из арены, к этому моменту должны быть
+   * разрушены
+   */
+  void release();
+
+  /**
+   * @brief Как release(), но отдаёт и начальный буфер
+   *
+   * Следующее выделение снова возьмёт буфер из кучи.
+   */
+  void trim();
+
+  std::pmr::polymorphic_allocator<char> allocator() noexcept { return this; }
+
+  /// Та же арена для boost::json, у которого свой интерфейс ресурса
+  boost::json::storage_ptr jsonStorage() noexcept;
+
+  struct JsonResource final : boost::json::memory_resource {
+    explicit JsonResource(RequestArena &arena) : arena_(arena) {}
+
+  private:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(
+        const boost::json::memory_resource &other) const noexcept override;
+
+    RequestArena &arena_;
+  };
+
+private:
+  void *do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void *, size_t, size_t) override {}
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override;
+
+  const size_t initialBytes_;
+  std::unique_ptr<std::byte[]> buffer_;
+  // Создаётся вместе с буфером при первом выделении
+  std::optional<std::pmr::monotonic_buffer_resource> monotonic_;
+  JsonResource json_{*this};
+};
+
+/**
+ * @brief Хранилище JSON для запроса, выделенного из @p resource
+ *
+ * Если @p resource — арена, JSON разбирается в неё же, иначе в кучу.
+ * Например: jsonStorage(req.get_allocator().resource()).
+ */
+boost::json::storage_ptr jsonStorage(std::pmr::memory_resource *resource);
+} // namespace core
+
+// Освобождение в арене ничего не делает: boost::json может не обходить
+// дерево значений при разрушении
+template <>
+struct boost::json::is_deallocate_trivial<core::RequestArena::JsonResource>
+    : std::true_type {};
@@ -1,13 +1,31 @@
 #include "server.hpp"
+#include "context_executor.hpp"
+#include "etag.hpp"
+#include "handoff.hpp"
 
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <boost/container_hash/hash.hpp>
+#include <boost/beast/websocket.hpp>
 #include <boost/url/grammar/parse.hpp>
 #include <boost/url/rfc/uri_rule.hpp>
 
 #include <boost/log/trivial.hpp>
 
+#include <boost/url/parse.hpp>
+
+#include <algorithm>
+#include <cerrno>
 #include <exception>
+#include <functional>
 #include <iostream>
 #include <unordered_map>
+#include <utility>
+
+#if defined(__unix__) or defined(__APPLE__)
+#include <sys/socket.h>
+#endif
+
+namespace urls = boost::urls;
 
 namespace core {
 void CoreServer::get(std::string_view route, Handler handler) {
@@ -26,19 +44,118 @@ void CoreServer::del(std::string_view route, Handler handler) {
   routerDelete_.insert(route, handler);
 }
 
+void CoreServer::getAsync(std::string_view route, AsyncHandler handler) {
+  routerGetAsync_.insert(route, std::move(handler));
+}
+
+void CoreServer::postAsync(std::string_view route, AsyncHandler handler) {
+  routerPostAsync_.insert(route, std::move(handler));
+}
+
+void CoreServer::delAsync(std::string_view route, AsyncHandler handler) {
+  routerDeleteAsync_.insert(route, std::move(handler));
+}
+
+void CoreServer::stream(std::string_view route) {
+  routerStream_.insert(route, true);
+}
+
+void CoreServer::longPoll(std::string_view route, std::string_view param) {
+  routerLongPoll_.insert(route, std::string(param));
+}
+
+size_t CoreServer::publish(std::string_view topic, std::string event) {
+  return events_.publish(topic, std::move(event));
+}
+
+size_t CoreServer::clientOf(const Request &req) const {
+  // Адрес соединения клиента не отличает: за прокси или NAT он общий
+  if (rateLimitHeader_.empty()) {
+    return 0;
+  }
+  auto key = req[rateLimitHeader_];
+  if (key.empty()) {
+    return 0;
+  }
+  // 0 зарезервирован за неизвестным клиентом
+  return std::max<size_t>(
+      std::hash<std::string_view>{}(std::string_view(key.data(), key.size())),
+      1);
+}
+
+namespace {
+// Клиент закрыл или сбросил соединение, пока обработчик занят
+bool peerGone(int socket) {
+#if defined(__unix__) or defined(__APPLE__)
+  char byte;
+  auto count = ::recv(socket, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+  return count == 0 or
+         (count < 0 and errno != EAGAIN and errno != EWOULDBLOCK and
+          errno != EINTR);
+#else
+  return false;
+#endif
+}
+} // namespace
+
+std::string_view CoreServer::backend() {
+#if defined(BOOST_ASIO_HAS_IO_URING_AS_DEFAULT)
+  // Сокеты, а не только файлы, идут через кольца io_uring
+  return "io_uring";
+#else
+  return "reactor";
+#endif
+}
+
+void CoreServer::inherit(int listener) { inherited_ = listener; }
+
+void CoreServer::handoffAt(std::filesystem::path path) {
+  handoffPath_ = std::move(path);
+}
+
+void CoreServer::drainTimeout(std::chrono::seconds timeout) {
+  drainTimeout_ = timeout;
+}
+
+void CoreServer::idleTimeout(std::chrono::milliseconds timeout) {
+  idleTimeout_ = timeout;
+}
+
+void CoreServer::onShutdown(std::function<void()> hook) {
+  shutdownHooks_.push_back(std::move(hook));
+}
+
 asio::awaitable<void> CoreServer::listenTo(tcp::endpoint endpoint) {
   try {
     auto &&executor = co_await asio::this_coro::executor;
-    auto acceptor = asio::use_awaitable.as_default_on(tcp::acceptor(executor));
-    BOOST_LOG_TRIVIAL(info) << "[Сервер] Слушаю клиентов по адресу http://"
-                            << endpoint << std::endl;
-    acceptor.open(endpoint.protocol());
-    acceptor.set_option(asio::socket_base::reuse_address(true));
-    acceptor.bind(endpoint);
-    acceptor.listen(asio::socket_base::max_listen_connections);
+    if (inherited_ >= 0) {
+      // Соединения, пришедшие во время передачи, ждут в backlog этого сокета
+      acceptor_.assign(endpoint.protocol(), inherited_);
+      BOOST_LOG_TRIVIAL(info)
+          << "[Сервер] Принимаю клиентов на сокете предыдущего процесса "
+          << acceptor_.local_endpoint() << std::endl;
+    } else {
+      BOOST_LOG_TRIVIAL(info) << "[Сервер] Слушаю клиентов по адресу http://"
+                              << endpoint << std::endl;
+      acceptor_.open(endpoint.protocol());
+      acceptor_.set_option(asio::socket_base::reuse_address(true));
+      acceptor_.bind(endpoint);
+      acceptor_.listen(asio::socket_base::max_listen_connections);
+    }
     for (;;) {
-      asio::co_spawn(executor, session(co_await acceptor.async_accept()),
-                     asio::detached);
+      // На пределе соединений новые ждут в backlog ядра, а не в памяти
+      co_await admission_.enterSession();
+      auto [ec, socket] =
+          co_await acceptor_.async_accept(asio::as_tuple(asio::use_awaitable));
+      if (ec) {
+        admission_.leaveSession();
+        if (draining_) {
+          // drain() закрыл acceptor
+          co_return;
+        }
+        throw boost::system::system_error(ec);
+      }
+      asio::co_spawn(executor, session(std::move(socket)), asio::detached);
     }
   } catch (std::exception &e) {
     BOOST_LOG_TRIVIAL(error)
@@ -52,13 +169,80 @@ asio::awaitable<void> CoreServer::session(tcp::socket socket) {
   try {
     // Буфер будет хранить данные между итерациями
     beast::flat_buffer buffer;
-    auto stream =
-        asio::use_awaitable.as_default_on(beast::tcp_stream(std::move(socket)));
+    // Память запросов соединения: одна арена на все его запросы
+    RequestArena arena;
+    beast::error_code endpointError;
+    auto client = socket.remote_endpoint(endpointError).address().to_string();
+    Stream stream(std::move(socket));
     for (;;) {
-      stream.expires_after(std::chrono::seconds(30));
-      http::request<http::string_body> req;
-      co_await http::async_read(stream, buffer, req);
-      auto res = handle_request(req);
+      // Объекты прошлого запроса уже разрушены
+      arena.release();
+      if (draining_) {
+        break;
+      }
+      stream.expires_after(idleTimeout_);
+      std::optional<Request> incoming(std::in_place, std::piecewise_construct,
+                                      std::make_tuple(arena.allocator()),
+                                      std::make_tuple(arena.allocator()));
+      beast::error_code readError;
+      idle_.insert(&stream);
+      co_await http::async_read(
+          stream, buffer, *incoming,
+          asio::redirect_error(asio::use_awaitable, readError));
+      idle_.erase(&stream);
+      if (readError == asio::error::operation_aborted and draining_) {
+        break;
+      }
+      if (readError) {
+        throw boost::system::system_error(readError);
+      }
+      // Long-poll ждёт дольше простоя: таймер вернётся перед записью ответа
+      stream.expires_never();
+      // WebSocket и long-poll живут долго: их запрос копируется в кучу, а
+      // арена отдаёт буфер, чтобы припаркованные соединения его не держали
+      Request parked;
+      bool upgrade = beast::websocket::is_upgrade(*incoming);
+      if (upgrade or !metered(*incoming)) {
+        parked = *incoming;
+        incoming.reset();
+        arena.trim();
+      }
+      const Request &req = incoming ? *incoming : parked;
+      if (auto target = urls::parse_origin_form(req.target());
+          target and upgrade) {
+        router::MatchesStorage matches(req.get_allocator());
+        if (routerStream_.find(target->encoded_segments(), matches)) {
+          auto topic = topicOf(target->encoded_path());
+          co_await websocketSession(stream.release_socket(),
+                                    std::move(parked), std::move(topic));
+          break;
+        }
+      }
+      Response res;
+      database::QueryContext context{
+          .deadline = database::QueryContext::Clock::now() + deadlineOf(req),
+          .abandoned = [socket = stream.socket().native_handle()] {
+            return peerGone(socket);
+          },
+          .client = clientOf(req)};
+      // Пробы оркестратора не расходуют пределы и проходят при перегрузке.
+      // Затем предел клиента: злоупотребляющий не занимает слот сервера
+      if (auto answer = probe(req); answer) {
+        res = std::move(*answer);
+      } else if (auto retryAfter = limited(req, client); retryAfter) {
+        res = tooManyRequests(req, *retryAfter);
+      } else if (!metered(req)) {
+        res = co_await dispatch(req, context);
+      } else if (auto permit = co_await admission_.admit(); permit) {
+        res = co_await dispatch(req, context);
+      } else {
+        res = overloaded(req);
+      }
+      if (draining_) {
+        // Клиент переподключится к преемнику
+        res.keep_alive(false);
+      }
+      stream.expires_after(idleTimeout_);
       co_await http::async_write(stream, res, asio::use_awaitable);
       if (res.need_eof()) {
         // Корректно закрываем соединение
@@ -72,17 +256,118 @@ asio::awaitable<void> CoreServer::session(tcp::socket socket) {
   } catch (std::exception &e) {
     BOOST_LOG_TRIVIAL(error) << "[Сессия] Ошибка: " << e.what() << std::endl;
   }
+  admission_.leaveSession();
+}
+
+asio::awaitable<void>
+CoreServer::websocketSession(tcp::socket socket,
+                             Request req,
+                             std::string topic) {
+  namespace websocket = beast::websocket;
+  using namespace asio::experimental::awaitable_operators;
+  BOOST_LOG_TRIVIAL(info) << "[WebSocket] Подписка на " << topic << std::endl;
+  auto executor = co_await asio::this_coro::executor;
+  std::shared_ptr<EventHub::Subscription> subscription;
+  try {
+    websocket::stream<beast::tcp_stream> ws(std::move(socket));
+    // Пинги и таймауты простоя берёт на себя Beast
+    ws.set_option(
+        websocket::stream_base::timeout::suggested(beast::role_type::server));
+    ws.set_option(websocket::stream_base::decorator(
+        [](websocket::response_type &res) {
+          res.set(http::field::server, "Core");
+        }));
+    co_await ws.async_accept(req, asio::use_awaitable);
+    subscription = events_.subscribe(topic, executor, kMaxQueuedEvents);
+
+    // Клиенту писать нечего, читаем только чтобы заметить закрытие
+    auto readLoop = [&ws]() -> asio::awaitable<void> {
+      beast::flat_buffer incoming;
+      for (;;) {
+        co_await ws.async_read(incoming, asio::use_awaitable);
+        incoming.consume(incoming.size());
+      }
+    };
+    auto writeLoop = [&ws, &subscription]() -> asio::awaitable<void> {
+      for (;;) {
+        auto [ec, event] = co_await subscription->channel.async_receive(
+            asio::as_tuple(asio::use_awaitable));
+        if (ec) {
+          // Канал закрыт: клиент не успевал за событиями
+          co_await ws.async_close({websocket::close_code::try_again_later,
+                                   "slow consumer"},
+                                  asio::use_awaitable);
+          co_return;
+        }
+        ws.text(true);
+        co_await ws.async_write(asio::buffer(*event), asio::use_awaitable);
+      }
+    };
+    // Первая завершившаяся сторона отменяет вторую
+    co_await (readLoop() || writeLoop());
+  } catch (const std::exception &e) {
+    BOOST_LOG_TRIVIAL(info) << "[WebSocket] Соединение закрыто: " << e.what()
+                            << std::endl;
+  }
+  if (subscription) {
+    events_.unsubscribe(topic, subscription);
+  }
 }
 
 void CoreServer::run(tcp::endpoint endpoint) {
-  BOOST_LOG_TRIVIAL(info) << "[Сервер] Запуск сервера..." << std::endl;
+  BOOST_LOG_TRIVIAL(info) << "[Сервер] Запуск сервера (" << backend()
+                          << ")..." << std::endl;
   asio::signal_set signals(ioc_, SIGINT, SIGTERM);
-  signals.async_wait([this](auto, auto) {
+  signals.async_wait([this, &signals](auto error, auto) {
+    if (error) {
+      return;
+    }
     BOOST_LOG_TRIVIAL(info)
-        << "[Сервер] Получен сигнал завершения. Остановка..." << std::endl;
-    ioc_.stop();
-    // Можно добавить дополнительную логику очистки
+        << "[Сервер] Получен сигнал завершения. Дорабатываю начатые запросы..."
+        << std::endl;
+    // Повторный сигнал — остановка без ожидания
+    signals.async_wait([this](auto error, auto) {
+      if (!error) {
+        ioc_.stop();
+      }
+    });
+    asio::co_spawn(ioc_, drain(), [this](std::exception_ptr) { ioc_.stop(); });
   });
+#ifdef SIGHUP
+  asio::signal_set reload(ioc_, SIGHUP);
+  std::function<void()> waitReload = [this, &reload, &waitReload] {
+    reload.async_wait([this, &waitReload](auto error, auto) {
+      if (error) {
+        return;
+      }
+      BOOST_LOG_TRIVIAL(info) << "[Сервер] Перечитываю конфигурацию..."
+                              << std::endl;
+      for (auto &&hook : reloadHooks_) {
+        try {
+          hook();
+        } catch (const std::exception &e) {
+          BOOST_LOG_TRIVIAL(error)
+              << "[Сервер] Конфигурация не применена: " << e.what()
+              << std::endl;
+        }
+      }
+      waitReload();
+    });
+  };
+  waitReload();
+#endif
+  if (!handoffPath_.empty()) {
+    asio::co_spawn(ioc_, handoff(), [](std::exception_ptr ep) {
+      if (!ep)
+        return;
+      try {
+        std::rethrow_exception(ep);
+      } catch (const std::exception &e) {
+        BOOST_LOG_TRIVIAL(error)
+            << "[Сервер] Ошибка передачи сокета: " << e.what() << std::endl;
+      }
+    });
+  }
 
   asio::co_spawn(ioc_, listenTo(endpoint), [](std::exception_ptr ep) {
     if (!ep)
@@ -102,8 +387,105 @@ void CoreServer::run(tcp::endpoint endpoint) {
   BOOST_LOG_TRIVIAL(info) << "[Сервер] Сервер завершил работу." << std::endl;
 }
 
-http::response<http::string_body>
-CoreServer::handle_request(const http::request<http::string_body> &req) {
+asio::awaitable<void> CoreServer::drain() {
+  if (std::exchange(draining_, true)) {
+    co_return;
+  }
+  beast::error_code ec;
+  acceptor_.close(ec);
+  for (auto *stream : idle_) {
+    stream->cancel();
+  }
+  // Сессии заканчиваются сами: после ответа на начатый запрос
+  asio::steady_timer timer(co_await asio::this_coro::executor);
+  auto deadline = std::chrono::steady_clock::now() + drainTimeout_;
+  while (admission_.sessions() > 0 and
+         std::chrono::steady_clock::now() < deadline) {
+    timer.expires_after(kDrainPollInterval);
+    co_await timer.async_wait(asio::use_awaitable);
+  }
+  if (auto left = admission_.sessions(); left > 0) {
+    BOOST_LOG_TRIVIAL(warning) << "[Сервер] Не дождался соединений: " << left
+                               << std::endl;
+  }
+  for (auto &&hook : shutdownHooks_) {
+    hook();
+  }
+  BOOST_LOG_TRIVIAL(info) << "[Сервер] Соединения закрыты." << std::endl;
+}
+
+asio::awaitable<void> CoreServer::handoff() {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+  using local = asio::local::stream_protocol;
+  auto &&executor = co_await asio::this_coro::executor;
+  // Файл мог остаться от завершившегося процесса
+  std::error_code ec;
+  std::filesystem::remove(handoffPath_, ec);
+  local::acceptor acceptor(executor, local::endpoint(handoffPath_.string()));
+  BOOST_LOG_TRIVIAL(info) << "[Сервер] Жду преемника на " << handoffPath_
+                          << std::endl;
+  auto channel = co_await acceptor.async_accept(asio::use_awaitable);
+  acceptor.close();
+  ListenerHandoff::give(channel.native_handle(), acceptor_.native_handle());
+  BOOST_LOG_TRIVIAL(info)
+      << "[Сервер] Слушающий сокет передан новому процессу. Остановка..."
+      << std::endl;
+  co_await drain();
+  // Канал закроет ядро при выходе процесса, когда журнал игр уже закрыт:
+  // только тогда преемник начнёт восстановление и приём соединений
+  channel.release();
+  ioc_.stop();
+#else
+  BOOST_LOG_TRIVIAL(warning)
+      << "[Сервер] Передача сокета не поддерживается" << std::endl;
+  co_return;
+#endif
+}
+
+asio::awaitable<CoreServer::Response>
+CoreServer::dispatch(const Request &req,
+                     const database::QueryContext &context) {
+  auto target = urls::parse_origin_form(req.target());
+  router::MatchesStorage matches(req.get_allocator());
+  router::Router<AsyncHandler> *router = nullptr;
+  if (req.method() == http::verb::get) {
+    router = &routerGetAsync_;
+  } else if (req.method() == http::verb::post) {
+    router = &routerPostAsync_;
+  } else if (req.method() == http::verb::delete_) {
+    router = &routerDeleteAsync_;
+  }
+  if (target and router) {
+    if (auto handler = router->find(target->encoded_segments(), matches);
+        handler) {
+      std::optional<Response> maybeResp;
+      std::exception_ptr error;
+      try {
+        // Контекст действует после каждого co_await обработчика
+        maybeResp = co_await asio::co_spawn(
+            ContextExecutor(co_await asio::this_coro::executor, &context),
+            (*handler)(req, matches), asio::use_awaitable);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      if (error) {
+        co_return failed(req, error);
+      }
+      if (maybeResp) {
+        maybeResp->set(http::field::server, "Core");
+        maybeResp->keep_alive(req.keep_alive());
+        encode(req, *maybeResp);
+        maybeResp->prepare_payload();
+        co_return std::move(*maybeResp);
+      }
+    }
+  }
+  co_return handle_request(req, context);
+}
+
+CoreServer::Response
+CoreServer::handle_request(const Request &req,
+                           const database::QueryContext &context) {
   BOOST_LOG_TRIVIAL(info) << "[handle_request] Обработка запроса: "
                           << req.method_string() << " " << req.target()
                           << std::endl;
@@ -111,7 +493,7 @@ CoreServer::handle_request(const http::request<http::string_body> &req) {
   res.set(http::field::server, "Core");
   res.set(http::field::content_type, "application/json");
   res.keep_alive(req.keep_alive());
-  router::MatchesStorage matches;
+  router::MatchesStorage matches(req.get_allocator());
   auto method = req.method();
   router::Router<Handler> *router = nullptr;
   switch (method) {
@@ -131,15 +513,24 @@ CoreServer::handle_request(const http::request<http::string_body> &req) {
     router = nullptr;
   }
   decltype(router->find({}, matches)) handler = nullptr;
-  if (router) {
-    handler = router->find(req.target(), matches);
+  // Строка запроса (?wait=...) не участвует в выборе маршрута
+  if (auto target = urls::parse_origin_form(req.target()); router and target) {
+    handler = router->find(target->encoded_segments(), matches);
   }
   if (handler) {
-    auto maybeResp = (*handler)(req, matches);
+    std::optional<Response> maybeResp;
+    try {
+      database::QueryContext::Scope scope(context);
+      maybeResp = (*handler)(req, matches);
+    } catch (...) {
+      return failed(req, std::current_exception());
+    }
     if (maybeResp) {
       BOOST_LOG_TRIVIAL(info)
           << "[handle_request] Запрос обработан маршрутизатором." << std::endl;
-      return *maybeResp;
+      encode(req, *maybeResp);
+      maybeResp->prepare_payload();
+      return std::move(*maybeResp);
     }
   }
   BOOST_LOG_TRIVIAL(info)
@@ -147,7 +538,260 @@ CoreServer::handle_request(const http::request<http::string_body> &req) {
   res.result(http::status::not_found);
   res.set(http::field::content_type, "application/json");
   res.body() = "{}";
+  res.prepare_payload();
   return res;
 }
 
+void CoreServer::compression(CompressionOptions options) {
+  compressionOptions_ = options;
+  compressionCache_.setCapacity(options.cacheBytes);
+}
+
+void CoreServer::admission(AdmissionOptions options) {
+  admission_.configure(options);
+}
+
+namespace {
+// Id корзин маршрута не зависит от порядка правил и переживает configure()
+size_t routeLimitId(http::verb method, std::string_view route) {
+  size_t id = 0;
+  boost::hash_combine(id, method);
+  boost::hash_combine(id, route);
+  return id;
+}
+} // namespace
+
+void CoreServer::rateLimit(http::verb method, std::string_view route,
+                           RateLimit limit) {
+  routerRateLimit_[method].insert(
+      route, RouteLimit{.limit = limit, .id = routeLimitId(method, route)});
+}
+
+void CoreServer::rateLimitBy(std::string header) {
+  rateLimitHeader_ = std::move(header);
+}
+
+void CoreServer::deadline(http::verb method, std::string_view route,
+                          std::chrono::milliseconds timeout) {
+  routerDeadline_[method].insert(route, timeout);
+}
+
+void CoreServer::defaultDeadline(std::chrono::milliseconds timeout) {
+  defaultDeadline_ = timeout;
+}
+
+void CoreServer::configure(const ServerSettings &settings) {
+  // Сначала всё, что может бросить: при ошибке старые настройки остаются
+  decltype(routerRateLimit_) rateLimits;
+  for (auto &&rule : settings.rateLimits) {
+    rateLimits[rule.method].insert(
+        rule.route, RouteLimit{.limit = rule.limit,
+                               .id = routeLimitId(rule.method, rule.route)});
+  }
+  decltype(routerDeadline_) deadlines;
+  for (auto &&rule : settings.deadlines) {
+    deadlines[rule.method].insert(rule.route, rule.timeout);
+  }
+  std::string header = settings.rateLimitHeader;
+
+  routerRateLimit_ = std::move(rateLimits);
+  routerDeadline_ = std::move(deadlines);
+  rateLimitHeader_ = std::move(header);
+  defaultDeadline_ = settings.defaultDeadline;
+  drainTimeout_ = settings.drainTimeout;
+  compression(settings.compression);
+  // Иначе каждая перезагрузка сбрасывала бы выученный лимит
+  if (settings.admission != admission_.options()) {
+    admission(settings.admission);
+  }
+}
+
+void CoreServer::onReload(std::function<void()> hook) {
+  reloadHooks_.push_back(std::move(hook));
+}
+
+std::chrono::milliseconds CoreServer::deadlineOf(const Request &req) const {
+  auto router = routerDeadline_.find(req.method());
+  if (router == routerDeadline_.end()) {
+    return defaultDeadline_;
+  }
+  auto target = urls::parse_origin_form(req.target());
+  if (!target) {
+    return defaultDeadline_;
+  }
+  router::MatchesStorage matches(req.get_allocator());
+  auto timeout = router->second.find(target->encoded_segments(), matches);
+  return timeout ? *timeout : defaultDeadline_;
+}
+
+std::optional<std::chrono::milliseconds>
+CoreServer::limited(const Request &req, std::string_view client) {
+  auto router = routerRateLimit_.find(req.method());
+  if (router == routerRateLimit_.end()) {
+    return std::nullopt;
+  }
+  auto target = urls::parse_origin_form(req.target());
+  if (!target) {
+    return std::nullopt;
+  }
+  router::MatchesStorage matches(req.get_allocator());
+  auto route = router->second.find(target->encoded_segments(), matches);
+  if (!route) {
+    return std::nullopt;
+  }
+  if (!rateLimitHeader_.empty()) {
+    if (auto key = req[rateLimitHeader_]; !key.empty()) {
+      client = std::string_view(key.data(), key.size());
+    }
+  }
+  size_t key = route->id;
+  boost::hash_combine(key, client);
+  auto decision = rateLimiter_.take(key, route->limit);
+  if (decision.allowed) {
+    return std::nullopt;
+  }
+  return decision.retryAfter;
+}
+
+CoreServer::Response
+CoreServer::tooManyRequests(const Request &req,
+                            std::chrono::milliseconds retryAfter) const {
+  Response res{http::status::too_many_requests, req.version()};
+  res.set(http::field::server, "Core");
+  res.set(http::field::content_type, "application/json");
+  // Retry-After в целых секундах, округляем вверх
+  res.set(http::field::retry_after,
+          std::to_string(std::max<int64_t>(1, (retryAfter.count() + 999) / 1000)));
+  res.keep_alive(req.keep_alive());
+  res.body() = "{}";
+  res.prepare_payload();
+  return res;
+}
+
+bool CoreServer::metered(const Request &req) const {
+  auto target = urls::parse_origin_form(req.target());
+  if (!target) {
+    return true;
+  }
+  router::MatchesStorage matches(req.get_allocator());
+  auto param = routerLongPoll_.find(target->encoded_segments(), matches);
+  return !param or !target->params().contains(*param);
+}
+
+void CoreServer::ready() {
+  ready_.store(true, std::memory_order_release);
+}
+
+std::optional<CoreServer::Response>
+CoreServer::probe(const Request &req) const {
+  if (req.method() != http::verb::get) {
+    return std::nullopt;
+  }
+  auto target = urls::parse_origin_form(req.target());
+  if (!target) {
+    return std::nullopt;
+  }
+  std::string_view status;
+  if (target->encoded_path() == kHealthPath) {
+    status = "ok";
+  } else if (target->encoded_path() == kReadyPath) {
+    status = draining_ ? "draining"
+             : ready_.load(std::memory_order_acquire) ? "ok"
+                                                       : "starting";
+  } else {
+    return std::nullopt;
+  }
+  Response res{status == "ok" ? http::status::ok
+                              : http::status::service_unavailable,
+               req.version()};
+  res.set(http::field::server, "Core");
+  res.set(http::field::content_type, "application/json");
+  res.set(http::field::cache_control, "no-store");
+  res.keep_alive(req.keep_alive());
+  res.body() = std::string(R"({"status":")").append(status).append("\"}");
+  res.prepare_payload();
+  return res;
+}
+
+CoreServer::Response CoreServer::failed(const Request &req,
+                                        std::exception_ptr error) const {
+  Response res{http::status::internal_server_error, req.version()};
+  res.set(http::field::server, "Core");
+  res.set(http::field::content_type, "application/json");
+  res.keep_alive(req.keep_alive());
+  res.body() = R"({"error":"internal error"})";
+  try {
+    std::rethrow_exception(error);
+  } catch (const database::QueryCancelled &e) {
+    BOOST_LOG_TRIVIAL(warning) << "[handle_request] " << req.method_string()
+                               << " " << req.target() << ": " << e.what()
+                               << std::endl;
+    res.result(http::status::gateway_timeout);
+    res.body() = R"({"error":"deadline exceeded"})";
+  } catch (const std::exception &e) {
+    BOOST_LOG_TRIVIAL(error) << "[handle_request] " << req.method_string()
+                             << " " << req.target() << ": " << e.what()
+                             << std::endl;
+  }
+  res.prepare_payload();
+  return res;
+}
+
+CoreServer::Response CoreServer::overloaded(const Request &req) const {
+  Response res{http::status::service_unavailable, req.version()};
+  res.set(http::field::server, "Core");
+  res.set(http::field::content_type, "application/json");
+  res.set(http::field::retry_after,
+          std::to_string(admission_.options().retryAfter.count()));
+  res.keep_alive(req.keep_alive());
+  res.body() = "{}";
+  res.prepare_payload();
+  return res;
+}
+
+void CoreServer::encode(const Request &req, Response &res) {
+  if (res.result() == http::status::not_modified) {
+    // Клиент хранит сжатый вариант: 304 повторяет его слабый тег
+    auto etag = res[http::field::etag];
+    if (!etag.empty() and
+        req[http::field::if_none_match].find(weakEtag(etag)) !=
+            std::string_view::npos) {
+      res.set(http::field::etag, weakEtag(etag));
+      res.set(http::field::vary, "Accept-Encoding");
+    }
+    return;
+  }
+  if (res.result() != http::status::ok or
+      res.body().size() < compressionOptions_.minSize or
+      res.count(http::field::content_encoding)) {
+    return;
+  }
+  auto encoding = negotiateEncoding(req[http::field::accept_encoding]);
+  if (encoding == Encoding::identity) {
+    return;
+  }
+  auto level = encoding == Encoding::zstd ? compressionOptions_.zstdLevel
+                                          : compressionOptions_.gzipLevel;
+  auto name = encodingName(encoding);
+  // Ответ с ETag неизменен, пока не сменится тег: его можно сжать один раз
+  auto etag = res[http::field::etag];
+  if (etag.empty()) {
+    res.body() = compress(res.body(), encoding, level);
+  } else {
+    std::string key;
+    key.append(req.target()).append(" ").append(etag).append(" ").append(name);
+    auto compressed = compressionCache_.find(key);
+    if (!compressed) {
+      compressed = std::make_shared<const std::string>(
+          compress(res.body(), encoding, level));
+      compressionCache_.insert(key, compressed);
+    }
+    res.body() = *compressed;
+    // Байты сжатого варианта другие: сильный тег остаётся у исходного
+    res.set(http::field::etag, weakEtag(etag));
+  }
+  res.set(http::field::content_encoding, name);
+  res.set(http::field::vary, "Accept-Encoding");
+}
+
 } // namespace core
\ No newline at end of file
@@ -10,8 +10,26 @@
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "admission.hpp"
+#include "compression.hpp"
+#include "event_hub.hpp"
+#include "query_context.hpp"
+#include "rate_limiter.hpp"
+#include "request_arena.hpp"
 #include "router.hpp"
 #include "server_iface.hpp"
+#include "settings.hpp"
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -28,18 +46,138 @@ struct CoreServer final : AbstractServer,
                           std::enable_shared_from_this<CoreServer> {
 
   CoreServer() : workGuard_(boost::asio::make_work_guard(ioc_)) {}
-  using Request = http::request<http::string_body>;
-  using Response = http::response<http::string_body>;
-  using Handler = std::function<std::optional<Response>(
-      Request request, router::MatchesStorage matches)>;
+  using Request = AbstractServer::Request;
+  using Response = AbstractServer::Response;
+  using Handler = AbstractServer::Handler;
+  using AsyncHandler = AbstractServer::AsyncHandler;
 
   void get(std::string_view route, Handler handler) override;
   void put(std::string_view route, Handler handler) override;
   void post(std::string_view route, Handler handler) override;
   void del(std::string_view route, Handler handler) override;
+  void getAsync(std::string_view route, AsyncHandler handler) override;
+  void postAsync(std::string_view route, AsyncHandler handler) override;
+  void delAsync(std::string_view route, AsyncHandler handler) override;
+
+  void stream(std::string_view route) override;
+  void longPoll(std::string_view route, std::string_view param) override;
+  size_t publish(std::string_view topic, std::string event) override;
+  size_t clientOf(const Request &req) const override;
 
   void run(tcp::endpoint endpoint) override;
 
+  /**
+   * @brief Настраивает сжатие ответов (порог, уровни, размер кэша)
+   */
+  void compression(CompressionOptions options);
+
+  /**
+   * @brief Настраивает пределы соединений и запросов в работе
+   */
+  void admission(AdmissionOptions options);
+
+  /**
+   * @brief Ограничивает частоту запросов каждого клиента к маршруту
+   *
+   * @param method Метод запроса
+   * @param route Шаблон маршрута, как в get()/post()
+   */
+  void rateLimit(http::verb method, std::string_view route, RateLimit limit);
+
+  /**
+   * @brief Различать клиентов по заголовку (например, X-Api-Key)
+   *
+   * Без заголовка клиент — адрес соединения. Включайте только за прокси,
+   * который проверяет ключ: иначе клиент обойдёт предел, меняя ключи.
+   * Тот же заголовок отличает клиента для read-your-writes (clientOf()).
+   */
+  void rateLimitBy(std::string header);
+
+  /**
+   * @brief Срок обработки запросов маршрута
+   *
+   * Срок доходит до базы: запрос к ней отменяется, если срок истёк или
+   * клиент отключился. Тогда клиент (если он ещё ждёт) получает 504.
+   *
+   * @param method Метод запроса
+   * @param route Шаблон маршрута, как в get()/post()
+   */
+  void deadline(http::verb method, std::string_view route,
+                std::chrono::milliseconds timeout);
+
+  /**
+   * @brief Срок маршрутов, для которых не задан свой
+   */
+  void defaultDeadline(std::chrono::milliseconds timeout);
+
+  /**
+   * @brief Принимать соединения на уже слушающем сокете вместо bind()
+   *
+   * @param listener Дескриптор, полученный от ListenerHandoff
+   */
+  void inherit(int listener);
+
+  /**
+   * @brief Слушать Unix-сокет @p path и отдавать по нему слушающий сокет
+   * новому процессу, после чего остановиться
+   */
+  void handoffAt(std::filesystem::path path);
+
+  /**
+   * @brief Сколько ждать начатые запросы при остановке
+   */
+  void drainTimeout(std::chrono::seconds timeout);
+
+  /**
+   * @brief Сколько соединение может молчать до следующего запроса и сколько
+   * ждать записи ответа
+   *
+   * Пока обработчик работает, таймаута нет: долгий long-poll ограничен
+   * самим маршрутом, а обычный запрос — своим сроком.
+   */
+  void idleTimeout(std::chrono::milliseconds timeout);
+
+  /**
+   * @brief Вызывается при остановке после того, как соединения закрыты
+   *
+   * Здесь сбрасывают в базу отложенные записи.
+   */
+  void onShutdown(std::function<void()> hook);
+
+  /**
+   * @brief Сервер прогрет: GET /readyz начинает отвечать 200
+   *
+   * До этого и во время остановки /readyz отвечает 503, а /healthz — 200,
+   * пока процесс обслуживает соединения. Потокобезопасен.
+   */
+  void ready();
+
+  /**
+   * @brief Применяет все настройки разом, заменяя заданные ранее
+   *
+   * Таблицы пределов и сроков собираются заново и подменяют старые; корзины
+   * клиентов сохраняются. Лимит admission начинается заново, только если
+   * его параметры изменились. После run() вызывать из потока сервера
+   * (например, из хука onReload).
+   */
+  void configure(const ServerSettings &settings);
+
+  /**
+   * @brief Вызывается в потоке сервера по SIGHUP
+   *
+   * Хук перечитывает конфигурацию и применяет её через configure(); запросы
+   * в это время не обрабатываются, io_context не перезапускается.
+   */
+  void onReload(std::function<void()> hook);
+
+  /**
+   * @brief Механизм ввода-вывода asio, с которым собран сервер
+   *
+   * @return "io_uring" при сборке с экспериментальной CORE_USE_IO_URING,
+   * иначе "reactor" (epoll, kqueue или select в зависимости от системы)
+   */
+  static std::string_view backend();
+
 protected:
   /**
    * @brief Принимает входящие соединения и запускает сессии
@@ -48,6 +186,26 @@ protected:
    */
   asio::awaitable<void> listenTo(tcp::endpoint endpoint);
 
+  /**
+   * @brief Плавная остановка
+   *
+   * Перестаёт принимать соединения, закрывает ждущие следующего запроса,
+   * даёт начатым запросам завершиться (не дольше drainTimeout) и вызывает
+   * хуки onShutdown. Соединения WebSocket и long-poll по истечении срока
+   * обрываются.
+   *
+   * @return asio::awaitable<void>
+   */
+  asio::awaitable<void> drain();
+
+  /**
+   * @brief Ждёт преемника на Unix-сокете, отдаёт ему слушающий сокет и
+   * останавливает сервер
+   *
+   * @return asio::awaitable<void>
+   */
+  asio::awaitable<void> handoff();
+
   /**
    * @brief Корутина, обрабатывающая одну клиентскую сессию
    *
@@ -56,23 +214,156 @@ protected:
    */
   asio::awaitable<void> session(tcp::socket socket);
 
+  /**
+   * @brief Корутина WebSocket-соединения: пересылает события темы клиенту
+   *
+   * @param socket Сокет после прочитанного запроса на апгрейд
+   * @param req Запрос на апгрейд
+   * @param topic Тема подписки
+   * @return asio::awaitable<void>
+   */
+  asio::awaitable<void> websocketSession(tcp::socket socket,
+                                         Request req,
+                                         std::string topic);
+
+  /**
+   * @brief Обрабатывает запрос: сначала асинхронные обработчики, затем
+   * синхронные
+   *
+   * Асинхронный обработчик выполняется на ContextExecutor: @p context
+   * действует и после каждого его co_await.
+   *
+   * @param req Входящий HTTP-запрос
+   * @param context Срок запроса
+   * @return asio::awaitable<Response> HTTP-ответ
+   */
+  asio::awaitable<Response> dispatch(const Request &req,
+                                     const database::QueryContext &context);
+
   /**
    * @brief Обрабатывает HTTP-запрос
    *
    * @param req Входящий HTTP-запрос
-   * @return http::response<http::string_body> HTTP-ответ
+   * @param context Срок запроса, действует на время обработчика
+   * @return Response HTTP-ответ
+   */
+  Response handle_request(const Request &req,
+                          const database::QueryContext &context);
+
+  /**
+   * @brief Сжимает тело ответа согласно Accept-Encoding запроса
+   *
+   * @param req Входящий HTTP-запрос
+   * @param res Готовый ответ, тело заменяется сжатым
    */
-  http::response<http::string_body>
-  handle_request(const http::request<http::string_body> &req);
+  void encode(const Request &req, Response &res);
+
+  /**
+   * @brief Проходит ли запрос через admission control
+   *
+   * @return false для WebSocket и long-poll запросов
+   */
+  bool metered(const Request &req) const;
+
+  /**
+   * @brief Ответ на GET /healthz и /readyz, иначе std::nullopt
+   */
+  std::optional<Response> probe(const Request &req) const;
+
+  /**
+   * @brief Ответ на исключение обработчика
+   *
+   * @return 504, если запрос к базе отменён по сроку (QueryCancelled),
+   * иначе 500
+   */
+  Response failed(const Request &req, std::exception_ptr error) const;
+
+  /**
+   * @brief Быстрый отказ перегруженного сервера: 503 с Retry-After
+   */
+  Response overloaded(const Request &req) const;
+
+  /**
+   * @brief Берёт токен клиента для маршрута запроса
+   *
+   * @param client Адрес соединения
+   * @return Через сколько повторить, если предел исчерпан
+   */
+  std::optional<std::chrono::milliseconds> limited(const Request &req,
+                                                   std::string_view client);
+
+  /**
+   * @brief Срок обработки запроса: свой у маршрута или общий
+   */
+  std::chrono::milliseconds deadlineOf(const Request &req) const;
+
+  /**
+   * @brief Ответ 429 с Retry-After
+   */
+  Response tooManyRequests(const Request &req,
+                           std::chrono::milliseconds retryAfter) const;
 
   router::Router<Handler> routerGet_;
   router::Router<Handler> routerPut_;
   router::Router<Handler> routerPost_;
   router::Router<Handler> routerDelete_;
+  router::Router<AsyncHandler> routerGetAsync_;
+  router::Router<AsyncHandler> routerPostAsync_;
+  router::Router<AsyncHandler> routerDeleteAsync_;
+  // Маршруты, доступные для WebSocket-подписки
+  router::Router<bool> routerStream_;
+  // Маршруты long-poll и имя параметра, включающего ожидание
+  router::Router<std::string> routerLongPoll_;
+  // Пределы частоты по методу и маршруту
+  struct RouteLimit {
+    RateLimit limit;
+    // Хеш метода и шаблона: отделяет корзины маршрутов одного клиента
+    size_t id;
+  };
+  std::map<http::verb, router::Router<RouteLimit>> routerRateLimit_;
+  // Сроки обработки по методу и маршруту
+  std::map<http::verb, router::Router<std::chrono::milliseconds>>
+      routerDeadline_;
+  std::chrono::milliseconds defaultDeadline_{kDefaultDeadline};
+
+  // Поток клиентской сессии: операции по умолчанию — корутины
+  using Stream = asio::use_awaitable_t<>::as_default_on_t<beast::tcp_stream>;
+
+  // Сколько событий может ждать отправки одному клиенту
+  static constexpr size_t kMaxQueuedEvents = 64;
+  // Совпадает с простоем соединения в session()
+  static constexpr std::chrono::milliseconds kDefaultDeadline{30'000};
+  static constexpr std::chrono::milliseconds kIdleTimeout{30'000};
+
+  // Живость и готовность для оркестратора
+  static constexpr std::string_view kHealthPath = "/healthz";
+  static constexpr std::string_view kReadyPath = "/readyz";
+
+  // Как часто drain() проверяет, закрылись ли соединения
+  static constexpr std::chrono::milliseconds kDrainPollInterval{50};
 
 private:
+  EventHub events_;
+  AdmissionController admission_;
+  RateLimiter rateLimiter_;
+  std::string rateLimitHeader_;
+  CompressionOptions compressionOptions_;
+  CompressionCache compressionCache_{compressionOptions_.cacheBytes};
   asio::io_context ioc_;
   boost::asio::executor_work_guard<boost::asio::io_context::executor_type>
       workGuard_;
+  tcp::acceptor acceptor_{ioc_};
+  // Слушающий сокет предыдущего процесса, -1 — открыть свой
+  int inherited_ = -1;
+  std::filesystem::path handoffPath_;
+  std::chrono::seconds drainTimeout_{30};
+  std::chrono::milliseconds idleTimeout_{kIdleTimeout};
+  std::vector<std::function<void()>> shutdownHooks_;
+  std::vector<std::function<void()>> reloadHooks_;
+  bool draining_ = false;
+  // Выставляется из потока прогрева
+  std::atomic<bool> ready_{false};
+  // Соединения, ждущие следующего запроса: при остановке их закрывают сразу
+  std::unordered_set<Stream *> idle_;
 };
 } // namespace core
\ No newline at end of file
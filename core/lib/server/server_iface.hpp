@@ -10,6 +10,10 @@
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+
 namespace beast = boost::beast;
 namespace http = beast::http;
 namespace asio = boost::asio;
@@ -20,16 +24,74 @@ namespace core {
  * @brief Интерфейс HTTP-сервера.
  */
 struct AbstractServer {
-  using MatchesStorage = std::unordered_map<std::string_view, std::string>;
-  using Request = http::request<http::string_body>;
+  /**
+   * @brief Запрос и совпадения маршрута выделяются из арены соединения
+   *
+   * Они живут, пока обработчик не вернул ответ: сохранять ссылки на них
+   * дольше нельзя, копировать — можно (копия уходит в кучу).
+   */
+  using Allocator = std::pmr::polymorphic_allocator<char>;
+  using MatchesStorage =
+      std::pmr::unordered_map<std::string_view, std::pmr::string>;
+  using Request =
+      http::request<http::basic_string_body<char, std::char_traits<char>,
+                                            Allocator>,
+                    http::basic_fields<Allocator>>;
   using Response = http::response<http::string_body>;
   using Handler = std::function<std::optional<Response>(
-      Request request, MatchesStorage matches)>;
+      const Request &request, const MatchesStorage &matches)>;
+  /**
+   * @brief Асинхронный обработчик: может припарковать запрос без потока
+   *
+   * Вызывается раньше синхронного обработчика того же маршрута. Если
+   * корутина вернула std::nullopt, запрос обрабатывается как обычно.
+   */
+  using AsyncHandler = std::function<asio::awaitable<std::optional<Response>>(
+      const Request &request, const MatchesStorage &matches)>;
 
   virtual void get(std::string_view route, Handler handler) = 0;
   virtual void put(std::string_view route, Handler handler) = 0;
   virtual void post(std::string_view route, Handler handler) = 0;
   virtual void del(std::string_view route, Handler handler) = 0;
+  virtual void getAsync(std::string_view route, AsyncHandler handler) = 0;
+  virtual void postAsync(std::string_view route, AsyncHandler handler) = 0;
+  virtual void delAsync(std::string_view route, AsyncHandler handler) = 0;
+
+  /**
+   * @brief Разрешает подписку на события по WebSocket для маршрута
+   *
+   * Темой подписки служит путь запроса на апгрейд, например
+   * "/games/{gameId}/events" даёт тему "/games/<id>/events". UUID в пути
+   * приводятся к строчной записи, см. topicOf().
+   */
+  virtual void stream(std::string_view route) = 0;
+
+  /**
+   * @brief Отмечает маршрут с долгим ожиданием (long-poll)
+   *
+   * Запросы к маршруту с параметром @p param в строке запроса могут ждать
+   * событий десятки секунд: они не занимают слот admission control и не
+   * влияют на оценку задержки.
+   */
+  virtual void longPoll(std::string_view route, std::string_view param) = 0;
+
+  /**
+   * @brief Рассылает событие всем подписчикам темы
+   *
+   * @return Сколько подписчиков получили событие
+   */
+  virtual size_t publish(std::string_view topic, std::string event) = 0;
+
+  /**
+   * @brief Ключ клиента запроса для read-your-writes при чтении с реплик
+   *
+   * Записи, выполняемые вне обработчика (write-behind), несут его в
+   * database::Query::client.
+   *
+   * @return 0, если клиент неизвестен: тогда его чтения сверяются с
+   * последней записью вообще
+   */
+  virtual size_t clientOf(const Request &req) const = 0;
   virtual void run(ip::tcp::endpoint endpoint) = 0;
 };
 } // namespace core
\ No newline at end of file
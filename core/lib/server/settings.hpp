@@ -0,0 +1,42 @@
+#pragma once
+
+#include <boost/beast/http/verb.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "admission.hpp"
+#include "compression.hpp"
+#include "rate_limiter.hpp"
+
+namespace core {
+/**
+ * @brief Настройки сервера, которые можно менять без перезапуска
+ *
+ * CoreServer::configure() применяет их целиком: после него запросы видят
+ * либо все старые значения, либо все новые.
+ */
+struct ServerSettings {
+  struct RouteRateLimit {
+    boost::beast::http::verb method;
+    std::string route;
+    RateLimit limit;
+  };
+
+  struct RouteDeadline {
+    boost::beast::http::verb method;
+    std::string route;
+    std::chrono::milliseconds timeout;
+  };
+
+  AdmissionOptions admission;
+  CompressionOptions compression;
+  std::vector<RouteRateLimit> rateLimits;
+  // Заголовок, различающий клиентов; пустой — адрес соединения
+  std::string rateLimitHeader;
+  std::chrono::milliseconds defaultDeadline{30'000};
+  std::vector<RouteDeadline> deadlines;
+  std::chrono::seconds drainTimeout{30};
+};
+} // namespace core
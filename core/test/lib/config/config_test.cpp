@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "config.hpp"
+
+namespace {
+// Переменная окружения на время теста
+struct ScopedEnv {
+  ScopedEnv(const char *name, const char *value) : name_(name) {
+    ::setenv(name, value, 1);
+  }
+  ~ScopedEnv() { ::unsetenv(name_); }
+
+  const char *name_;
+};
+
+struct ConfigFile {
+  explicit ConfigFile(const std::string &text)
+      : path(std::filesystem::temp_directory_path() /
+             ("core_config_test_" + std::to_string(::getpid()) + ".ini")) {
+    write(text);
+  }
+  ~ConfigFile() { std::filesystem::remove(path); }
+
+  void write(const std::string &text) { std::ofstream(path) << text; }
+
+  std::filesystem::path path;
+};
+} // namespace
+
+TEST(ConfigTest, Defaults) {
+  core::Config config(std::vector<std::string>{});
+  EXPECT_EQ(config.get<uint16_t>("port"), 8080);
+  EXPECT_EQ(config.logLevel(), boost::log::trivial::info);
+  auto settings = config.server();
+  EXPECT_EQ(settings.admission.maxLimit, 512);
+  EXPECT_TRUE(settings.rateLimits.empty());
+  EXPECT_EQ(settings.defaultDeadline, std::chrono::milliseconds(30'000));
+}
+
+TEST(ConfigTest, CommandLineOverEnvironmentOverFile) {
+  ConfigFile file("max-inflight = 100\n"
+                  "admission-queue = 7\n"
+                  "db-name = from_file\n");
+  ScopedEnv inflight("CORE_MAX_INFLIGHT", "200");
+  ScopedEnv dbName("CORE_DB_NAME", "from_env");
+  core::Config config({"--config", file.path.string(), "--db-name", "cli"});
+  EXPECT_EQ(config.get<std::string>("db-name"), "cli");
+  EXPECT_EQ(config.get<size_t>("max-inflight"), 200);
+  EXPECT_EQ(config.get<size_t>("admission-queue"), 7);
+}
+
+TEST(ConfigTest, MapsEnvironmentVariables) {
+  core::Config config(std::vector<std::string>{});
+  EXPECT_EQ(config.optionOf("CORE_MAX_INFLIGHT"), "max-inflight");
+  EXPECT_EQ(config.optionOf("CORE_DB_PASSWORD"), "db-password");
+  EXPECT_EQ(config.optionOf("CORE_NO_SUCH_OPTION"), "");
+  EXPECT_EQ(config.optionOf("CORE_HELP"), "");
+  EXPECT_EQ(config.optionOf("MAX_INFLIGHT"), "");
+}
+
+TEST(ConfigTest, ParsesRoutesAndLimits) {
+  ConfigFile file("rate-limit = GET /games=100:200\n"
+                  "deadline = GET /games/{id}=250\n"
+                  "deadline = POST /games=1000\n"
+                  "compression-cache-mb = 2\n");
+  core::Config config({"--config", file.path.string()});
+  auto settings = config.server();
+  ASSERT_EQ(settings.rateLimits.size(), 1);
+  EXPECT_EQ(settings.rateLimits[0].method, boost::beast::http::verb::get);
+  EXPECT_EQ(settings.rateLimits[0].route, "/games");
+  EXPECT_EQ(settings.rateLimits[0].limit.burst, 200);
+  ASSERT_EQ(settings.deadlines.size(), 2);
+  EXPECT_EQ(settings.deadlines[0].route, "/games/{id}");
+  EXPECT_EQ(settings.deadlines[0].timeout, std::chrono::milliseconds(250));
+  EXPECT_EQ(settings.compression.cacheBytes, 2u << 20);
+}
+
+TEST(ConfigTest, ReloadKeepsCommandLinePriority) {
+  ConfigFile file("max-inflight = 100\nlog-level = info\n");
+  core::Config config({"--config", file.path.string(), "--port", "9000"});
+  file.write("max-inflight = 50\nlog-level = warning\nport = 9001\n");
+  config.reload();
+  EXPECT_EQ(config.get<size_t>("max-inflight"), 50);
+  EXPECT_EQ(config.logLevel(), boost::log::trivial::warning);
+  EXPECT_EQ(config.get<uint16_t>("port"), 9000);
+}
+
+TEST(ConfigTest, FailedReloadKeepsValues) {
+  ConfigFile file("max-inflight = 100\n");
+  core::Config config({"--config", file.path.string()});
+  file.write("max-inflight = many\n");
+  EXPECT_ANY_THROW(config.reload());
+  file.write("no-such-option = 1\n");
+  EXPECT_ANY_THROW(config.reload());
+  EXPECT_EQ(config.get<size_t>("max-inflight"), 100);
+}
+
+TEST(ConfigTest, InvalidReloadKeepsSettings) {
+  ConfigFile file("max-inflight = 100\nlog-level = warning\n");
+  core::Config config({"--config", file.path.string()});
+  file.write("max-inflight = 50\nrate-limit = FETCH /games=1\n");
+  EXPECT_THROW(config.reload(), std::invalid_argument);
+  file.write("max-inflight = 50\nlog-level = loud\n");
+  EXPECT_THROW(config.reload(), std::invalid_argument);
+  EXPECT_EQ(config.server().admission.maxLimit, 100);
+  EXPECT_EQ(config.logLevel(), boost::log::trivial::warning);
+}
+
+TEST(ConfigTest, RejectsBadRules) {
+  EXPECT_THROW(core::Config({"--rate-limit", "FETCH /games=1"}).server(),
+               std::invalid_argument);
+  EXPECT_THROW(core::Config({"--deadline", "GET /games"}).server(),
+               std::invalid_argument);
+  EXPECT_THROW(core::Config({"--log-level", "loud"}).logLevel(),
+               std::invalid_argument);
+}
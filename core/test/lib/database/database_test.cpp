@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "database.hpp"
+#include "query_builder.hpp"
+
+namespace {
+// Адрес базы берётся из тех же переменных, что и у сервера; без базы
+// тесты пропускаются
+std::string env(const char *name, const char *fallback) {
+  auto *value = std::getenv(name);
+  return value ? value : fallback;
+}
+
+class DatabaseTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    try {
+      db = std::make_unique<database::Database>(
+          env("CORE_DB_NAME", "road_n_roll"), env("CORE_DB_USER", "joe"),
+          env("CORE_DB_PASSWORD", "12345678"),
+          env("CORE_DB_HOST", "localhost"),
+          std::stoul(env("CORE_DB_PORT", "5432")));
+    } catch (const std::exception &e) {
+      GTEST_SKIP() << "Нет соединения с базой: " << e.what();
+    }
+  }
+
+  database::Query query(std::string sql) {
+    database::Query query;
+    query.sql = std::move(sql);
+    return query;
+  }
+
+  std::unique_ptr<database::Database> db;
+};
+} // namespace
+
+TEST_F(DatabaseTest, RunsPipeline) {
+  auto results = db->fetchPipeline(
+      {query("SELECT 1::int4 AS one"),
+       database::QueryBuilder().generic("SELECT $1::int4 AS value",
+                                        {int32_t(7)}),
+       query("SELECT n::int4 FROM generate_series(1, 3) AS n")});
+  ASSERT_EQ(results.size(), 3);
+  ASSERT_EQ(results[0].size(), 1);
+  EXPECT_EQ(std::get<int32_t>(results[0][0].at("one")), 1);
+  ASSERT_EQ(results[1].size(), 1);
+  EXPECT_EQ(std::get<int32_t>(results[1][0].at("value")), 7);
+  EXPECT_EQ(results[2].size(), 3);
+}
+
+TEST_F(DatabaseTest, PipelineErrorLeavesConnectionUsable) {
+  EXPECT_THROW(db->fetchPipeline({query("SELECT 1"), query("SELECT 1/0"),
+                                  query("SELECT 2")}),
+               std::runtime_error);
+  // Соединение вышло из pipeline mode: и конвейер, и libpqxx работают
+  auto results = db->fetchPipeline({query("SELECT 3::int4 AS three")});
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_EQ(std::get<int32_t>(results[0].at(0).at("three")), 3);
+  auto row = db->fetchSingle(query("SELECT 4::int4 AS four"));
+  EXPECT_EQ(std::get<int32_t>(row.at("four")), 4);
+}
@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "group_commit.hpp"
+
+namespace {
+using namespace std::chrono_literals;
+
+// Фейковая БД: считает пакеты и "падает" на командах с текстом FAIL
+struct FakeDatabase final : database::AbstractDatabase {
+  size_t executeCommand(database::Query query) final {
+    std::lock_guard lock(mutex);
+    single++;
+    if (query.sql == "FAIL") {
+      throw std::runtime_error("boom");
+    }
+    return query.sql.size();
+  }
+  std::vector<size_t> executeBatch(std::vector<database::Query> queries) final {
+    std::lock_guard lock(mutex);
+    batches.push_back(queries.size());
+    std::vector<size_t> result;
+    for (auto &&query : queries) {
+      if (query.sql == "FAIL") {
+        throw std::runtime_error("boom");
+      }
+      result.push_back(query.sql.size());
+    }
+    return result;
+  }
+  database::RowFields fetchSingle(database::Query) final { return {}; }
+  std::vector<database::RowFields> fetchMultiple(database::Query) final {
+    return {};
+  }
+  void fetchRows(database::Query, const RowConsumer &) final {}
+  std::vector<std::vector<database::RowFields>>
+  fetchPipeline(std::vector<database::Query>) final {
+    return {};
+  }
+  // Шард — первый байт ключа
+  size_t shardOf(const boost::uuids::uuid &key) const final {
+    return key.data[0];
+  }
+
+  std::mutex mutex;
+  std::vector<size_t> batches;
+  size_t single = 0;
+};
+
+database::Query makeQuery(std::string sql, uint8_t shard = 0) {
+  database::Query query;
+  query.sql = std::move(sql);
+  boost::uuids::uuid key{};
+  key.data[0] = shard;
+  query.shardKey = key;
+  return query;
+}
+} // namespace
+
+TEST(GroupCommitTest, CoalescesCommands) {
+  auto fake = std::make_shared<FakeDatabase>();
+  std::vector<std::future<size_t>> results;
+  {
+    database::GroupCommitDatabase db(fake, 50ms, 4);
+    for (auto sql : {"a", "bb", "ccc", "dddd"}) {
+      results.push_back(db.submit(makeQuery(sql)));
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+      EXPECT_EQ(results[i].get(), i + 1);
+    }
+  }
+  ASSERT_EQ(fake->batches.size(), 1);
+  EXPECT_EQ(fake->batches.front(), 4);
+  EXPECT_EQ(fake->single, 0);
+}
+
+TEST(GroupCommitTest, RespectsBatchBound) {
+  auto fake = std::make_shared<FakeDatabase>();
+  {
+    database::GroupCommitDatabase db(fake, 20ms, 2);
+    std::vector<std::future<size_t>> results;
+    for (int i = 0; i < 5; ++i) {
+      results.push_back(db.submit(makeQuery("x")));
+    }
+    for (auto &&result : results) {
+      EXPECT_EQ(result.get(), 1);
+    }
+  }
+  for (auto size : fake->batches) {
+    EXPECT_LE(size, 2);
+  }
+}
+
+TEST(GroupCommitTest, RetriesFailedBatchOneByOne) {
+  auto fake = std::make_shared<FakeDatabase>();
+  database::GroupCommitDatabase db(fake, 50ms, 3);
+  auto good = db.submit(makeQuery("ok"));
+  auto bad = db.submit(makeQuery("FAIL"));
+  auto other = db.submit(makeQuery("fine"));
+  EXPECT_EQ(good.get(), 2);
+  EXPECT_THROW(bad.get(), std::runtime_error);
+  EXPECT_EQ(other.get(), 4);
+  EXPECT_EQ(fake->single, 3);
+}
+
+TEST(GroupCommitTest, SplitsBatchByShard) {
+  auto fake = std::make_shared<FakeDatabase>();
+  {
+    database::GroupCommitDatabase db(fake, 50ms, 4);
+    auto first = db.submit(makeQuery("a", 1));
+    auto second = db.submit(makeQuery("bb", 2));
+    auto third = db.submit(makeQuery("ccc", 1));
+    auto fourth = db.submit(makeQuery("dddd", 2));
+    EXPECT_EQ(first.get(), 1);
+    EXPECT_EQ(second.get(), 2);
+    EXPECT_EQ(third.get(), 3);
+    EXPECT_EQ(fourth.get(), 4);
+  }
+  EXPECT_EQ(fake->batches, (std::vector<size_t>{2, 2}));
+}
+
+TEST(GroupCommitTest, RetriesOnlyFailedShard) {
+  auto fake = std::make_shared<FakeDatabase>();
+  database::GroupCommitDatabase db(fake, 50ms, 3);
+  auto good = db.submit(makeQuery("ok", 1));
+  auto bad = db.submit(makeQuery("FAIL", 2));
+  auto other = db.submit(makeQuery("fine", 2));
+  EXPECT_EQ(good.get(), 2);
+  EXPECT_THROW(bad.get(), std::runtime_error);
+  EXPECT_EQ(other.get(), 4);
+  // Пакет первого шарда зафиксирован и не повторяется
+  EXPECT_EQ(fake->single, 2);
+}
+
+TEST(GroupCommitTest, AsyncSubmitResumesOnExecutor) {
+  auto fake = std::make_shared<FakeDatabase>();
+  database::GroupCommitDatabase db(fake, 1ms, 4);
+  boost::asio::io_context ioc;
+  std::thread::id resumedOn;
+  size_t affected = 0;
+  bool failed = false;
+  boost::asio::co_spawn(
+      ioc,
+      [&]() -> boost::asio::awaitable<void> {
+        affected = co_await db.asyncSubmit(makeQuery("abc"),
+                                           boost::asio::use_awaitable);
+        resumedOn = std::this_thread::get_id();
+        try {
+          co_await db.asyncSubmit(makeQuery("FAIL"),
+                                  boost::asio::use_awaitable);
+        } catch (const std::runtime_error &) {
+          failed = true;
+        }
+      },
+      boost::asio::detached);
+  // Ожидающая команда держит работу: run() не выходит раньше времени
+  ioc.run();
+  EXPECT_EQ(affected, 3);
+  EXPECT_EQ(resumedOn, std::this_thread::get_id());
+  EXPECT_TRUE(failed);
+}
+
+TEST(GroupCommitTest, DrainWaitsForCompletions) {
+  auto fake = std::make_shared<FakeDatabase>();
+  database::GroupCommitDatabase db(fake, 20ms, 4);
+  std::atomic<size_t> done = 0;
+  auto count = [&done](std::exception_ptr, size_t) { ++done; };
+  // Команды разных шардов завершаются в разных транзакциях одного пакета
+  db.submit(makeQuery("a", 1), count);
+  db.submit(makeQuery("FAIL", 2), count);
+  db.submit(makeQuery("c", 3), count);
+  db.drain();
+  EXPECT_EQ(done, 3);
+  // Пустая очередь не ждёт окна
+  db.drain();
+}
+
+TEST(GroupCommitTest, ThrowingCompletionDoesNotRepeatBatch) {
+  auto fake = std::make_shared<FakeDatabase>();
+  database::GroupCommitDatabase db(fake, 20ms, 4);
+  std::atomic<size_t> calls = 0;
+  db.submit(makeQuery("a"), [&calls](std::exception_ptr, size_t) {
+    ++calls;
+    throw std::runtime_error("callback");
+  });
+  auto other = db.submit(makeQuery("bb"));
+  EXPECT_EQ(other.get(), 2);
+  db.drain();
+  EXPECT_EQ(calls, 1);
+  // Пакет зафиксирован один раз, по одной команды не повторялись
+  EXPECT_EQ(fake->batches, (std::vector<size_t>{2}));
+  EXPECT_EQ(fake->single, 0);
+  // Поток группировщика жив
+  EXPECT_EQ(db.submit(makeQuery("ccc")).get(), 3);
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+#include "query_builder.hpp"
+
+TEST(QueryBuilderTest, InsertManyRows) {
+  {
+    SCOPED_TRACE("Single column");
+    std::vector<database::RowFields> rows{{{"name", "Bob"s}},
+                                          {{"name", "Alice"s}},
+                                          {{"name", "Eve"s}}};
+    auto query = database::QueryBuilder().insertMany("people", rows);
+    EXPECT_NE(query.sql.find("INSERT INTO people (name)"), std::string::npos);
+    EXPECT_NE(query.sql.find("VALUES ($1), ($2), ($3)"), std::string::npos);
+    EXPECT_EQ(query.params.size(), 3);
+  }
+  {
+    SCOPED_TRACE("Several columns");
+    std::vector<database::RowFields> rows{
+        {{"id", int32_t(1)}, {"name", "Bob"s}},
+        {{"name", "Alice"s}, {"id", int32_t(2)}}};
+    auto query = database::QueryBuilder().insertMany("people", rows);
+    EXPECT_NE(query.sql.find("INSERT INTO people (id, name)"),
+              std::string::npos);
+    EXPECT_NE(query.sql.find("VALUES ($1, $2), ($3, $4)"), std::string::npos);
+    EXPECT_EQ(query.params.size(), 4);
+  }
+}
+
+TEST(QueryBuilderTest, InsertManyInvalidRows) {
+  {
+    SCOPED_TRACE("No rows");
+    EXPECT_THROW(database::QueryBuilder().insertMany("people", {}),
+                 std::invalid_argument);
+  }
+  {
+    SCOPED_TRACE("Missing column");
+    std::vector<database::RowFields> rows{
+        {{"id", int32_t(1)}, {"name", "Bob"s}}, {{"id", int32_t(2)}}};
+    EXPECT_THROW(database::QueryBuilder().insertMany("people", rows),
+                 std::invalid_argument);
+  }
+  {
+    SCOPED_TRACE("Different column");
+    std::vector<database::RowFields> rows{{{"id", int32_t(1)}},
+                                          {{"name", "Bob"s}}};
+    EXPECT_THROW(database::QueryBuilder().insertMany("people", rows),
+                 std::invalid_argument);
+  }
+}
+
+TEST(QueryBuilderTest, InsertStableShape) {
+  database::RowFields fields{
+      {"zeta", int32_t(1)}, {"alpha", "a"s}, {"mid", int64_t(2)}};
+  auto first = database::QueryBuilder().insert("shapes", fields);
+  EXPECT_NE(first.sql.find("INSERT INTO shapes (alpha, mid, zeta)"),
+            std::string::npos);
+  EXPECT_NE(first.sql.find("VALUES ($1, $2, $3)"), std::string::npos);
+  EXPECT_EQ(first.params.size(), 3);
+
+  {
+    SCOPED_TRACE("Same shape, same text");
+    database::RowFields other{
+        {"mid", int64_t(7)}, {"zeta", int32_t(8)}, {"alpha", "b"s}};
+    auto second = database::QueryBuilder().insert("shapes", other);
+    EXPECT_EQ(first.sql, second.sql);
+  }
+  {
+    SCOPED_TRACE("Different shape, different text");
+    database::RowFields other{{"alpha", "c"s}};
+    auto third = database::QueryBuilder().insert("shapes", other);
+    EXPECT_NE(first.sql, third.sql);
+    EXPECT_NE(third.sql.find("INSERT INTO shapes (alpha)"), std::string::npos);
+  }
+}
+
+TEST(QueryBuilderTest, InsertSkipsConflicts) {
+  database::RowFields fields{{"alpha", "a"s}};
+  auto plain = database::QueryBuilder().insert("shapes", fields);
+  auto skipping =
+      database::QueryBuilder{.onConflict = database::OnConflict::skip}.insert(
+          "shapes", fields);
+  EXPECT_EQ(plain.sql.find("ON CONFLICT"), std::string::npos);
+  EXPECT_NE(skipping.sql.find("ON CONFLICT DO NOTHING"), std::string::npos);
+  // Кэш форм различает вставки с пропуском и без
+  EXPECT_EQ(database::QueryBuilder().insert("shapes", fields).sql, plain.sql);
+
+  auto many =
+      database::QueryBuilder{.onConflict = database::OnConflict::skip}
+          .insertMany("shapes", {fields, fields});
+  EXPECT_NE(many.sql.find("ON CONFLICT DO NOTHING"), std::string::npos);
+}
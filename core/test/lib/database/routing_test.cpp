@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "query_context.hpp"
+#include "routing.hpp"
+
+namespace {
+using namespace std::chrono_literals;
+
+// Фейковый сервер: отвечает LSN на служебные запросы и считает чтения
+struct FakeServer final : database::AbstractDatabase {
+  explicit FakeServer(std::string lsn) : lsn(std::move(lsn)) {}
+
+  size_t executeCommand(database::Query) final {
+    ++writes;
+    return 1;
+  }
+  std::vector<size_t> executeBatch(std::vector<database::Query> queries) final {
+    ++writes;
+    return std::vector<size_t>(queries.size(), 1);
+  }
+  database::RowFields fetchSingle(database::Query query) final {
+    std::lock_guard lock(mutex);
+    if (query.sql.ends_with("AS lsn")) {
+      return {{"lsn", lsn}};
+    }
+    ++reads;
+    if (broken) {
+      throw std::runtime_error("connection lost");
+    }
+    return {};
+  }
+  std::vector<database::RowFields> fetchMultiple(database::Query query) final {
+    fetchSingle(std::move(query));
+    return {};
+  }
+  void fetchRows(database::Query, const RowConsumer &) final {}
+  std::vector<std::vector<database::RowFields>>
+  fetchPipeline(std::vector<database::Query>) final {
+    std::lock_guard lock(mutex);
+    ++pipelines;
+    if (broken) {
+      throw std::runtime_error("connection lost");
+    }
+    return {};
+  }
+
+  void setLsn(std::string value) {
+    std::lock_guard lock(mutex);
+    lsn = std::move(value);
+  }
+
+  std::mutex mutex;
+  std::string lsn;
+  size_t reads = 0;
+  size_t writes = 0;
+  size_t pipelines = 0;
+  bool broken = false;
+};
+
+// Проверки вызываются из теста, фоновый поток почти не просыпается
+constexpr database::RoutingDatabase::Options kManual{.checkInterval = 1h,
+                                                     .maxLag = 1h};
+
+database::Query read() { return database::Query{.sql = "SELECT 1"}; }
+} // namespace
+
+TEST(RoutingDatabaseTest, ReadsFromCaughtUpReplica) {
+  auto primary = std::make_shared<FakeServer>("0/10");
+  auto replica = std::make_shared<FakeServer>("0/10");
+  database::RoutingDatabase db(primary, {replica}, kManual);
+  db.refresh();
+  db.fetchMultiple(read());
+  db.executeCommand(read());
+  EXPECT_EQ(replica->reads, 1);
+  EXPECT_EQ(primary->reads, 0);
+  EXPECT_EQ(primary->writes, 1);
+}
+
+TEST(RoutingDatabaseTest, LaggingReplicaIsSkipped) {
+  auto primary = std::make_shared<FakeServer>("0/10");
+  auto replica = std::make_shared<FakeServer>("0/F");
+  database::RoutingDatabase db(primary, {replica}, kManual);
+  db.refresh();
+  db.fetchSingle(read());
+  EXPECT_EQ(replica->reads, 0);
+  EXPECT_EQ(primary->reads, 1);
+}
+
+TEST(RoutingDatabaseTest, StaleReplicaDropsOut) {
+  auto primary = std::make_shared<FakeServer>("0/10");
+  auto replica = std::make_shared<FakeServer>("0/10");
+  database::RoutingDatabase db(primary, {replica},
+                               {.checkInterval = 1h, .maxLag = 50ms});
+  db.refresh();
+  db.fetchSingle(read());
+  EXPECT_EQ(replica->reads, 1);
+  // Primary ушёл вперёд, реплика застряла
+  primary->setLsn("0/20");
+  std::this_thread::sleep_for(60ms);
+  db.refresh();
+  db.fetchSingle(read());
+  EXPECT_EQ(replica->reads, 1);
+  EXPECT_EQ(primary->reads, 1);
+}
+
+TEST(RoutingDatabaseTest, ReadsYourWrites) {
+  auto primary = std::make_shared<FakeServer>("0/10");
+  auto replica = std::make_shared<FakeServer>("0/10");
+  database::RoutingDatabase db(primary, {replica}, kManual);
+  db.refresh();
+
+  database::QueryContext writer{.client = 7};
+  database::QueryContext other{.client = 8};
+  {
+    database::QueryContext::Scope scope(writer);
+    db.executeCommand(read());
+    // Реплика ещё не видела эту запись
+    db.fetchSingle(read());
+  }
+  EXPECT_EQ(primary->reads, 1);
+  {
+    database::QueryContext::Scope scope(other);
+    db.fetchSingle(read());
+  }
+  EXPECT_EQ(replica->reads, 1);
+
+  primary->setLsn("0/20");
+  replica->setLsn("0/20");
+  db.refresh();
+  {
+    database::QueryContext::Scope scope(writer);
+    db.fetchSingle(read());
+  }
+  EXPECT_EQ(replica->reads, 2);
+  EXPECT_EQ(primary->reads, 1);
+}
+
+TEST(RoutingDatabaseTest, ReadsYourWritesFromOtherThread) {
+  auto primary = std::make_shared<FakeServer>("0/10");
+  auto replica = std::make_shared<FakeServer>("0/10");
+  database::RoutingDatabase db(primary, {replica}, kManual);
+  db.refresh();
+
+  // Как у группировщика: запись без контекста, автор — в самой команде
+  std::thread([&db] {
+    db.executeBatch({database::Query{.sql = "INSERT", .client = 7}});
+  }).join();
+  database::QueryContext writer{.client = 7};
+  database::QueryContext other{.client = 8};
+  {
+    database::QueryContext::Scope scope(writer);
+    db.fetchSingle(read());
+  }
+  EXPECT_EQ(primary->reads, 1);
+  {
+    database::QueryContext::Scope scope(other);
+    db.fetchSingle(read());
+  }
+  EXPECT_EQ(replica->reads, 1);
+}
+
+TEST(RoutingDatabaseTest, FallsBackToPrimary) {
+  auto primary = std::make_shared<FakeServer>("0/10");
+  auto replica = std::make_shared<FakeServer>("0/10");
+  replica->broken = true;
+  database::RoutingDatabase db(primary, {replica}, kManual);
+  db.refresh();
+  db.fetchSingle(read());
+  EXPECT_EQ(replica->reads, 1);
+  EXPECT_EQ(primary->reads, 1);
+}
+
+TEST(RoutingDatabaseTest, ParsesLsn) {
+  EXPECT_EQ(database::RoutingDatabase::parseLsn("16/B374D848"),
+            0x16B374D848ull);
+  EXPECT_EQ(database::RoutingDatabase::parseLsn("0/0"), 0);
+  EXPECT_FALSE(database::RoutingDatabase::parseLsn("16B374D848"));
+  EXPECT_FALSE(database::RoutingDatabase::parseLsn("/1"));
+  EXPECT_FALSE(database::RoutingDatabase::parseLsn("1/xyz"));
+}
+
+TEST(RoutingDatabaseTest, WarmsUpEveryServer) {
+  auto primary = std::make_shared<FakeServer>("0/10");
+  auto replica = std::make_shared<FakeServer>("0/10");
+  auto broken = std::make_shared<FakeServer>("0/10");
+  broken->broken = true;
+  database::RoutingDatabase db(primary, {replica, broken}, kManual);
+  // Недоступная реплика не мешает готовности
+  db.warmUp({read()});
+  EXPECT_EQ(primary->pipelines, 1);
+  EXPECT_EQ(replica->pipelines, 1);
+  EXPECT_EQ(broken->pipelines, 1);
+  primary->broken = true;
+  EXPECT_THROW(db.warmUp({read()}), std::runtime_error);
+}
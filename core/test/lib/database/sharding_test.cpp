@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+
+#include <boost/uuid/random_generator.hpp>
+
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sharding.hpp"
+
+namespace {
+// Фейковая база: запоминает, какие запросы до неё дошли
+struct FakeShard final : database::AbstractDatabase {
+  size_t executeCommand(database::Query query) final {
+    std::lock_guard lock(mutex);
+    seen.push_back(query.sql);
+    return 1;
+  }
+  std::vector<size_t> executeBatch(std::vector<database::Query> queries) final {
+    std::lock_guard lock(mutex);
+    ++batches;
+    std::vector<size_t> result;
+    for (auto &&query : queries) {
+      seen.push_back(query.sql);
+      result.push_back(query.sql.size());
+    }
+    return result;
+  }
+  database::RowFields fetchSingle(database::Query query) final {
+    std::lock_guard lock(mutex);
+    seen.push_back(query.sql);
+    if (rows.empty()) {
+      return {};
+    }
+    return rows.front();
+  }
+  std::vector<database::RowFields> fetchMultiple(database::Query query) final {
+    std::lock_guard lock(mutex);
+    seen.push_back(query.sql);
+    return rows;
+  }
+  void fetchRows(database::Query query, const RowConsumer &) final {
+    std::lock_guard lock(mutex);
+    seen.push_back(query.sql);
+  }
+  std::vector<std::vector<database::RowFields>>
+  fetchPipeline(std::vector<database::Query> queries) final {
+    std::lock_guard lock(mutex);
+    seen.push_back(queries.front().sql);
+    return {};
+  }
+
+  std::mutex mutex;
+  std::vector<std::string> seen;
+  std::vector<database::RowFields> rows;
+  size_t batches = 0;
+};
+
+struct Cluster {
+  explicit Cluster(size_t count) {
+    std::vector<database::ShardedDatabase::Shard> parts;
+    for (size_t idx = 0; idx < count; ++idx) {
+      auto shard = std::make_shared<FakeShard>();
+      shards.push_back(shard);
+      parts.push_back({.name = "db" + std::to_string(idx) + ":5432",
+                       .db = shard});
+    }
+    db = std::make_unique<database::ShardedDatabase>(std::move(parts));
+  }
+
+  std::vector<std::shared_ptr<FakeShard>> shards;
+  std::unique_ptr<database::ShardedDatabase> db;
+};
+
+database::Query forGame(std::string sql, const boost::uuids::uuid &game) {
+  return database::Query{.sql = std::move(sql), .shardKey = game};
+}
+
+std::vector<boost::uuids::uuid> games(size_t count) {
+  boost::uuids::random_generator generate;
+  std::vector<boost::uuids::uuid> result;
+  for (size_t idx = 0; idx < count; ++idx) {
+    result.push_back(generate());
+  }
+  return result;
+}
+} // namespace
+
+TEST(ShardedDatabaseTest, GameQueriesStayOnItsShard) {
+  Cluster cluster(3);
+  for (auto &&game : games(20)) {
+    auto &shard = *cluster.shards[cluster.db->shardOf(game)];
+    auto before = shard.seen.size();
+    cluster.db->executeCommand(forGame("INSERT", game));
+    cluster.db->fetchSingle(forGame("SELECT", game));
+    cluster.db->fetchPipeline({forGame("LOAD", game)});
+    EXPECT_EQ(shard.seen.size(), before + 3);
+  }
+}
+
+TEST(ShardedDatabaseTest, SpreadsGamesEvenly) {
+  Cluster cluster(4);
+  std::vector<size_t> counts(4);
+  for (auto &&game : games(4000)) {
+    ++counts[cluster.db->shardOf(game)];
+  }
+  for (auto count : counts) {
+    EXPECT_GT(count, 600);
+    EXPECT_LT(count, 1400);
+  }
+}
+
+TEST(ShardedDatabaseTest, NewShardMovesFewGames) {
+  Cluster before(4);
+  Cluster after(5);
+  size_t moved = 0;
+  auto keys = games(4000);
+  for (auto &&game : keys) {
+    // Имена первых четырёх шардов совпадают, игры либо остаются, либо
+    // уезжают на новый
+    auto was = before.db->shardOf(game);
+    auto now = after.db->shardOf(game);
+    if (was != now) {
+      EXPECT_EQ(now, 4);
+      ++moved;
+    }
+  }
+  EXPECT_GT(moved, keys.size() / 10);
+  EXPECT_LT(moved, keys.size() * 3 / 10);
+}
+
+TEST(ShardedDatabaseTest, FansOutKeylessReads) {
+  Cluster cluster(3);
+  for (size_t idx = 0; idx < cluster.shards.size(); ++idx) {
+    cluster.shards[idx]->rows = {{{"n", int32_t(idx)}}};
+  }
+  auto rows = cluster.db->fetchMultiple(database::Query{.sql = "SELECT *"});
+  EXPECT_EQ(rows.size(), 3);
+  cluster.db->fetchRows(database::Query{.sql = "SELECT *"}, {});
+  for (auto &&shard : cluster.shards) {
+    EXPECT_EQ(shard->seen.size(), 2);
+  }
+  cluster.shards[0]->rows.clear();
+  auto single = cluster.db->fetchSingle(database::Query{.sql = "SELECT 1"});
+  EXPECT_FALSE(single.empty());
+}
+
+TEST(ShardedDatabaseTest, RunsBatchOnItsShard) {
+  Cluster cluster(3);
+  auto game = games(1).front();
+  auto affected = cluster.db->executeBatch(
+      {forGame("a", game), forGame("bb", game), forGame("ccc", game)});
+  EXPECT_EQ(affected, (std::vector<size_t>{1, 2, 3}));
+  size_t batches = 0;
+  for (auto &&shard : cluster.shards) {
+    batches += shard->batches;
+  }
+  EXPECT_EQ(batches, 1);
+}
+
+TEST(ShardedDatabaseTest, RejectsCrossShardBatch) {
+  Cluster cluster(3);
+  auto keys = games(30);
+  std::vector<database::Query> queries;
+  for (auto &&key : keys) {
+    queries.push_back(forGame("x", key));
+  }
+  // Частичная фиксация хуже отказа: ни один шард пакет не получает
+  EXPECT_THROW(cluster.db->executeBatch(std::move(queries)),
+               std::invalid_argument);
+  for (auto &&shard : cluster.shards) {
+    EXPECT_EQ(shard->batches, 0);
+  }
+}
+
+TEST(ShardedDatabaseTest, WarmsUpEveryShard) {
+  Cluster cluster(3);
+  cluster.db->warmUp({forGame("LOAD", games(1).front())});
+  for (auto &&shard : cluster.shards) {
+    ASSERT_EQ(shard->seen.size(), 1);
+    EXPECT_EQ(shard->seen.front(), "LOAD");
+  }
+}
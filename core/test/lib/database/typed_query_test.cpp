@@ -0,0 +1,43 @@
+#include <boost/hana.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <gtest/gtest.h>
+
+#include "typed_query.hpp"
+
+namespace {
+struct Person {
+  BOOST_HANA_DEFINE_STRUCT(Person, (boost::uuids::uuid, person_id),
+                           (std::string, person_name), (int32_t, age));
+};
+
+using People = database::TypedTable<"people", Person>;
+
+static_assert(People::kSelect == "SELECT person_id, person_name, age FROM "
+                                 "people");
+static_assert(People::kInsert ==
+              "INSERT INTO people (person_id, person_name, age) "
+              "VALUES ($1::uuid, $2::text, $3::int4)");
+static_assert(People::kInsertOrSkip ==
+              "INSERT INTO people (person_id, person_name, age) "
+              "VALUES ($1::uuid, $2::text, $3::int4) ON CONFLICT DO NOTHING");
+static_assert(People::kSelectWhere<"person_id"> ==
+              "SELECT person_id, person_name, age FROM people "
+              "WHERE person_id = $1::uuid");
+static_assert(People::kDeleteWhere<"age"> ==
+              "DELETE FROM people WHERE age = $1::int4");
+} // namespace
+
+TEST(TypedQueryTest, BindsAllFields) {
+  Person person{.person_id = {}, .person_name = "Bob", .age = 42};
+  auto query = People::insert(person);
+  EXPECT_EQ(query.sql, People::kInsert);
+  EXPECT_EQ(query.params.size(), 3);
+  auto replayed = People::insert(person, database::OnConflict::skip);
+  EXPECT_EQ(replayed.sql, People::kInsertOrSkip);
+}
+
+TEST(TypedQueryTest, BindsFilter) {
+  auto query = People::deleteWhere<"age">(int32_t(42));
+  EXPECT_EQ(query.sql, "DELETE FROM people WHERE age = $1::int4");
+  EXPECT_EQ(query.params.size(), 1);
+}
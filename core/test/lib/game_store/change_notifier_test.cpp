@@ -0,0 +1,69 @@
+#include <boost/asio.hpp>
+#include <gtest/gtest.h>
+
+#include "change_notifier.hpp"
+#include "ids.hpp"
+
+namespace asio = boost::asio;
+using namespace std::chrono_literals;
+
+TEST(ChangeNotifierTest, NotifyWakesParkedWaiters) {
+  asio::io_context ioc;
+  core::ChangeNotifier notifier;
+  auto game = ids::generateV7();
+  bool changed = false;
+  int woken = 0;
+  for (int i = 0; i < 3; ++i) {
+    asio::co_spawn(
+        ioc,
+        [&]() -> asio::awaitable<void> {
+          if (co_await notifier.wait(game, [&] { return changed; }, 1h)) {
+            ++woken;
+          }
+        },
+        asio::detached);
+  }
+  ioc.poll();
+  EXPECT_EQ(notifier.waiting(), 3);
+
+  changed = true;
+  notifier.notify(game);
+  ioc.run_for(1s);
+  EXPECT_EQ(woken, 3);
+  EXPECT_EQ(notifier.waiting(), 0);
+}
+
+TEST(ChangeNotifierTest, TimesOutWithoutChange) {
+  asio::io_context ioc;
+  core::ChangeNotifier notifier;
+  auto game = ids::generateV7();
+  std::optional<bool> result;
+  asio::co_spawn(
+      ioc,
+      [&]() -> asio::awaitable<void> {
+        result = co_await notifier.wait(game, [] { return false; }, 10ms);
+      },
+      asio::detached);
+  // Уведомление о другой игре не будит ожидающего
+  notifier.notify(ids::generateV7());
+  ioc.run_for(1s);
+  ASSERT_TRUE(result);
+  EXPECT_FALSE(*result);
+  EXPECT_EQ(notifier.waiting(), 0);
+}
+
+TEST(ChangeNotifierTest, AlreadyChangedReturnsImmediately) {
+  asio::io_context ioc;
+  core::ChangeNotifier notifier;
+  std::optional<bool> result;
+  asio::co_spawn(
+      ioc,
+      [&]() -> asio::awaitable<void> {
+        result =
+            co_await notifier.wait(ids::generateV7(), [] { return true; }, 1h);
+      },
+      asio::detached);
+  ioc.poll();
+  ASSERT_TRUE(result);
+  EXPECT_TRUE(*result);
+}
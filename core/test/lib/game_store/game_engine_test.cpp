@@ -0,0 +1,95 @@
+#include <boost/uuid/uuid.hpp>
+#include <gtest/gtest.h>
+
+#include "game_engine.hpp"
+#include "ids.hpp"
+
+namespace {
+struct GameEngineTest : ::testing::Test {
+  // Три игрока, у каждого своя карта
+  void SetUp() override {
+    for (int i = 0; i < 3; ++i) {
+      players.push_back(game.join(ids::generateV7()).gamePlayerId);
+      cards.push_back(ids::generateV7());
+    }
+    game.takeWrites();
+  }
+
+  // Раунд, в котором все выложили карты
+  void playRound() {
+    game.startRound(players[0], cards[0], "clue");
+    game.playCard(players[1], cards[1]);
+    game.playCard(players[2], cards[2]);
+  }
+
+  boost::uuids::uuid roundCardOf(const boost::uuids::uuid &player) {
+    for (auto &&card : game.cards) {
+      if (card.gamePlayerId == player) {
+        return card.roundCardId;
+      }
+    }
+    return {};
+  }
+
+  core::GameState game{ids::generateV7()};
+  std::vector<boost::uuids::uuid> players;
+  std::vector<boost::uuids::uuid> cards;
+};
+} // namespace
+
+TEST_F(GameEngineTest, JoinAssignsColorsAndHost) {
+  ASSERT_EQ(game.players.size(), 3);
+  EXPECT_TRUE(game.players[0].isHost);
+  EXPECT_FALSE(game.players[1].isHost);
+  EXPECT_EQ(game.players[0].colorId, 1);
+  EXPECT_EQ(game.players[2].colorId, 3);
+  EXPECT_THROW(game.join(game.players[0].playerId), core::GameRuleError);
+}
+
+TEST_F(GameEngineTest, RoundPhases) {
+  EXPECT_THROW(game.startRound(players[1], cards[1], "clue"),
+               core::GameRuleError);
+  game.startRound(players[0], cards[0], "clue");
+  EXPECT_EQ(game.phase, core::GameState::Phase::playing);
+  EXPECT_THROW(game.join(ids::generateV7()), core::GameRuleError);
+  EXPECT_THROW(game.vote(players[1], roundCardOf(players[0])),
+               core::GameRuleError);
+  game.playCard(players[1], cards[1]);
+  EXPECT_THROW(game.playCard(players[1], cards[1]), core::GameRuleError);
+  game.playCard(players[2], cards[2]);
+  EXPECT_EQ(game.phase, core::GameState::Phase::voting);
+  // Старт раунда, три карты, обновление статуса игры
+  EXPECT_EQ(game.takeWrites().size(), 5);
+}
+
+TEST_F(GameEngineTest, VotingRules) {
+  playRound();
+  EXPECT_THROW(game.vote(players[0], roundCardOf(players[1])),
+               core::GameRuleError);
+  EXPECT_THROW(game.vote(players[1], roundCardOf(players[1])),
+               core::GameRuleError);
+  EXPECT_FALSE(game.vote(players[1], roundCardOf(players[0])));
+  EXPECT_THROW(game.vote(players[1], roundCardOf(players[2])),
+               core::GameRuleError);
+}
+
+TEST_F(GameEngineTest, SomeoneGuessedNarrator) {
+  playRound();
+  game.vote(players[1], roundCardOf(players[0]));
+  EXPECT_TRUE(game.vote(players[2], roundCardOf(players[1])));
+  EXPECT_EQ(game.phase, core::GameState::Phase::lobby);
+  // Ведущий и угадавший по 3, угадавшему ещё очко за голос третьего
+  EXPECT_EQ(game.players[0].score, 3);
+  EXPECT_EQ(game.players[1].score, 4);
+  EXPECT_EQ(game.players[2].score, 0);
+  EXPECT_EQ(game.nextNarrator().gamePlayerId, players[1]);
+}
+
+TEST_F(GameEngineTest, EveryoneGuessedNarrator) {
+  playRound();
+  game.vote(players[1], roundCardOf(players[0]));
+  EXPECT_TRUE(game.vote(players[2], roundCardOf(players[0])));
+  EXPECT_EQ(game.players[0].score, 0);
+  EXPECT_EQ(game.players[1].score, 2);
+  EXPECT_EQ(game.players[2].score, 2);
+}
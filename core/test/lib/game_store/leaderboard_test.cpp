@@ -0,0 +1,62 @@
+#include <boost/uuid/uuid.hpp>
+#include <gtest/gtest.h>
+
+#include "ids.hpp"
+#include "leaderboard.hpp"
+
+TEST(LeaderboardTest, SumsGamesAndRanks) {
+  core::Leaderboard leaderboard;
+  auto alice = ids::generateV7();
+  auto bob = ids::generateV7();
+  auto carol = ids::generateV7();
+  auto first = ids::generateV7();
+  auto second = ids::generateV7();
+
+  leaderboard.update(first, alice, 3);
+  leaderboard.update(first, bob, 5);
+  leaderboard.update(first, carol, 0);
+  leaderboard.update(second, alice, 4);
+
+  auto top = leaderboard.top(2);
+  ASSERT_EQ(top.size(), 2);
+  EXPECT_EQ(top[0].playerId, alice);
+  EXPECT_EQ(top[0].score, 7);
+  EXPECT_EQ(top[0].rank, 1);
+  EXPECT_EQ(top[1].playerId, bob);
+  EXPECT_EQ(leaderboard.rank(carol)->rank, 3);
+  EXPECT_FALSE(leaderboard.rank(ids::generateV7()));
+
+  // Счёт абсолютный: повтор ничего не меняет
+  leaderboard.update(second, alice, 4);
+  EXPECT_EQ(leaderboard.rank(alice)->score, 7);
+}
+
+TEST(LeaderboardTest, TiesShareRank) {
+  core::Leaderboard leaderboard;
+  auto game = ids::generateV7();
+  std::vector<boost::uuids::uuid> players;
+  for (int32_t score : {4, 2, 4, 1}) {
+    players.push_back(ids::generateV7());
+    leaderboard.update(game, players.back(), score);
+  }
+  EXPECT_EQ(leaderboard.rank(players[0])->rank, 1);
+  EXPECT_EQ(leaderboard.rank(players[2])->rank, 1);
+  EXPECT_EQ(leaderboard.rank(players[1])->rank, 3);
+  auto top = leaderboard.top(10);
+  ASSERT_EQ(top.size(), 4);
+  EXPECT_EQ(top[1].rank, 1);
+  EXPECT_EQ(top[2].rank, 3);
+  EXPECT_EQ(top[3].rank, 4);
+}
+
+TEST(LeaderboardTest, ForgetGame) {
+  core::Leaderboard leaderboard;
+  auto player = ids::generateV7();
+  auto kept = ids::generateV7();
+  auto deleted = ids::generateV7();
+  leaderboard.update(kept, player, 2);
+  leaderboard.update(deleted, player, 6);
+  leaderboard.forgetGame(deleted);
+  EXPECT_EQ(leaderboard.rank(player)->score, 2);
+  EXPECT_EQ(leaderboard.size(), 1);
+}
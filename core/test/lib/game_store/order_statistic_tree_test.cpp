@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <set>
+#include <vector>
+
+#include "order_statistic_tree.hpp"
+
+TEST(OrderStatisticTreeTest, MatchesStdSet) {
+  core::OrderStatisticTree<int> tree;
+  std::set<int> reference;
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> keys(0, 999);
+  for (int step = 0; step < 20'000; ++step) {
+    int key = keys(random);
+    if (random() % 3 == 0) {
+      EXPECT_EQ(tree.erase(key), reference.erase(key) == 1);
+    } else {
+      EXPECT_EQ(tree.insert(key), reference.insert(key).second);
+    }
+  }
+  ASSERT_EQ(tree.size(), reference.size());
+  size_t index = 0;
+  for (int key : reference) {
+    EXPECT_EQ(tree.at(index), key);
+    EXPECT_EQ(tree.rank(key), index);
+    ++index;
+  }
+  EXPECT_THROW(tree.at(tree.size()), std::out_of_range);
+}
+
+TEST(OrderStatisticTreeTest, VisitRange) {
+  core::OrderStatisticTree<int, std::greater<int>> tree;
+  for (int key = 1; key <= 10; ++key) {
+    tree.insert(key);
+  }
+  std::vector<int> visited;
+  tree.visit(2, 3, [&](int key) { visited.push_back(key); });
+  EXPECT_EQ(visited, (std::vector<int>{8, 7, 6}));
+  visited.clear();
+  tree.visit(8, 5, [&](int key) { visited.push_back(key); });
+  EXPECT_EQ(visited, (std::vector<int>{2, 1}));
+  // Ключей больше 7 — три
+  EXPECT_EQ(tree.rank(7), 3);
+}
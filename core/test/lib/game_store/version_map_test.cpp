@@ -0,0 +1,79 @@
+#include <boost/uuid/uuid.hpp>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "ids.hpp"
+#include "version_map.hpp"
+
+TEST(VersionMapTest, CreateChangesGameAndList) {
+  core::VersionMap versions;
+  auto game = ids::generateV7();
+  auto list = versions.listVersion();
+  EXPECT_FALSE(versions.gameVersion(game));
+
+  auto first = versions.create(game);
+  EXPECT_EQ(versions.gameVersion(game), first);
+  EXPECT_NE(versions.listVersion(), list);
+}
+
+TEST(VersionMapTest, TouchChangesOnlyGame) {
+  core::VersionMap versions;
+  auto game = ids::generateV7();
+  auto first = versions.create(game);
+  auto list = versions.listVersion();
+
+  auto second = versions.touch(game);
+  EXPECT_GT(second, first);
+  EXPECT_EQ(versions.gameVersion(game), second);
+  EXPECT_NE(versions.etag(first), versions.etag(second));
+  // Ход не меняет список ссылок на игры
+  EXPECT_EQ(versions.listVersion(), list);
+}
+
+TEST(VersionMapTest, RememberKeepsKnownVersion) {
+  core::VersionMap versions;
+  auto game = ids::generateV7();
+  auto list = versions.listVersion();
+  auto first = versions.remember(game);
+  EXPECT_EQ(versions.remember(game), first);
+  // Чтение из базы не меняет список
+  EXPECT_EQ(versions.listVersion(), list);
+}
+
+TEST(VersionMapTest, ForgetDropsGame) {
+  core::VersionMap versions;
+  auto game = ids::generateV7();
+  versions.create(game);
+  auto list = versions.listVersion();
+  versions.forget(game);
+  EXPECT_FALSE(versions.gameVersion(game));
+  EXPECT_NE(versions.listVersion(), list);
+}
+
+TEST(VersionMapTest, EvictsLeastRecentlyChanged) {
+  core::VersionMap versions(8);
+  std::vector<boost::uuids::uuid> games;
+  for (int i = 0; i < 8; ++i) {
+    games.push_back(ids::generateV7());
+    versions.create(games.back());
+  }
+  // Первая игра только что менялась и переживёт вытеснение
+  auto hot = versions.touch(games.front());
+  auto extra = ids::generateV7();
+  versions.create(extra);
+  EXPECT_LE(versions.size(), 8);
+  EXPECT_EQ(versions.gameVersion(games.front()), hot);
+  EXPECT_TRUE(versions.gameVersion(extra));
+  EXPECT_FALSE(versions.gameVersion(games[1]));
+  // Забытая игра получает версию новее всех выданных
+  EXPECT_GT(versions.remember(games[1]), hot);
+}
+
+TEST(VersionMapTest, EtagsDifferBetweenProcesses) {
+  core::VersionMap a;
+  core::VersionMap b;
+  EXPECT_NE(a.etag(1), b.etag(1));
+  EXPECT_EQ(a.etag(1).front(), '"');
+  EXPECT_EQ(a.etag(1).back(), '"');
+}
@@ -0,0 +1,97 @@
+#include <boost/uuid/string_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "ids.hpp"
+
+TEST(IdsTest, FormatMatchesBoost) {
+  for (int i = 0; i < 100; ++i) {
+    auto uuid = ids::generateV4();
+    EXPECT_EQ(ids::toString(uuid), boost::uuids::to_string(uuid));
+  }
+}
+
+TEST(IdsTest, AppendTo) {
+  auto uuid = boost::uuids::string_generator()(
+      "550e8400-e29b-41d4-a716-446655440000");
+  std::string url = "/games/";
+  ids::appendTo(url, uuid);
+  EXPECT_EQ(url, "/games/550e8400-e29b-41d4-a716-446655440000");
+}
+
+TEST(IdsTest, ParseRoundTrip) {
+  {
+    SCOPED_TRACE("Lower case");
+    auto uuid = ids::generateV4();
+    auto parsed = ids::parse(boost::uuids::to_string(uuid));
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(*parsed, uuid);
+  }
+  {
+    SCOPED_TRACE("Upper case");
+    auto parsed = ids::parse("550E8400-E29B-41D4-A716-446655440000");
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(ids::toString(*parsed), "550e8400-e29b-41d4-a716-446655440000");
+  }
+}
+
+TEST(IdsTest, ParseRejectsGarbage) {
+  EXPECT_FALSE(ids::parse(""));
+  EXPECT_FALSE(ids::parse("not-a-uuid"));
+  EXPECT_FALSE(ids::parse("550e8400e29b41d4a716446655440000"));
+  EXPECT_FALSE(ids::parse("550e8400-e29b-41d4-a716-44665544000g"));
+  EXPECT_FALSE(ids::parse("550e8400-e29b-41d4-a716_446655440000"));
+  EXPECT_FALSE(ids::parse("550e8400-e29b-41d4-a716-4466554400000"));
+}
+
+TEST(IdsTest, VersionBits) {
+  auto v4 = ids::generateV4();
+  EXPECT_EQ(v4.version(), boost::uuids::uuid::version_random_number_based);
+  EXPECT_EQ(v4.variant(), boost::uuids::uuid::variant_rfc_4122);
+  auto v7 = ids::generateV7();
+  EXPECT_EQ(v7.data[6] >> 4, 7);
+  EXPECT_EQ(v7.variant(), boost::uuids::uuid::variant_rfc_4122);
+}
+
+TEST(IdsTest, V7IsMonotonic) {
+  std::set<boost::uuids::uuid> seen;
+  auto previous = ids::generateV7();
+  for (int i = 0; i < 10000; ++i) {
+    auto next = ids::generateV7();
+    EXPECT_LT(previous, next);
+    EXPECT_TRUE(seen.insert(next).second);
+    previous = next;
+  }
+}
+
+TEST(IdsTest, ThreadsDoNotShareRandomStream) {
+  // У каждого потока свой генератор: одинаково засеянные генераторы дали
+  // бы одни и те же id в обоих потоках
+  constexpr int kCount = 1000;
+  auto generate = [](std::vector<boost::uuids::uuid> &out) {
+    for (int i = 0; i < kCount; ++i) {
+      out.push_back(ids::generateV4());
+    }
+  };
+  std::vector<boost::uuids::uuid> first, second;
+  std::thread(generate, std::ref(first)).join();
+  std::thread(generate, std::ref(second)).join();
+
+  std::set<boost::uuids::uuid> seen(first.begin(), first.end());
+  seen.insert(second.begin(), second.end());
+  EXPECT_EQ(seen.size(), 2 * kCount);
+  // Совпадающих байтов на тех же местах — как у независимых: 1/256
+  size_t sameBytes = 0;
+  for (int i = 0; i < kCount; ++i) {
+    for (size_t byte = 0; byte < first[i].size(); ++byte) {
+      if (byte != 6 and byte != 8) {
+        sameBytes += first[i].data[byte] == second[i].data[byte];
+      }
+    }
+  }
+  EXPECT_LT(sameBytes, 14 * kCount / 256 * 3);
+}
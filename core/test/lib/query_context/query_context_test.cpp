@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "query_context.hpp"
+
+namespace {
+using namespace std::chrono_literals;
+using database::QueryContext;
+using database::QueryWatchdog;
+} // namespace
+
+TEST(QueryContextTest, ScopesNest) {
+  EXPECT_EQ(QueryContext::current(), nullptr);
+  QueryContext outer;
+  {
+    QueryContext::Scope outerScope(outer);
+    EXPECT_EQ(QueryContext::current(), &outer);
+    QueryContext inner;
+    {
+      QueryContext::Scope innerScope(inner);
+      EXPECT_EQ(QueryContext::current(), &inner);
+    }
+    EXPECT_EQ(QueryContext::current(), &outer);
+    // Другой поток контекста не видит
+    std::thread([] { EXPECT_EQ(QueryContext::current(), nullptr); }).join();
+  }
+  EXPECT_EQ(QueryContext::current(), nullptr);
+}
+
+TEST(QueryWatchdogTest, CancelsAtDeadline) {
+  std::atomic<int> cancelled{0};
+  QueryWatchdog watchdog([&] { ++cancelled; });
+  QueryContext context{.deadline = QueryContext::Clock::now() + 20ms};
+  auto watch = watchdog.watch(context);
+  std::this_thread::sleep_for(200ms);
+  EXPECT_TRUE(watch.fired());
+  // Отмена одна, даже если запрос ещё не вернулся
+  EXPECT_EQ(cancelled, 1);
+}
+
+TEST(QueryWatchdogTest, CancelsWhenClientLeaves) {
+  std::atomic<int> cancelled{0};
+  std::atomic<bool> gone{false};
+  QueryWatchdog watchdog([&] { ++cancelled; });
+  QueryContext context{.abandoned = [&] { return gone.load(); }};
+  auto watch = watchdog.watch(context);
+  std::this_thread::sleep_for(2 * QueryWatchdog::kPollInterval);
+  EXPECT_FALSE(watch.fired());
+  gone = true;
+  std::this_thread::sleep_for(4 * QueryWatchdog::kPollInterval);
+  EXPECT_TRUE(watch.fired());
+  EXPECT_EQ(cancelled, 1);
+}
+
+TEST(QueryWatchdogTest, FinishedQueryIsNotCancelled) {
+  std::atomic<int> cancelled{0};
+  QueryWatchdog watchdog([&] { ++cancelled; });
+  QueryContext context{.deadline = QueryContext::Clock::now() + 50ms};
+  {
+    auto watch = watchdog.watch(context);
+  }
+  std::this_thread::sleep_for(150ms);
+  EXPECT_EQ(cancelled, 0);
+
+  // Следующий запрос наблюдается заново
+  QueryContext next{.deadline = QueryContext::Clock::now()};
+  auto watch = watchdog.watch(next);
+  std::this_thread::sleep_for(100ms);
+  EXPECT_TRUE(watch.fired());
+  EXPECT_EQ(cancelled, 1);
+}
@@ -0,0 +1,122 @@
+#include <boost/asio.hpp>
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <vector>
+
+#include "admission.hpp"
+
+namespace asio = boost::asio;
+using namespace std::chrono_literals;
+
+namespace {
+using Permit = core::AdmissionController::Permit;
+
+// Запускает admit() и складывает результат в @p permits
+void admit(asio::io_context &ioc, core::AdmissionController &admission,
+           std::vector<std::optional<Permit>> &permits) {
+  asio::co_spawn(
+      ioc,
+      [&]() -> asio::awaitable<void> {
+        permits.push_back(co_await admission.admit());
+      },
+      asio::detached);
+}
+} // namespace
+
+TEST(GradientLimiterTest, GrowsWhileLatencyIsStable) {
+  core::GradientLimiter limiter(10, 1, 100);
+  for (int i = 0; i < 50; ++i) {
+    limiter.sample(1ms, limiter.limit());
+  }
+  EXPECT_GT(limiter.limit(), 10);
+  EXPECT_LE(limiter.limit(), 100);
+}
+
+TEST(GradientLimiterTest, ShrinksWhenLatencyGrows) {
+  core::GradientLimiter limiter(50, 1, 100);
+  for (int i = 0; i < 100; ++i) {
+    limiter.sample(1ms, 0);
+  }
+  EXPECT_EQ(limiter.limit(), 50);
+  for (int i = 0; i < 50; ++i) {
+    limiter.sample(20ms, limiter.limit());
+  }
+  EXPECT_LT(limiter.limit(), 50);
+  EXPECT_GE(limiter.limit(), 1);
+}
+
+TEST(GradientLimiterTest, IgnoresSamplesWithoutLoad) {
+  core::GradientLimiter limiter(40, 1, 100);
+  for (int i = 0; i < 50; ++i) {
+    limiter.sample(i % 2 ? 1ms : 50ms, 5);
+  }
+  EXPECT_EQ(limiter.limit(), 40);
+}
+
+TEST(AdmissionControllerTest, QueuesThenRejects) {
+  asio::io_context ioc;
+  core::AdmissionController admission({.minLimit = 2,
+                                       .maxLimit = 2,
+                                       .initialLimit = 2,
+                                       .queueSize = 1,
+                                       .queueTimeout = 1h});
+  std::vector<std::optional<Permit>> permits;
+  for (int i = 0; i < 4; ++i) {
+    admit(ioc, admission, permits);
+  }
+  ioc.poll();
+  // Двое в работе, один в очереди, четвёртому сразу отказ
+  ASSERT_EQ(permits.size(), 3);
+  EXPECT_TRUE(permits[0] and permits[1]);
+  EXPECT_FALSE(permits[2]);
+  EXPECT_EQ(admission.inFlight(), 2);
+
+  // Завершившийся запрос отдаёт слот ожидающему
+  permits[0].reset();
+  ioc.run_for(1s);
+  ASSERT_EQ(permits.size(), 4);
+  EXPECT_TRUE(permits[3]);
+  EXPECT_EQ(admission.inFlight(), 2);
+
+  permits.clear();
+  EXPECT_EQ(admission.inFlight(), 0);
+}
+
+TEST(AdmissionControllerTest, QueuedRequestTimesOut) {
+  asio::io_context ioc;
+  core::AdmissionController admission({.minLimit = 1,
+                                       .maxLimit = 1,
+                                       .initialLimit = 1,
+                                       .queueSize = 4,
+                                       .queueTimeout = 10ms});
+  std::vector<std::optional<Permit>> permits;
+  admit(ioc, admission, permits);
+  admit(ioc, admission, permits);
+  ioc.run_for(1s);
+  ASSERT_EQ(permits.size(), 2);
+  EXPECT_TRUE(permits[0]);
+  EXPECT_FALSE(permits[1]);
+  EXPECT_EQ(admission.inFlight(), 1);
+}
+
+TEST(AdmissionControllerTest, PausesAtSessionLimit) {
+  asio::io_context ioc;
+  core::AdmissionController admission({.maxSessions = 1});
+  int entered = 0;
+  for (int i = 0; i < 2; ++i) {
+    asio::co_spawn(
+        ioc,
+        [&]() -> asio::awaitable<void> {
+          co_await admission.enterSession();
+          ++entered;
+        },
+        asio::detached);
+  }
+  ioc.poll();
+  EXPECT_EQ(entered, 1);
+  admission.leaveSession();
+  ioc.run_for(1s);
+  EXPECT_EQ(entered, 2);
+  EXPECT_EQ(admission.sessions(), 1);
+}
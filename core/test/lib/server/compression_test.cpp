@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "compression.hpp"
+
+#if defined(CORE_WITH_GZIP)
+#include <zlib.h>
+#endif
+
+using core::Encoding;
+
+TEST(CompressionTest, NegotiateIdentity) {
+  EXPECT_EQ(core::negotiateEncoding(""), Encoding::identity);
+  EXPECT_EQ(core::negotiateEncoding("br"), Encoding::identity);
+  EXPECT_EQ(core::negotiateEncoding("gzip;q=0, zstd;q=0"), Encoding::identity);
+  EXPECT_EQ(core::negotiateEncoding("*;q=0"), Encoding::identity);
+}
+
+#if defined(CORE_WITH_GZIP)
+TEST(CompressionTest, NegotiateGzip) {
+  EXPECT_EQ(core::negotiateEncoding("gzip"), Encoding::gzip);
+  EXPECT_EQ(core::negotiateEncoding("deflate, GZIP;q=0.5"), Encoding::gzip);
+  EXPECT_EQ(core::negotiateEncoding("gzip;q=0.9, zstd;q=0.1"),
+            Encoding::gzip);
+}
+
+TEST(CompressionTest, GzipRoundTrip) {
+  std::string body;
+  for (int i = 0; i < 2000; ++i) {
+    body += R"({"url":"/games/550e8400-e29b-41d4-a716-446655440000"},)";
+  }
+  // Дважды подряд: контекст потока переиспользуется
+  for (int pass = 0; pass < 2; ++pass) {
+    auto compressed = core::compress(body, Encoding::gzip, 6);
+    EXPECT_LT(compressed.size(), body.size() / 10);
+
+    z_stream stream{};
+    ASSERT_EQ(inflateInit2(&stream, 15 + 16), Z_OK);
+    std::string restored(body.size(), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(compressed.data());
+    stream.avail_in = uInt(compressed.size());
+    stream.next_out = reinterpret_cast<Bytef *>(restored.data());
+    stream.avail_out = uInt(restored.size());
+    EXPECT_EQ(inflate(&stream, Z_FINISH), Z_STREAM_END);
+    inflateEnd(&stream);
+    EXPECT_EQ(restored, body);
+  }
+}
+#endif
+
+#if defined(CORE_WITH_ZSTD)
+TEST(CompressionTest, NegotiatePrefersZstd) {
+  EXPECT_EQ(core::negotiateEncoding("gzip, zstd"), Encoding::zstd);
+  EXPECT_EQ(core::negotiateEncoding("*"), Encoding::zstd);
+}
+#endif
+
+TEST(CompressionTest, CacheEvictsLeastRecentlyUsed) {
+  core::CompressionCache cache(10);
+  cache.insert("a", std::make_shared<const std::string>("1234"));
+  cache.insert("b", std::make_shared<const std::string>("1234"));
+  // "a" свежее "b"
+  ASSERT_TRUE(cache.find("a"));
+  cache.insert("c", std::make_shared<const std::string>("1234"));
+  EXPECT_TRUE(cache.find("a"));
+  EXPECT_FALSE(cache.find("b"));
+  EXPECT_TRUE(cache.find("c"));
+
+  {
+    SCOPED_TRACE("Too large to cache");
+    cache.insert("d", std::make_shared<const std::string>(11, 'x'));
+    EXPECT_FALSE(cache.find("d"));
+  }
+  {
+    SCOPED_TRACE("Shrinking evicts");
+    cache.setCapacity(4);
+    EXPECT_TRUE(cache.find("c"));
+    EXPECT_FALSE(cache.find("a"));
+  }
+}
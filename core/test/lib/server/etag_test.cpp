@@ -0,0 +1,27 @@
+#include <gtest/gtest.h>
+
+#include "etag.hpp"
+
+TEST(EtagTest, Matches) {
+  EXPECT_TRUE(core::etagMatches(R"("a-1")", R"("a-1")"));
+  EXPECT_TRUE(core::etagMatches(R"("a-0", "a-1")", R"("a-1")"));
+  EXPECT_TRUE(core::etagMatches(R"(  "a-0" ,"a-1"  )", R"("a-1")"));
+  EXPECT_TRUE(core::etagMatches("*", R"("a-1")"));
+  EXPECT_TRUE(core::etagMatches(R"(W/"a-1")", R"("a-1")"));
+}
+
+TEST(EtagTest, DoesNotMatch) {
+  EXPECT_FALSE(core::etagMatches("", R"("a-1")"));
+  EXPECT_FALSE(core::etagMatches(R"("a-2")", R"("a-1")"));
+  EXPECT_FALSE(core::etagMatches(R"("a-1)", R"("a-1")"));
+  EXPECT_FALSE(core::etagMatches(R"("a-10", "a-11")", R"("a-1")"));
+  EXPECT_FALSE(core::etagMatches(R"("a-1")", ""));
+}
+
+TEST(EtagTest, WeakVariantOfEncodedResponse) {
+  EXPECT_EQ(core::weakEtag(R"("a-1")"), R"(W/"a-1")");
+  EXPECT_EQ(core::weakEtag(R"(W/"a-1")"), R"(W/"a-1")");
+  // Клиент со сжатым вариантом получает 304 по тегу исходного
+  EXPECT_TRUE(core::etagMatches(core::weakEtag(R"("a-1")"), R"("a-1")"));
+  EXPECT_FALSE(core::etagMatches(core::weakEtag(R"("a-1")"), R"("a-2")"));
+}
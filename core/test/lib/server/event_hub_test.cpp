@@ -0,0 +1,85 @@
+#include <boost/asio.hpp>
+#include <gtest/gtest.h>
+
+#include "event_hub.hpp"
+
+namespace asio = boost::asio;
+
+namespace {
+core::EventHub::Event receive(core::EventHub::Subscription &subscription) {
+  core::EventHub::Event received;
+  subscription.channel.try_receive(
+      [&received](boost::system::error_code ec, core::EventHub::Event event) {
+        if (!ec) {
+          received = std::move(event);
+        }
+      });
+  return received;
+}
+} // namespace
+
+TEST(EventHubTest, DeliversOnlyToTopicSubscribers) {
+  asio::io_context ioc;
+  core::EventHub hub;
+  auto first = hub.subscribe("/games/1/events", ioc.get_executor(), 4);
+  auto second = hub.subscribe("/games/1/events", ioc.get_executor(), 4);
+  auto other = hub.subscribe("/games/2/events", ioc.get_executor(), 4);
+
+  EXPECT_EQ(hub.publish("/games/1/events", "joined"), 2);
+  EXPECT_EQ(hub.publish("/games/3/events", "nobody"), 0);
+
+  auto a = receive(*first);
+  auto b = receive(*second);
+  ASSERT_TRUE(a);
+  EXPECT_EQ(*a, "joined");
+  // Событие сериализовано один раз
+  EXPECT_EQ(a, b);
+  EXPECT_FALSE(receive(*other));
+}
+
+TEST(EventHubTest, EvictsSlowConsumer) {
+  asio::io_context ioc;
+  core::EventHub hub;
+  auto slow = hub.subscribe("/t", ioc.get_executor(), 2);
+  EXPECT_EQ(hub.publish("/t", "1"), 1);
+  EXPECT_EQ(hub.publish("/t", "2"), 1);
+  EXPECT_TRUE(slow->channel.is_open());
+  EXPECT_EQ(hub.publish("/t", "3"), 0);
+  EXPECT_FALSE(slow->channel.is_open());
+}
+
+TEST(EventHubTest, Unsubscribe) {
+  asio::io_context ioc;
+  core::EventHub hub;
+  auto subscription = hub.subscribe("/t", ioc.get_executor(), 2);
+  hub.unsubscribe("/t", subscription);
+  EXPECT_EQ(hub.publish("/t", "1"), 0);
+  {
+    SCOPED_TRACE("Dropped subscriptions are skipped");
+    hub.subscribe("/t", ioc.get_executor(), 2).reset();
+    EXPECT_EQ(hub.publish("/t", "1"), 0);
+  }
+}
+
+TEST(EventHubTest, TopicOfNormalizesUuids) {
+  EXPECT_EQ(core::topicOf("/games/550E8400-E29B-41D4-A716-446655440000/events"),
+            "/games/550e8400-e29b-41d4-a716-446655440000/events");
+  EXPECT_EQ(core::topicOf("/games/events"), "/games/events");
+  EXPECT_EQ(core::topicOf("/Games/not-a-uuid/"), "/Games/not-a-uuid/");
+  EXPECT_EQ(core::topicOf(""), "");
+}
+
+TEST(EventHubTest, UppercaseSubscriberReceivesEvents) {
+  asio::io_context ioc;
+  core::EventHub hub;
+  auto subscription = hub.subscribe(
+      core::topicOf("/games/550E8400-E29B-41D4-A716-446655440000/events"),
+      ioc.get_executor(), 4);
+  // GameStore публикует по ids::toString, то есть строчными
+  EXPECT_EQ(hub.publish("/games/550e8400-e29b-41d4-a716-446655440000/events",
+                        "joined"),
+            1);
+  auto event = receive(*subscription);
+  ASSERT_TRUE(event);
+  EXPECT_EQ(*event, "joined");
+}
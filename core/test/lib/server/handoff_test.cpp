@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+#include "handoff.hpp"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+// Слушающий Unix-сокет, как у работающего сервера
+int listenUnix(const std::filesystem::path &path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, path.c_str());
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  EXPECT_EQ(::bind(fd, reinterpret_cast<sockaddr *>(&address),
+                   sizeof(address)),
+            0);
+  EXPECT_EQ(::listen(fd, 1), 0);
+  return fd;
+}
+
+uint16_t portOf(int fd) {
+  sockaddr_in address{};
+  socklen_t size = sizeof(address);
+  ::getsockname(fd, reinterpret_cast<sockaddr *>(&address), &size);
+  return ntohs(address.sin_port);
+}
+} // namespace
+
+TEST(ListenerHandoffTest, NobodyListens) {
+  auto path = std::filesystem::temp_directory_path() / "core-handoff-none";
+  std::filesystem::remove(path);
+  EXPECT_FALSE(core::ListenerHandoff::take(path));
+}
+
+TEST(ListenerHandoffTest, PassesListener) {
+  auto path = std::filesystem::temp_directory_path() /
+              ("core-handoff-" + std::to_string(::getpid()));
+  std::filesystem::remove(path);
+  int server = listenUnix(path);
+
+  int tcp = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in any{};
+  any.sin_family = AF_INET;
+  any.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(::bind(tcp, reinterpret_cast<sockaddr *>(&any), sizeof(any)), 0);
+  ASSERT_EQ(::listen(tcp, 1), 0);
+
+  std::thread predecessor([&] {
+    int channel = ::accept(server, nullptr, nullptr);
+    core::ListenerHandoff::give(channel, tcp);
+    // Дорабатывает запросы и отпускает преемника
+    ::close(channel);
+  });
+  auto handoff = core::ListenerHandoff::take(path);
+  ASSERT_TRUE(handoff);
+  handoff->waitForPredecessor();
+  predecessor.join();
+
+  // Тот же сокет под другим дескриптором
+  EXPECT_NE(handoff->listener(), tcp);
+  EXPECT_EQ(portOf(handoff->listener()), portOf(tcp));
+
+  ::close(handoff->listener());
+  ::close(tcp);
+  ::close(server);
+  std::filesystem::remove(path);
+}
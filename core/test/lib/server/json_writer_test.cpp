@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include "json_writer.hpp"
+
+TEST(JsonWriterTest, Scalars) {
+  std::string out;
+  core::JsonWriter writer(out);
+  writer.beginArray()
+      .value("str")
+      .value(int64_t(-42))
+      .value(true)
+      .value(false)
+      .null()
+      .endArray();
+  EXPECT_EQ(out, R"(["str",-42,true,false,null])");
+}
+
+TEST(JsonWriterTest, Nested) {
+  std::string out;
+  core::JsonWriter writer(out);
+  writer.beginObject().key("games").beginArray();
+  for (auto url : {"/games/1", "/games/2"}) {
+    writer.beginObject().key("url").value(url).endObject();
+  }
+  writer.endArray().key("empty").beginObject().endObject();
+  writer.key("list").beginArray().endArray().endObject();
+  EXPECT_EQ(out,
+            R"({"games":[{"url":"/games/1"},{"url":"/games/2"}],)"
+            R"("empty":{},"list":[]})");
+}
+
+TEST(JsonWriterTest, AppendsToExistingBuffer) {
+  std::string out = "prefix:";
+  core::JsonWriter(out).beginObject().key("a").value(int64_t(1)).endObject();
+  EXPECT_EQ(out, R"(prefix:{"a":1})");
+}
+
+TEST(JsonWriterTest, Escaping) {
+  std::string out;
+  core::JsonWriter writer(out);
+  writer.beginObject()
+      .key("q\"k")
+      .value("back\\slash \"quoted\"\n\t\r\b\f\x01 юникод")
+      .endObject();
+  EXPECT_EQ(out, "{\"q\\\"k\":\"back\\\\slash \\\"quoted\\\"\\n\\t\\r\\b\\f"
+                 "\\u0001 юникод\"}");
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "rate_limiter.hpp"
+
+using namespace std::chrono_literals;
+
+namespace {
+constexpr core::RateLimit kLimit{.rate = 2, .burst = 3};
+} // namespace
+
+TEST(RateLimiterTest, AllowsBurstThenRefills) {
+  core::RateLimiter limiter;
+  auto now = std::chrono::steady_clock::now();
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(limiter.take(42, kLimit, now).allowed);
+  }
+  auto denied = limiter.take(42, kLimit, now);
+  EXPECT_FALSE(denied.allowed);
+  // Два токена в секунду: следующий через полсекунды
+  EXPECT_EQ(denied.retryAfter, 500ms);
+
+  EXPECT_FALSE(limiter.take(42, kLimit, now + 400ms).allowed);
+  EXPECT_TRUE(limiter.take(42, kLimit, now + 500ms).allowed);
+  // Простой не копит токены сверх всплеска
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(limiter.take(42, kLimit, now + 1h).allowed);
+  }
+  EXPECT_FALSE(limiter.take(42, kLimit, now + 1h).allowed);
+}
+
+TEST(RateLimiterTest, ClientsHaveSeparateBuckets) {
+  core::RateLimiter limiter;
+  auto now = std::chrono::steady_clock::now();
+  core::RateLimit single{.rate = 1, .burst = 1};
+  EXPECT_TRUE(limiter.take(1, single, now).allowed);
+  EXPECT_FALSE(limiter.take(1, single, now).allowed);
+  EXPECT_TRUE(limiter.take(2, single, now).allowed);
+}
+
+TEST(RateLimiterTest, SlowRatesAccumulate) {
+  core::RateLimiter limiter;
+  auto now = std::chrono::steady_clock::now();
+  core::RateLimit slow{.rate = 0.5, .burst = 1};
+  EXPECT_TRUE(limiter.take(7, slow, now).allowed);
+  // Частые отказы не сбивают пополнение
+  for (auto at = 1ms; at < 2s; at += 1ms) {
+    EXPECT_FALSE(limiter.take(7, slow, now + at).allowed);
+  }
+  EXPECT_TRUE(limiter.take(7, slow, now + 2s).allowed);
+}
+
+TEST(RateLimiterTest, EvictsWhenFull) {
+  // Один шард на одно окно из восьми слотов
+  core::RateLimiter limiter(core::RateLimiter::kProbe, 1);
+  auto now = std::chrono::steady_clock::now();
+  core::RateLimit single{.rate = 1, .burst = 1};
+  for (uint64_t client = 1; client <= 1000; ++client) {
+    EXPECT_TRUE(limiter.take(client, single, now).allowed);
+  }
+  // Последний клиент занял слот вытесненного и помнит свою корзину
+  EXPECT_FALSE(limiter.take(1000, single, now).allowed);
+}
+
+TEST(RateLimiterTest, ParsesRules) {
+  auto rule = core::parseRateLimitRule("POST /games=5:20");
+  EXPECT_EQ(rule.method, "POST");
+  EXPECT_EQ(rule.route, "/games");
+  EXPECT_EQ(rule.limit.rate, 5);
+  EXPECT_EQ(rule.limit.burst, 20);
+
+  auto implicit = core::parseRateLimitRule("GET /games/{gameId}=0.5");
+  EXPECT_EQ(implicit.route, "/games/{gameId}");
+  EXPECT_EQ(implicit.limit.burst, 1);
+
+  EXPECT_THROW(core::parseRateLimitRule("POST /games"), std::invalid_argument);
+  EXPECT_THROW(core::parseRateLimitRule("POST /games=x"),
+               std::invalid_argument);
+  EXPECT_THROW(core::parseRateLimitRule("/games=1"), std::invalid_argument);
+}
@@ -0,0 +1,60 @@
+#include <boost/json.hpp>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "request_arena.hpp"
+
+namespace json = boost::json;
+
+TEST(RequestArenaTest, ReusesBufferAfterRelease) {
+  core::RequestArena arena(4096);
+  auto *first = arena.allocate(64, alignof(std::max_align_t));
+  arena.release();
+  auto *second = arena.allocate(64, alignof(std::max_align_t));
+  EXPECT_EQ(first, second);
+}
+
+TEST(RequestArenaTest, GrowsBeyondInitialBuffer) {
+  core::RequestArena arena(256);
+  {
+    std::pmr::vector<std::pmr::string> strings(&arena);
+    for (int i = 0; i < 100; ++i) {
+      strings.emplace_back(64, 'x');
+    }
+    EXPECT_EQ(strings.size(), 100);
+    EXPECT_EQ(strings.back(), std::pmr::string(64, 'x'));
+  }
+  arena.release();
+  EXPECT_NE(arena.allocate(1024, 1), nullptr);
+}
+
+TEST(RequestArenaTest, AllocatesAgainAfterTrim) {
+  core::RequestArena arena(256);
+  {
+    std::pmr::string text(512, 'x', &arena);
+    EXPECT_EQ(text.size(), 512);
+  }
+  // Буфер отдан: следующее выделение берёт новый
+  arena.trim();
+  arena.trim();
+  std::pmr::string text(64, 'y', &arena);
+  EXPECT_EQ(text, std::pmr::string(64, 'y'));
+}
+
+TEST(RequestArenaTest, JsonStorageFollowsResource) {
+  core::RequestArena arena;
+  auto storage = core::jsonStorage(&arena);
+  EXPECT_EQ(storage.get(), arena.jsonStorage().get());
+  EXPECT_TRUE(storage.is_deallocate_trivial());
+
+  auto value =
+      json::parse(R"({"player_id": "x", "cards": [1, 2, 3]})", storage);
+  EXPECT_EQ(value.storage().get(), storage.get());
+  EXPECT_EQ(value.at("cards").as_array().size(), 3);
+
+  // Не арена — обычная куча
+  EXPECT_EQ(core::jsonStorage(std::pmr::new_delete_resource()).get(),
+            json::storage_ptr().get());
+}
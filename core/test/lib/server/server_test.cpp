@@ -0,0 +1,140 @@
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <csignal>
+#include <stdexcept>
+#include <thread>
+
+#include "query_context.hpp"
+#include "server.hpp"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// asio, beast и http объявлены в server_iface.hpp
+namespace {
+using namespace std::chrono_literals;
+
+// Простой в десять раз короче ожидания, как 30 с против 60 с long-poll
+constexpr auto kIdle = 50ms;
+constexpr auto kWait = 500ms;
+
+// Слушающий сокет на свободном порту, как от ListenerHandoff
+int listenTcp() {
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  EXPECT_EQ(::bind(fd, reinterpret_cast<sockaddr *>(&address),
+                   sizeof(address)),
+            0);
+  EXPECT_EQ(::listen(fd, 1), 0);
+  return fd;
+}
+
+uint16_t portOf(int fd) {
+  sockaddr_in address{};
+  socklen_t size = sizeof(address);
+  ::getsockname(fd, reinterpret_cast<sockaddr *>(&address), &size);
+  return ntohs(address.sin_port);
+}
+
+http::response<http::string_body> fetch(uint16_t port, std::string target) {
+  asio::io_context ioc;
+  beast::tcp_stream stream(ioc);
+  stream.connect({asio::ip::address_v4::loopback(), port});
+  http::request<http::empty_body> req{http::verb::get, target, 11};
+  req.set(http::field::host, "localhost");
+  http::write(stream, req);
+  beast::flat_buffer buffer;
+  http::response<http::string_body> res;
+  http::read(stream, buffer, res);
+  stream.close();
+  return res;
+}
+} // namespace
+
+TEST(CoreServerTest, LongPollOutlivesIdleTimeout) {
+  auto server = std::make_shared<core::CoreServer>();
+  server->idleTimeout(kIdle);
+  server->longPoll("/slow", "wait");
+  server->getAsync(
+      "/slow",
+      [](const core::CoreServer::Request &req, const auto &)
+          -> asio::awaitable<std::optional<core::CoreServer::Response>> {
+        asio::steady_timer timer(co_await asio::this_coro::executor, kWait);
+        co_await timer.async_wait(asio::use_awaitable);
+        core::CoreServer::Response res{http::status::ok, req.version()};
+        res.body() = "changed";
+        co_return res;
+      });
+  int listener = listenTcp();
+  auto port = portOf(listener);
+  server->inherit(listener);
+  std::thread serving([&server, port] {
+    server->run({asio::ip::address_v4::loopback(), port});
+  });
+
+  asio::io_context ioc;
+  beast::tcp_stream stream(ioc);
+  stream.connect({asio::ip::address_v4::loopback(), port});
+  http::request<http::empty_body> req{http::verb::get, "/slow?wait=60", 11};
+  req.set(http::field::host, "localhost");
+  http::write(stream, req);
+  beast::flat_buffer buffer;
+  http::response<http::string_body> res;
+  beast::error_code ec;
+  http::read(stream, buffer, res, ec);
+  EXPECT_FALSE(ec) << ec.message();
+  EXPECT_EQ(res.result(), http::status::ok);
+  EXPECT_EQ(res.body(), "changed");
+  stream.close();
+
+  // Плавная остановка, как от оркестратора
+  std::raise(SIGTERM);
+  serving.join();
+}
+
+TEST(CoreServerTest, AsyncHandlerKeepsDeadlineAcrossAwait) {
+  auto server = std::make_shared<core::CoreServer>();
+  server->deadline(http::verb::get, "/slow", kIdle);
+  // Как Database: после co_await запрос к базе видит срок и отменяется
+  auto handler = [](const core::CoreServer::Request &req, const auto &)
+      -> asio::awaitable<std::optional<core::CoreServer::Response>> {
+    asio::steady_timer timer(co_await asio::this_coro::executor, kWait);
+    co_await timer.async_wait(asio::use_awaitable);
+    auto *context = database::QueryContext::current();
+    if (!context) {
+      co_return core::CoreServer::Response{http::status::ok, req.version()};
+    }
+    if (context->deadline <= database::QueryContext::Clock::now()) {
+      throw database::QueryCancelled("deadline exceeded");
+    }
+    co_return core::CoreServer::Response{http::status::no_content,
+                                         req.version()};
+  };
+  server->getAsync("/slow", handler);
+  server->getAsync(
+      "/broken",
+      [](const core::CoreServer::Request &, const auto &)
+          -> asio::awaitable<std::optional<core::CoreServer::Response>> {
+        co_await asio::post(co_await asio::this_coro::executor,
+                            asio::use_awaitable);
+        throw std::runtime_error("broken");
+      });
+  int listener = listenTcp();
+  auto port = portOf(listener);
+  server->inherit(listener);
+  std::thread serving([&server, port] {
+    server->run({asio::ip::address_v4::loopback(), port});
+  });
+
+  EXPECT_EQ(fetch(port, "/slow").result(), http::status::gateway_timeout);
+  EXPECT_EQ(fetch(port, "/broken").result(),
+            http::status::internal_server_error);
+
+  std::raise(SIGTERM);
+  serving.join();
+}
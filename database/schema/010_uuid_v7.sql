@@ -0,0 +1,28 @@
+-- UUID версии 7 (RFC 9562): 48 бит миллисекунд Unix-времени в старших байтах.
+-- Ключи растут монотонно, поэтому вставки ложатся в правый край B-дерева
+-- первичного ключа, а не размазываются по всему индексу, как gen_random_uuid().
+-- Начиная с PostgreSQL 18 есть встроенная uuidv7(), здесь совместимая замена.
+CREATE OR REPLACE FUNCTION uuid_generate_v7() RETURNS UUID AS $$
+    -- Берём случайный v4, кладём поверх первых 6 байт время и меняем версию 4 -> 7
+    SELECT encode(
+        set_bit(
+            set_bit(
+                overlay(
+                    uuid_send(gen_random_uuid())
+                    PLACING substring(
+                        int8send(floor(extract(epoch FROM clock_timestamp()) * 1000)::BIGINT)
+                        FROM 3)
+                    FROM 1 FOR 6),
+                52, 1),
+            53, 1),
+        'hex')::UUID;
+$$ LANGUAGE SQL VOLATILE;
+
+ALTER TABLE games ALTER COLUMN game_id SET DEFAULT uuid_generate_v7();
+ALTER TABLE players ALTER COLUMN player_id SET DEFAULT uuid_generate_v7();
+ALTER TABLE cards ALTER COLUMN card_id SET DEFAULT uuid_generate_v7();
+ALTER TABLE game_players ALTER COLUMN game_player_id SET DEFAULT uuid_generate_v7();
+ALTER TABLE rounds ALTER COLUMN round_id SET DEFAULT uuid_generate_v7();
+ALTER TABLE round_cards ALTER COLUMN round_card_id SET DEFAULT uuid_generate_v7();
+ALTER TABLE moves ALTER COLUMN move_id SET DEFAULT uuid_generate_v7();
+ALTER TABLE scores ALTER COLUMN score_id SET DEFAULT uuid_generate_v7();
@@ -0,0 +1,71 @@
+"""
+Сравнение первичных ключей UUIDv4 и UUIDv7 на локальном PostgreSQL.
+
+Для каждой версии создаётся временная таблица по образцу games, в неё
+пачками вставляется заданное число строк, после чего печатаются скорость
+вставки и размер индекса первичного ключа.
+
+Требует применённой миграции 010_uuid_v7.sql (функция uuid_generate_v7).
+"""
+
+import argparse
+import asyncio
+import time
+
+import asyncpg
+
+from handle import DataBaseHandle
+
+GENERATORS = {
+    "v4": "gen_random_uuid()",
+    "v7": "uuid_generate_v7()",
+}
+
+
+class UuidBenchmark(DataBaseHandle):
+    async def run_one(self, conn, version, rows, batch):
+        table = f"uuid_bench_{version}"
+        await conn.execute(f"DROP TABLE IF EXISTS {table}")
+        await conn.execute(
+            f"""
+            CREATE TABLE {table} (
+                game_id UUID PRIMARY KEY DEFAULT {GENERATORS[version]},
+                status_id INT NOT NULL,
+                created_at TIMESTAMP NOT NULL DEFAULT NOW()
+            )
+            """
+        )
+        started = time.perf_counter()
+        inserted = 0
+        while inserted < rows:
+            count = min(batch, rows - inserted)
+            await conn.execute(
+                f"INSERT INTO {table} (status_id) SELECT 1 FROM generate_series(1, $1)",
+                count,
+            )
+            inserted += count
+        elapsed = time.perf_counter() - started
+        index_size = await conn.fetchval(
+            "SELECT pg_relation_size($1::regclass)", f"{table}_pkey"
+        )
+        await conn.execute(f"DROP TABLE {table}")
+        return rows / elapsed, index_size
+
+    async def run(self, rows, batch):
+        conn = await asyncpg.connect(self.db_url)
+        try:
+            print(f"{'version':>8} {'rows/s':>12} {'pkey size, MiB':>16}")
+            for version in GENERATORS:
+                rate, index_size = await self.run_one(conn, version, rows, batch)
+                print(f"{version:>8} {rate:>12.0f} {index_size / 2**20:>16.1f}")
+        finally:
+            await conn.close()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="UUIDv4 vs UUIDv7 primary keys")
+    parser.add_argument("--rows", type=int, default=1_000_000)
+    parser.add_argument("--batch", type=int, default=10_000)
+    args = parser.parse_args()
+
+    asyncio.run(UuidBenchmark().run(args.rows, args.batch))